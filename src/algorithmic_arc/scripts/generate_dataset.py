@@ -0,0 +1,46 @@
+import argparse
+from pathlib import Path
+
+from ca_simulations import generate_dataset, load_dataset, export_dataset_json
+
+# === 1. Parse options ===
+parser = argparse.ArgumentParser(description="Generate Algorithmic-ARC tasks in bulk with the native generator.")
+parser.add_argument("--num-tasks", type=int, default=100_000)
+parser.add_argument("--num-train", type=int, default=4)
+parser.add_argument("--num-test", type=int, default=1)
+parser.add_argument("--transformation", choices=["ca_rule", "bit_inversion"], default="ca_rule")
+parser.add_argument("--depth", type=int, default=1, help="CA steps from input to output (ca_rule only)")
+parser.add_argument("--seed", type=int, default=42)
+parser.add_argument("--boundary-mode", type=int, choices=[0, 1], default=1)
+parser.add_argument("--threads", type=int, default=0, help="0 = all cores")
+parser.add_argument("--output", type=Path, default=None, help="Binary dataset path")
+parser.add_argument("--export-json", type=int, default=0, help="Also export the first N tasks as JSON")
+args = parser.parse_args()
+
+# === 2. Resolve output paths relative to this script ===
+data_dir = Path(__file__).parent.parent / "data"
+output = args.output or data_dir / f"{args.transformation}_{args.seed}.aarc"
+output.parent.mkdir(parents=True, exist_ok=True)
+
+# === 3. Generate the binary dataset ===
+generate_dataset(
+    output,
+    num_tasks=args.num_tasks,
+    num_train=args.num_train,
+    num_test=args.num_test,
+    transformation=args.transformation,
+    depth=args.depth,
+    seed=args.seed,
+    boundary_mode=args.boundary_mode,
+    num_threads=args.threads
+)
+
+dataset = load_dataset(output, decode=False)
+print(f"✅ Generated {len(dataset['rules'])} tasks → {output}")
+print(f"   metadata: {dataset['metadata']}")
+
+# === 4. Optionally export JSON tasks in the builder's format ===
+if args.export_json > 0:
+    json_dir = data_dir / "generated"
+    written = export_dataset_json(output, json_dir, first_task=0, count=args.export_json)
+    print(f"✅ Exported {written} JSON tasks → {json_dir}")
@@ -1,15 +1,19 @@
 import numpy as np
 import math
 
-from ca_simulations import simulate_rule_matches
-from ca_simulations import simulate_rule_outputs
-from collections import defaultdict
+from ca_simulations import CASession, states_to_matrices
+from ca_simulations import AbductionState
+from ca_simulations import score_rules_bdm, top_k_by_score
+from ca_simulations import lookup_ctm_4x4, filter_by_ctm_4x4
+from ca_simulations import rule_equivalence_classes
+from collections import Counter, defaultdict, deque
 from pybdm import BDM
 
 class AlgorithmicAbductionInduction:
     bdm_1d = BDM(ndim=1)
 
-    def __init__(self, num_rules=1_000_000, top_k=None, seed=42, boundary_mode=1, max_steps=65536, verbose=True):
+    def __init__(self, num_rules=1_000_000, top_k=None, seed=42, boundary_mode=1, max_steps=65536, verbose=True,
+                 collapse_rules=False):
         """
         Abduction–Induction method using cellular automata and algorithmic complexity.
 
@@ -20,6 +24,8 @@ class AlgorithmicAbductionInduction:
             boundary_mode (int): 1 = toroidal, 0 = zero-padded
             max_steps (int): Max steps per CA simulation
             verbose (bool): Whether to print detailed logs
+            collapse_rules (bool): Simulate one representative per class of rules that read the
+                                   same table bits on the training inputs and x_test (same results)
         """
         self.num_rules = num_rules
         self.top_k = top_k
@@ -27,7 +33,23 @@ class AlgorithmicAbductionInduction:
         self.boundary_mode = boundary_mode
         self.max_steps = max_steps
         self.verbose = verbose
+        self.collapse_rules = collapse_rules
         self.abducted_rules = None
+        self._session = None
+        self._abduction = None
+        self._abduction_keys = []
+
+    @property
+    def session(self):
+        # Rule bank, scratch buffers and threads are built once and reused by every run().
+        if self._session is None:
+            self._session = CASession(
+                num_rules=self.num_rules,
+                seed=self.seed,
+                boundary_mode=self.boundary_mode,
+                max_steps=self.max_steps
+            )
+        return self._session
 
     def _log(self, msg):
         if self.verbose:
@@ -35,28 +57,15 @@ class AlgorithmicAbductionInduction:
 
     # -------------------- Filtering Phase --------------------
     def filter_by_ctm_input(self, xs, ys, x_test, mode='absolute', threshold=2.0):
-        bdm_2d = BDM(ndim=2, shape=(4, 4))
-        key_test, c_test = next(bdm_2d.lookup([x_test]))
-        self._log(f"[Filter] x_test complexity: {c_test:.2f} (key: {key_test})")
+        if mode not in ('absolute', 'percent'):
+            raise ValueError("mode must be 'absolute' or 'percent'")
 
-        filtered_xs, filtered_ys = [], []
+        c_test = lookup_ctm_4x4([x_test])[0]
+        self._log(f"[Filter] x_test complexity: {c_test:.2f}")
 
-        for x_i, y_i in zip(xs, ys):
-            try:
-                _, c_i = next(bdm_2d.lookup([x_i]))
-            except Exception:
-                continue
-
-            if mode == 'absolute':
-                if abs(c_i - c_test) <= threshold:
-                    filtered_xs.append(x_i)
-                    filtered_ys.append(y_i)
-            elif mode == 'percent':
-                if abs(c_i - c_test) / c_test <= threshold:
-                    filtered_xs.append(x_i)
-                    filtered_ys.append(y_i)
-            else:
-                raise ValueError("mode must be 'absolute' or 'percent'")
+        keep = filter_by_ctm_4x4(xs, x_test, mode=mode, threshold=threshold)
+        filtered_xs = [x_i for x_i, k in zip(xs, keep) if k]
+        filtered_ys = [y_i for y_i, k in zip(ys, keep) if k]
 
         self._log(f"[Filter] Retaining {len(filtered_xs)} / {len(xs)} training examples (mode={mode}, threshold={threshold})")
         if len(filtered_xs) == 0:
@@ -65,47 +74,64 @@ class AlgorithmicAbductionInduction:
         return np.array(filtered_xs, dtype=np.uint8), np.array(filtered_ys, dtype=np.uint8)
 
     # -------------------- Abduction Phase --------------------
+    @property
+    def abduction(self):
+        # Survivors persist across abduct_rules() calls; only changed pairs are simulated.
+        if self._abduction is None:
+            self._abduction = AbductionState(self.session)
+        return self._abduction
+
     def abduct_rules(self, xs, ys):
         self._log(f"[Abduction] Searching for CA rules matching {len(xs)} training pairs...")
 
-        results = simulate_rule_matches(
-            xs,
-            ys,
-            num_rules=self.num_rules,
-            seed=self.seed,
-            boundary_mode=self.boundary_mode,
-            max_steps=self.max_steps
-        )
-
-        rule_sets = []
-        for matches in results:
-            matched_rules = {rule_int for rule_int, _ in matches}
-            rule_sets.append(matched_rules)
+        if len(xs) == 0:
+            self.abducted_rules = []
+            return {}
 
-        common_rules = set.intersection(*rule_sets) if rule_sets else set()
+        state = self.abduction
+        wanted = [(self._matrix_to_key(x), self._matrix_to_key(y)) for x, y in zip(xs, ys)]
 
-        rule_to_matches = defaultdict(list)
-        for i, matches in enumerate(results):
-            for rule_int, depth in matches:
-                if rule_int in common_rules:
-                    rule_to_matches[rule_int].append((i, depth))
-
-        self.abducted_rules = list(common_rules)
+        # Drop pairs no longer requested, then add the new ones.
+        pending = Counter(wanted)
+        keys = self._abduction_keys
+        for j in reversed(range(len(keys))):
+            if pending[keys[j]] > 0:
+                pending[keys[j]] -= 1
+            else:
+                state.remove_pair(j)
+                del keys[j]
+        for x, y, key in zip(xs, ys, wanted):
+            if pending[key] > 0:
+                state.add_pair(x, y)
+                keys.append(key)
+                pending[key] -= 1
+
+        # State pair j -> position of that pair in xs.
+        positions = defaultdict(deque)
+        for i, key in enumerate(wanted):
+            positions[key].append(i)
+        pair_of = [positions[key].popleft() for key in keys]
+        order = np.argsort(pair_of, kind='stable')
+
+        indices, depths = state.survivors()
+        rule_to_matches = {}
+        for index, row in zip(indices.tolist(), depths.tolist()):
+            rule_to_matches[self.session.rule_number(index)] = [(pair_of[j], row[j]) for j in order]
+
+        self.abducted_rules = list(rule_to_matches)
         self._log(f"[Abduction] Found {len(self.abducted_rules)} rules that match all training pairs.")
 
         return rule_to_matches
 
     # -------------------- Ranking Phase --------------------
-    def rank_abducted_rules_by_bdm(self, rules):
+    def rank_abducted_rules_by_bdm(self, rules, top_k=None):
         self._log(f"[Ranking] Ranking {len(rules)} rules by BDM complexity...")
 
-        scored = []
-        for rule_int in rules:
-            rule_arr = self.rule_to_1d_array(rule_int)
-            bdm_score = self.bdm_1d.bdm(rule_arr)
-            scored.append((rule_int, bdm_score))
+        rules = list(rules)
+        scores = score_rules_bdm(rules)
+        order = top_k_by_score(scores, top_k)
 
-        ranked = sorted(scored, key=lambda t: t[1])
+        ranked = [(rules[i], float(scores[i])) for i in order]
 
         for i, (rule, score) in enumerate(ranked[:5]):
             self._log(f"  Top {i+1}: Rule {rule} → BDM = {score:.2f}")
@@ -118,36 +144,57 @@ class AlgorithmicAbductionInduction:
         return np.array([int(b) for b in bin_str], dtype=int)
 
     # -------------------- Induction Phase --------------------
-    def induce_outputs_from_rules(self, x_test, rules):
-        self._log(f"[Induction] Applying {len(rules)} rules to x_test...")
+    def collapse_rule_classes(self, rules, xs, x_test):
+        """
+        Group rules that read the same table bits (and agree on them) from the training
+        inputs and x_test. Returns (representatives, members), members[c] listing the
+        rules represented by representatives[c].
+        """
+        rules = list(rules)
+        if not rules:
+            return [], []
+
+        starts = np.concatenate([np.asarray(xs, dtype=np.uint8).reshape(-1, 4, 4), x_test.reshape(1, 4, 4)])
+        class_of, representatives, _ = rule_equivalence_classes(
+            rules,
+            starts,
+            boundary_mode=self.boundary_mode,
+            max_steps=self.max_steps
+        )
 
-        results = {}
+        members = [[] for _ in representatives]
+        for rule, c in zip(rules, class_of):
+            members[c].append(rule)
 
-        for rule_int in rules:
-            rule_parts = [(rule_int >> (64 * i)) & ((1 << 64) - 1) for i in range(8)]
-            rules_flat = np.array(rule_parts, dtype=np.uint64).reshape(1, 8)
+        self._log(f"[Classes] {len(rules)} rules collapse into {len(representatives)} equivalence classes.")
+        return [rules[i] for i in representatives], members
 
-            simulation = simulate_rule_outputs(
-                x=x_test,
-                rules=rules_flat,
-                boundary_mode=self.boundary_mode,
-                max_steps=self.max_steps
-            )
+    def induce_outputs_from_rules(self, x_test, rules, members=None):
+        """
+        members (optional): per rule, the rules it stands for (see collapse_rule_classes);
+        every output then counts once per member.
+        """
+        self._log(f"[Induction] Applying {len(rules)} rules to x_test...")
 
-            rule_number, outputs = simulation[0]
+        rules = list(rules)
+        results = {}
 
-            for matrix, depth in outputs:
+        # Outputs arrive in chunks while later rules are still being simulated.
+        for chunk in self.session.stream_outputs(x_test, rules):
+            matrices = states_to_matrices(chunk['state'])
+            for r, depth, matrix in zip(chunk['rule_index'].tolist(), chunk['depth'].tolist(), matrices):
+                represented = [rules[r]] if members is None else members[r]
                 y_key = self._matrix_to_key(matrix)
                 if y_key not in results:
                     results[y_key] = {
-                        'rules': [rule_number],
-                        'depths': [depth],
+                        'rules': list(represented),
+                        'depths': [depth] * len(represented),
                         't_min': depth,
                         'matrix': matrix
                     }
                 else:
-                    results[y_key]['rules'].append(rule_number)
-                    results[y_key]['depths'].append(depth)
+                    results[y_key]['rules'].extend(represented)
+                    results[y_key]['depths'].extend([depth] * len(represented))
                     results[y_key]['t_min'] = min(results[y_key]['t_min'], depth)
 
         for y_key, meta in results.items():
@@ -231,12 +278,16 @@ class AlgorithmicAbductionInduction:
         rule_matches = self.abduct_rules(xs, ys)
 
         if self.top_k is not None:
-            ranked = self.rank_abducted_rules_by_bdm(list(rule_matches.keys()))
-            top_rules = [r for r, _ in ranked[:self.top_k]]
+            ranked = self.rank_abducted_rules_by_bdm(list(rule_matches.keys()), top_k=self.top_k)
+            top_rules = [r for r, _ in ranked]
         else:
             top_rules = list(rule_matches.keys())
 
-        y_prime_data = self.induce_outputs_from_rules(x_test, top_rules)
+        if self.collapse_rules:
+            representatives, members = self.collapse_rule_classes(top_rules, xs, x_test)
+            y_prime_data = self.induce_outputs_from_rules(x_test, representatives, members=members)
+        else:
+            y_prime_data = self.induce_outputs_from_rules(x_test, top_rules)
         k_ctm_scores = self.estimate_k_ctm(y_prime_data, total_rules=self.num_rules)
         best_output, _ = self.select_inductive_hypothesis(k_ctm_scores)
 
@@ -1,2 +1,16 @@
 from .lib.ca_simulations.ca_bindings.simulate_rule_matches_wrapper import simulate_rule_matches
-from .lib.ca_simulations.ca_bindings.simulate_rule_outputs_wrapper import simulate_rule_outputs
\ No newline at end of file
+from .lib.ca_simulations.ca_bindings.simulate_rule_outputs_wrapper import simulate_rule_outputs
+from .lib.ca_simulations.ca_bindings.simulate_kstate_rules_wrapper import simulate_kstate_matches, simulate_kstate_outputs
+from .lib.ca_simulations.ca_bindings.enumerate_rule_matches_wrapper import enumerate_rule_matches, enumerate_rule_ctm
+from .lib.ca_simulations.ca_bindings.bdm_scoring_wrapper import score_rules_bdm, top_k_by_score
+from .lib.ca_simulations.ca_bindings.ctm_table_4x4_wrapper import lookup_ctm_4x4, filter_by_ctm_4x4
+from .lib.ca_simulations.ca_bindings.dataset_generator_wrapper import generate_dataset, load_dataset, export_dataset_json
+from .lib.ca_simulations.ca_bindings.ca_session_wrapper import CASession, states_to_matrices
+from .lib.ca_simulations.ca_bindings.stratified_rule_ctm_wrapper import stratified_rule_ctm
+from .lib.ca_simulations.ca_bindings.task_runner_wrapper import run_task_directory
+from .lib.ca_simulations.ca_bindings.rule_classes_wrapper import rule_equivalence_classes
+from .lib.ca_simulations.ca_bindings.ctm_server_wrapper import CTMServer, ctm_client_query
+from .lib.ca_simulations.ca_bindings.preimage_ctm_wrapper import preimage_ctm
+from .lib.ca_simulations.ca_bindings.rule_bank_wrapper import RuleBank
+from .lib.ca_simulations.ca_bindings.abduction_state_wrapper import AbductionState
+from .lib.ca_simulations.ca_bindings.trajectory_cycles_wrapper import Trajectories
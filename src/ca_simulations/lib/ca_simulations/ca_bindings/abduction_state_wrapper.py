@@ -0,0 +1,144 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations (the session is passed as an opaque CASession*)
+ffi.cdef("""
+    typedef struct AbductionState AbductionState;
+
+    AbductionState* abduction_state_create(void* session);
+    void abduction_state_destroy(AbductionState* state);
+
+    int abduction_state_add_pair(AbductionState* state, const uint32_t* x_flat, const uint32_t* y_flat);
+    int abduction_state_remove_pair(AbductionState* state, int pair);
+    int abduction_state_num_pairs(const AbductionState* state);
+    int abduction_state_num_survivors(const AbductionState* state);
+    void abduction_state_survivors(const AbductionState* state, uint32_t* indices_out, int32_t* depths_out);
+    void abduction_state_pairs(const AbductionState* state, uint32_t* xs_flat_out, uint32_t* ys_flat_out);
+
+    int abduction_state_save(const AbductionState* state, const char* path);
+    int abduction_state_peek(const char* path, unsigned int* seed, int* num_rules, int* boundary_mode, int* max_steps, int* family);
+    AbductionState* abduction_state_load(void* session, const char* path);
+""")
+
+# RULE_FAMILY_* ids, named as CASession's family argument
+_FAMILY_NAMES = {0: 'full', 1: 'totalistic', 2: 'outer_totalistic', 3: 'symmetric'}
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def _flat(matrix):
+    matrix = np.asarray(matrix)
+    assert matrix.shape == (4, 4), "Matrix must be 4×4"
+    return np.ascontiguousarray(matrix.flatten(), dtype=np.uint32)
+
+
+class AbductionState:
+    """
+    Incremental abduction over a CASession's rule bank (see abduction_state.h): the
+    bank rules that reach y from x on every training pair added so far.
+
+    Adding a pair simulates only the current survivors; removing a pair simulates
+    only the rules it had rejected. The state can be saved and reloaded.
+
+        state = AbductionState(session)
+        for x, y in zip(xs, ys):
+            state.add_pair(x, y)
+        rules = state.rules()
+    """
+
+    def __init__(self, session, _state=None):
+        self.session = session
+        state = _state if _state is not None else C.abduction_state_create(ffi.cast("void*", session._session))
+        self._state = ffi.gc(state, C.abduction_state_destroy)
+
+    @staticmethod
+    def peek(path):
+        """Session parameters a state file was saved under (to create a matching CASession)."""
+        params = ffi.new("unsigned int*"), ffi.new("int*"), ffi.new("int*"), ffi.new("int*"), ffi.new("int*")
+        if C.abduction_state_peek(os.fsencode(os.path.abspath(path)), *params) != 0:
+            raise ValueError(f"Not an abduction state file: {path}")
+        values = dict(zip(('seed', 'num_rules', 'boundary_mode', 'max_steps', 'family'), (p[0] for p in params)))
+        values['family'] = _FAMILY_NAMES[values['family']]
+        return values
+
+    @classmethod
+    def load(cls, path, session):
+        """
+        Reload a saved state into a session with the parameters it was saved under:
+
+            state = AbductionState.load(path, CASession(**AbductionState.peek(path)))
+        """
+        state = C.abduction_state_load(ffi.cast("void*", session._session), os.fsencode(os.path.abspath(path)))
+        if state == ffi.NULL:
+            raise ValueError("State file is unreadable or was saved under other session parameters")
+        return cls(session, state)
+
+    def save(self, path):
+        if C.abduction_state_save(self._state, os.fsencode(os.path.abspath(path))) != 0:
+            raise OSError(f"Could not write abduction state: {path}")
+
+    def add_pair(self, x, y):
+        """Add a training pair; returns the number of surviving rules."""
+        x_flat, y_flat = _flat(x), _flat(y)
+        return C.abduction_state_add_pair(
+            self._state,
+            ffi.cast("uint32_t*", x_flat.ctypes.data),
+            ffi.cast("uint32_t*", y_flat.ctypes.data)
+        )
+
+    def remove_pair(self, index):
+        """Remove the index-th pair (insertion order); returns the number of surviving rules."""
+        survivors = C.abduction_state_remove_pair(self._state, index)
+        if survivors < 0:
+            raise IndexError(f"No training pair {index}")
+        return survivors
+
+    @property
+    def num_pairs(self):
+        return C.abduction_state_num_pairs(self._state)
+
+    def __len__(self):
+        return C.abduction_state_num_survivors(self._state)
+
+    def pairs(self):
+        """The training pairs in insertion order, as (xs, ys) arrays of shape (n, 4, 4)."""
+        n = self.num_pairs
+        xs_flat = np.zeros((n, 16), dtype=np.uint32)
+        ys_flat = np.zeros((n, 16), dtype=np.uint32)
+        C.abduction_state_pairs(
+            self._state,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data)
+        )
+        return xs_flat.astype(np.uint8).reshape(n, 4, 4), ys_flat.astype(np.uint8).reshape(n, 4, 4)
+
+    def survivors(self):
+        """
+        Returns:
+            (indices, depths): ascending bank indices (uint32) of the surviving rules and
+            their depth on every pair (num_survivors × num_pairs int32).
+        """
+        n, num_pairs = len(self), self.num_pairs
+        indices = np.zeros(n, dtype=np.uint32)
+        depths = np.zeros((n, num_pairs), dtype=np.int32)
+        C.abduction_state_survivors(
+            self._state,
+            ffi.cast("uint32_t*", indices.ctypes.data),
+            ffi.cast("int32_t*", depths.ctypes.data) if num_pairs else ffi.NULL
+        )
+        return indices, depths
+
+    def rules(self):
+        """The surviving rules as 512-bit ints, in bank order."""
+        indices, _ = self.survivors()
+        return [self.session.rule_number(int(i)) for i in indices]
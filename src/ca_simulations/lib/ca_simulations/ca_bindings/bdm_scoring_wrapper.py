@@ -0,0 +1,123 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# === C Declarations ===
+ffi.cdef("""
+    void bdm_score_rules(
+        const uint64_t* rules_flat,
+        int num_rules,
+        const double* ctm_table,
+        int num_threads,
+        double* scores_out
+    );
+
+    int bdm_top_k(const double* scores, int num_rules, int k, int* indices_out);
+""")
+
+BDM_BLOCK_BITS = 12
+BDM_BYTE_ORDER = 0x01020304  # bdm_scoring.h; files are in host byte order
+
+# === Load shared library ===
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+build_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build'))
+lib_path = os.path.join(build_dir, lib_name)
+C = ffi.dlopen(lib_path)
+
+# CTM table cache, in the format read by bdm_load_ctm_table
+ctm_table_path = os.path.join(build_dir, 'bdm_ctm_d12.bin')
+_ctm_table = None
+
+
+def build_ctm_table():
+    """
+    Look up every 12-bit block once with pybdm's 1D CTM dataset (CTM-B2-D12).
+    Index v holds the CTM value of the block whose first symbol is the MSB of v.
+    """
+    from pybdm import BDM
+
+    bdm = BDM(ndim=1)
+    table = np.empty(1 << BDM_BLOCK_BITS, dtype=np.float64)
+    for v in range(1 << BDM_BLOCK_BITS):
+        block = np.array([(v >> (BDM_BLOCK_BITS - 1 - i)) & 1 for i in range(BDM_BLOCK_BITS)], dtype=int)
+        _, table[v] = next(bdm.lookup([block]))
+    return table
+
+
+def load_ctm_table(path=ctm_table_path):
+    """
+    Load the cached CTM table, building and saving it on first use.
+    """
+    global _ctm_table
+    if _ctm_table is not None and path == ctm_table_path:
+        return _ctm_table
+
+    if os.path.exists(path):
+        with open(path, 'rb') as f:
+            assert f.read(4) == b'BDM2', f"{path} is not a BDM table"
+            block_bits, byte_order = np.frombuffer(f.read(8), dtype='=u4')
+            assert block_bits == BDM_BLOCK_BITS, f"Unexpected block length {block_bits}"
+            assert byte_order == BDM_BYTE_ORDER, f"{path} was written on a host of the other byte order"
+            table = np.frombuffer(f.read(), dtype='=f8').copy()
+    else:
+        table = build_ctm_table()
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        with open(path, 'wb') as f:
+            f.write(b'BDM2')
+            f.write(np.array([BDM_BLOCK_BITS, BDM_BYTE_ORDER], dtype='=u4').tobytes())
+            f.write(table.astype('=f8').tobytes())
+
+    if path == ctm_table_path:
+        _ctm_table = table
+    return table
+
+
+def rules_to_flat(rules):
+    """
+    Convert 512-bit rule ints (or an (N, 8) uint64 array) to the compute_rule_number layout.
+    """
+    if isinstance(rules, np.ndarray) and rules.dtype == np.uint64:
+        return np.ascontiguousarray(rules.reshape(-1, 8))
+
+    mask = (1 << 64) - 1
+    return np.array([[(int(r) >> (64 * k)) & mask for k in range(8)] for r in rules],
+                    dtype=np.uint64).reshape(-1, 8)
+
+
+def score_rules_bdm(rules, num_threads=0):
+    """
+    Native batch equivalent of BDM(ndim=1).bdm(rule_to_1d_array(rule)) for every rule.
+    """
+    rules_flat = rules_to_flat(rules)
+    table = np.ascontiguousarray(load_ctm_table(), dtype=np.float64)
+    scores = np.empty(len(rules_flat), dtype=np.float64)
+
+    C.bdm_score_rules(
+        ffi.cast("uint64_t*", rules_flat.ctypes.data),
+        len(rules_flat),
+        ffi.cast("double*", table.ctypes.data),
+        num_threads,
+        ffi.cast("double*", scores.ctypes.data)
+    )
+    return scores
+
+
+def top_k_by_score(scores, k=None):
+    """
+    Indices of the k lowest scores in ascending order; ties keep input order.
+    """
+    scores = np.ascontiguousarray(scores, dtype=np.float64)
+    k = len(scores) if k is None else min(k, len(scores))
+    indices = np.empty(max(k, 0), dtype=np.int32)
+
+    n = C.bdm_top_k(
+        ffi.cast("double*", scores.ctypes.data),
+        len(scores),
+        k,
+        ffi.cast("int*", indices.ctypes.data)
+    )
+    return indices[:n]
@@ -0,0 +1,374 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    typedef struct {
+        uint64_t rule_number[8];
+        uint8_t (*outputs)[4][4];
+        int* depths;
+        int num_outputs;
+    } OutputMap;
+
+    typedef struct {
+        unsigned int seed;
+        int num_rules;
+        int boundary_mode;
+        int max_steps;
+        void* rules;
+        uint64_t* rule_numbers;
+        void* pool;
+        void** scratch;
+        uint16_t** trails;
+        int family;
+    } CASession;
+
+    CASession* ca_session_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads);
+    CASession* ca_session_create_in_family(unsigned int seed, int num_rules, int family, int boundary_mode, int max_steps, int num_threads);
+    void ca_session_destroy(CASession* session);
+
+    void ca_session_matches(
+        CASession* session,
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int** match_rule_indices,
+        int** match_rule_depths,
+        int* match_counts
+    );
+
+    void ca_session_free_matches(
+        int num_pairs,
+        int** match_rule_indices,
+        int** match_rule_depths
+    );
+
+    void ca_session_ctm(
+        CASession* session,
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int* match_counts,
+        int* min_depths
+    );
+
+    void ca_session_outputs(
+        CASession* session,
+        uint32_t* x_flat,
+        int* rule_indices,
+        int num_indices,
+        OutputMap** output_maps_out
+    );
+
+    void ca_session_outputs_for_rules(
+        CASession* session,
+        uint32_t* x_flat,
+        uint64_t* rules_flat,
+        int num_rules,
+        OutputMap** output_maps_out
+    );
+
+    void free_output_maps(
+        int num_rules,
+        OutputMap* output_maps
+    );
+
+    typedef struct ResultStream ResultStream;
+
+    ResultStream* result_stream_matches(
+        CASession* session,
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int chunk_records,
+        int num_chunks
+    );
+
+    ResultStream* result_stream_outputs(
+        CASession* session,
+        uint32_t* x_flat,
+        uint64_t* rules_flat,
+        int num_rules,
+        int chunk_records,
+        int num_chunks
+    );
+
+    int result_stream_next(ResultStream* stream, void* buffer);
+    void result_stream_close(ResultStream* stream);
+""")
+
+# Binary rule families a bank can be sampled from (see RULE_FAMILY_* in ca_dynamics.h)
+SAMPLING_FAMILIES = {'full': 0, 'totalistic': 1, 'outer_totalistic': 2, 'symmetric': 3}
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+# Record layouts of StreamMatch / StreamOutput (result_stream.h)
+# (rule numbers are not repeated per record: index the bank or the rules passed in)
+MATCH_RECORD = np.dtype([
+    ('rule_index', '<i4'),
+    ('pair', '<i4'),
+    ('depth', '<i4'),
+])
+
+OUTPUT_RECORD = np.dtype([
+    ('rule_index', '<i4'),
+    ('depth', '<i4'),
+    ('state', '<u2'),
+    ('reserved', '<u2'),
+])
+
+
+def states_to_matrices(states):
+    """Decode matrix_hash keys (cell (0,0) is bit 15) into an (n, 4, 4) uint8 array."""
+    states = np.asarray(states, dtype=np.uint16)
+    shifts = np.arange(15, -1, -1, dtype=np.uint16)
+    return ((states[:, None] >> shifts) & 1).astype(np.uint8).reshape(-1, 4, 4)
+
+
+def _flatten_pairs(xs, ys):
+    assert xs.shape == ys.shape
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+
+    num_pairs = len(xs)
+    xs_flat = np.ascontiguousarray(xs.reshape(num_pairs, 16), dtype=np.uint32)
+    ys_flat = np.ascontiguousarray(ys.reshape(num_pairs, 16), dtype=np.uint32)
+    return num_pairs, xs_flat, ys_flat
+
+
+def _decode_output_maps(output_maps, count):
+    results = []
+    for r in range(count):
+        rule_struct = output_maps[r]
+        rule_number = sum(int(rule_struct.rule_number[k]) << (64 * k) for k in range(8))
+
+        outputs = []
+        for i in range(rule_struct.num_outputs):
+            matrix = np.frombuffer(ffi.buffer(rule_struct.outputs[i], 16), dtype=np.uint8).reshape(4, 4).copy()
+            outputs.append((matrix, int(rule_struct.depths[i])))
+
+        results.append((rule_number, outputs))
+
+    C.free_output_maps(count, output_maps)
+    return results
+
+
+class CASession:
+    """
+    Warm engine for repeated queries against one seeded rule bank.
+
+    The bank holds the rules simulate_rule_matches(seed=seed, num_rules=num_rules)
+    would draw, in the same order. Rules, scratch buffers and worker threads are
+    created once, so each query only pays for the simulation itself.
+
+        with CASession(num_rules=100000, seed=42) as session:
+            results = session.matches(xs, ys)
+            outputs = session.outputs(x_test, [rule for rule, _ in results[0]])
+
+    family restricts the bank to one of SAMPLING_FAMILIES, e.g. family='symmetric'
+    for rules invariant under rotations and reflections of the 3×3 window (too
+    many to enumerate, so they are only available by sampling). The default
+    'full' bank is the simulate_rule_matches one.
+    """
+
+    def __init__(self, num_rules, seed=42, boundary_mode=1, max_steps=65536, num_threads=0, family='full'):
+        assert family in SAMPLING_FAMILIES, f"family must be one of {list(SAMPLING_FAMILIES)}"
+        self.num_rules = num_rules
+        self.seed = seed
+        self.boundary_mode = boundary_mode
+        self.max_steps = max_steps
+        self.family = family
+        self._streams = 0
+        self._session = ffi.gc(
+            C.ca_session_create_in_family(seed, num_rules, SAMPLING_FAMILIES[family], boundary_mode, max_steps, num_threads),
+            C.ca_session_destroy
+        )
+
+    def close(self):
+        assert self._streams == 0, "Close open streams before the session"
+        if self._session is not None:
+            ffi.release(self._session)
+            self._session = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    def rule_number(self, index):
+        """The 512-bit number of bank rule `index`."""
+        parts = self._session.rule_numbers + 8 * index
+        return sum(int(parts[k]) << (64 * k) for k in range(8))
+
+    def match_indices(self, xs, ys):
+        """Per pair, a list of (bank_index, depth) in bank order."""
+        num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+
+        match_counts = ffi.new("int[]", num_pairs)
+        match_rule_depths = ffi.new("int*[]", num_pairs)
+        match_rule_indices = ffi.new("int*[]", num_pairs)
+
+        C.ca_session_matches(
+            self._session,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_pairs,
+            match_rule_indices,
+            match_rule_depths,
+            match_counts
+        )
+
+        results = []
+        for i in range(num_pairs):
+            results.append([(int(match_rule_indices[i][j]), int(match_rule_depths[i][j]))
+                            for j in range(match_counts[i])])
+
+        C.ca_session_free_matches(num_pairs, match_rule_indices, match_rule_depths)
+        return results
+
+    def matches(self, xs, ys):
+        """Same result as simulate_rule_matches: per pair, a list of (rule_int, depth)."""
+        return [[(self.rule_number(index), depth) for index, depth in pair]
+                for pair in self.match_indices(xs, ys)]
+
+    def ctm(self, xs, ys):
+        """
+        Returns:
+            (match_counts, min_depths) with one entry per pair; min_depths is -1 where
+            no bank rule reaches y.
+        """
+        num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+
+        match_counts = np.zeros(num_pairs, dtype=np.int32)
+        min_depths = np.zeros(num_pairs, dtype=np.int32)
+
+        C.ca_session_ctm(
+            self._session,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_pairs,
+            ffi.cast("int*", match_counts.ctypes.data),
+            ffi.cast("int*", min_depths.ctypes.data)
+        )
+        return match_counts, min_depths
+
+    def outputs(self, x, rules=None):
+        """
+        Same result as simulate_rule_outputs. `rules` is a list of rule ints, an
+        (n, 8) uint64 array, or None for the whole bank.
+        """
+        assert x.shape == (4, 4), "Input matrix must be 4×4"
+        x_flat = np.ascontiguousarray(x.flatten(), dtype=np.uint32)
+        output_maps_ptr = ffi.new("OutputMap**")
+
+        if rules is None:
+            count = self.num_rules
+            C.ca_session_outputs(
+                self._session,
+                ffi.cast("uint32_t*", x_flat.ctypes.data),
+                ffi.NULL,
+                count,
+                output_maps_ptr
+            )
+            return _decode_output_maps(output_maps_ptr[0], count)
+
+        rules_flat = self._rules_flat(rules)
+        count = rules_flat.shape[0]
+
+        C.ca_session_outputs_for_rules(
+            self._session,
+            ffi.cast("uint32_t*", x_flat.ctypes.data),
+            ffi.cast("uint64_t*", rules_flat.ctypes.data),
+            count,
+            output_maps_ptr
+        )
+        return _decode_output_maps(output_maps_ptr[0], count)
+
+    def outputs_for_indices(self, x, indices):
+        """simulate_rule_outputs for the given bank indices."""
+        assert x.shape == (4, 4), "Input matrix must be 4×4"
+        x_flat = np.ascontiguousarray(x.flatten(), dtype=np.uint32)
+        indices = np.ascontiguousarray(indices, dtype=np.int32)
+        output_maps_ptr = ffi.new("OutputMap**")
+
+        C.ca_session_outputs(
+            self._session,
+            ffi.cast("uint32_t*", x_flat.ctypes.data),
+            ffi.cast("int*", indices.ctypes.data),
+            len(indices),
+            output_maps_ptr
+        )
+        return _decode_output_maps(output_maps_ptr[0], len(indices))
+
+    def _rules_flat(self, rules):
+        if rules is None:
+            return np.frombuffer(ffi.buffer(self._session.rule_numbers, self.num_rules * 64), dtype=np.uint64).reshape(-1, 8)
+        if not isinstance(rules, np.ndarray):
+            rules = [[(int(rule) >> (64 * k)) & 0xFFFFFFFFFFFFFFFF for k in range(8)] for rule in rules]
+        return np.ascontiguousarray(np.asarray(rules, dtype=np.uint64).reshape(-1, 8))
+
+    def _stream(self, stream, dtype, chunk_size):
+        # The C stream is closed when the iterator is exhausted, closed or collected.
+        self._streams += 1
+        buffer = np.empty(chunk_size, dtype=dtype)
+        try:
+            while True:
+                count = C.result_stream_next(stream, ffi.cast("void*", buffer.ctypes.data))
+                if count < 0:
+                    raise KeyboardInterrupt
+                if count == 0:
+                    return
+                yield buffer[:count].copy()
+        finally:
+            C.result_stream_close(stream)
+            self._streams -= 1
+
+    def stream_matches(self, xs, ys, chunk_size=65536, num_chunks=4):
+        """
+        Streaming form of match_indices: yields MATCH_RECORD arrays of up to chunk_size
+        records while the sweep keeps running in the background. Records are rule-major;
+        filtered by 'pair', they are exactly match_indices in order. At most num_chunks
+        chunks are buffered, after which the sweep waits for the consumer. Rule
+        numbers come from rule_number(chunk['rule_index'][k]).
+        """
+        num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+        stream = C.result_stream_matches(
+            self._session,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_pairs,
+            chunk_size,
+            num_chunks
+        )
+        yield from self._stream(stream, MATCH_RECORD, chunk_size)
+
+    def stream_outputs(self, x, rules=None, chunk_size=65536, num_chunks=4):
+        """
+        Streaming form of outputs: yields OUTPUT_RECORD arrays, one record per
+        (rule, depth), in rule order. 'rule_index' is the position in `rules` (or the
+        bank index when rules is None); decode 'state' with states_to_matrices.
+        """
+        assert x.shape == (4, 4), "Input matrix must be 4×4"
+        x_flat = np.ascontiguousarray(x.flatten(), dtype=np.uint32)
+        rules_flat = self._rules_flat(rules)
+
+        stream = C.result_stream_outputs(
+            self._session,
+            ffi.cast("uint32_t*", x_flat.ctypes.data),
+            ffi.cast("uint64_t*", rules_flat.ctypes.data),
+            rules_flat.shape[0],
+            chunk_size,
+            num_chunks
+        )
+        yield from self._stream(stream, OUTPUT_RECORD, chunk_size)
@@ -0,0 +1,127 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    typedef struct CTMServer CTMServer;
+
+    typedef struct {
+        uint64_t queries;
+        uint64_t pairs;
+        uint64_t batches;
+        int queue_depth;
+        int max_queue_depth;
+        int last_batch_queries;
+        int max_batch_queries;
+        int max_batch_pairs;
+        double mean_batch_pairs;
+        double sweep_seconds;
+    } CTMServerMetrics;
+
+    CTMServer* ctm_server_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads,
+                                 int batch_window_us, int max_batch_pairs);
+    int ctm_server_submit(CTMServer* server, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                          int* match_counts, int* min_depths);
+    int ctm_server_listen(CTMServer* server, const char* socket_path);
+    void ctm_server_metrics(CTMServer* server, CTMServerMetrics* metrics);
+    void ctm_server_destroy(CTMServer* server);
+
+    int ctm_client_query(const char* socket_path, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                         int* match_counts, int* min_depths);
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+METRIC_FIELDS = ('queries', 'pairs', 'batches', 'queue_depth', 'max_queue_depth', 'last_batch_queries',
+                 'max_batch_queries', 'max_batch_pairs', 'mean_batch_pairs', 'sweep_seconds')
+
+
+def _flatten_pairs(xs, ys):
+    xs, ys = np.asarray(xs), np.asarray(ys)
+    assert xs.shape == ys.shape
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+
+    num_pairs = len(xs)
+    xs_flat = np.ascontiguousarray(xs.reshape(num_pairs, 16), dtype=np.uint32)
+    ys_flat = np.ascontiguousarray(ys.reshape(num_pairs, 16), dtype=np.uint32)
+    return num_pairs, xs_flat, ys_flat
+
+
+def _query(fn, target, xs, ys):
+    num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+    match_counts = np.zeros(num_pairs, dtype=np.int32)
+    min_depths = np.zeros(num_pairs, dtype=np.int32)
+
+    status = fn(
+        target,
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        ffi.cast("uint32_t*", ys_flat.ctypes.data),
+        num_pairs,
+        ffi.cast("int*", match_counts.ctypes.data),
+        ffi.cast("int*", min_depths.ctypes.data)
+    )
+    if status != 0:
+        raise RuntimeError("CTM query failed")
+    return match_counts, min_depths
+
+
+class CTMServer:
+    """
+    In-process CTM query server (see ctm_server.h): concurrent query() calls from
+    different threads are coalesced into shared sweeps over one warm rule bank.
+    listen(path) additionally serves ctm_client_query over a Unix socket.
+    """
+
+    def __init__(self, num_rules, seed=42, boundary_mode=1, max_steps=65536, num_threads=0,
+                 batch_window_us=2000, max_batch_pairs=0):
+        self.num_rules = num_rules
+        self._server = ffi.gc(
+            C.ctm_server_create(seed, num_rules, boundary_mode, max_steps, num_threads,
+                                batch_window_us, max_batch_pairs),
+            C.ctm_server_destroy
+        )
+
+    def query(self, xs, ys):
+        """Returns (match_counts, min_depths); m(y|x) = match_counts / num_rules."""
+        return _query(C.ctm_server_submit, self._server, xs, ys)
+
+    def listen(self, socket_path):
+        if C.ctm_server_listen(self._server, socket_path.encode()) != 0:
+            raise OSError(f"Cannot listen on {socket_path}")
+
+    def metrics(self):
+        m = ffi.new("CTMServerMetrics*")
+        C.ctm_server_metrics(self._server, m)
+        return {name: getattr(m, name) for name in METRIC_FIELDS}
+
+    def close(self):
+        if self._server is not None:
+            ffi.release(self._server)
+            self._server = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def ctm_client_query(socket_path, xs, ys):
+    """
+    Query a running ctm_daemon (or CTMServer.listen) over its Unix socket.
+
+    Returns:
+        (match_counts, min_depths) with one entry per pair; min_depths is -1 where
+        no bank rule reaches y.
+    """
+    return _query(C.ctm_client_query, ffi.new("char[]", socket_path.encode()), xs, ys)
@@ -0,0 +1,143 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# === C Declarations ===
+ffi.cdef("""
+    typedef struct {
+        const double* values;
+        void* mapping;
+        size_t mapping_size;
+    } CTMTable4x4;
+
+    CTMTable4x4* ctm4x4_open(const char* path);
+    void ctm4x4_close(CTMTable4x4* table);
+    int ctm4x4_write(const char* path, const double* values);
+
+    void ctm4x4_lookup_batch(
+        const CTMTable4x4* table,
+        const uint32_t* grids_flat,
+        int num_grids,
+        double* complexities_out
+    );
+
+    int ctm4x4_filter(
+        const CTMTable4x4* table,
+        const uint32_t* xs_flat,
+        int num_grids,
+        const uint32_t* x_test_flat,
+        int mode,
+        double threshold,
+        uint8_t* keep_out
+    );
+""")
+
+CTM4X4_ENTRIES = 1 << 16
+FILTER_MODES = {'absolute': 0, 'percent': 1}
+
+# === Load shared library ===
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+build_dir = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build'))
+lib_path = os.path.join(build_dir, lib_name)
+C = ffi.dlopen(lib_path)
+
+ctm_table_path = os.path.join(build_dir, 'ctm_4x4.bin')
+_tables = {}
+
+
+def key_to_matrix(key):
+    """
+    Inverse of matrix_hash: bit 15 is cell (0, 0), bit 0 is cell (3, 3).
+    """
+    return np.array([(key >> (15 - i)) & 1 for i in range(16)], dtype=np.uint8).reshape(4, 4)
+
+
+def build_ctm_table():
+    """
+    Look up all 65536 binary 4×4 matrices once with pybdm's 2D CTM dataset.
+    Matrices pybdm cannot look up are stored as NaN.
+    """
+    from pybdm import BDM
+
+    bdm_2d = BDM(ndim=2, shape=(4, 4))
+    values = np.full(CTM4X4_ENTRIES, np.nan, dtype=np.float64)
+    for key in range(CTM4X4_ENTRIES):
+        try:
+            _, values[key] = next(bdm_2d.lookup([key_to_matrix(key)]))
+        except Exception:
+            continue
+    return values
+
+
+def open_ctm_table(path=ctm_table_path):
+    """
+    Memory-map the 4×4 complexity table, building and saving it on first use.
+    The mapping stays open for the lifetime of the process.
+    """
+    if path in _tables:
+        return _tables[path]
+
+    if not os.path.exists(path):
+        values = np.ascontiguousarray(build_ctm_table())
+        os.makedirs(os.path.dirname(path), exist_ok=True)
+        status = C.ctm4x4_write(path.encode(), ffi.cast("double*", values.ctypes.data))
+        assert status == 0, f"Could not write CTM table to {path}"
+
+    table = C.ctm4x4_open(path.encode())
+    assert table != ffi.NULL, f"{path} is not a valid 4×4 CTM table"
+
+    _tables[path] = ffi.gc(table, C.ctm4x4_close)
+    return _tables[path]
+
+
+def _grids_flat(grids):
+    grids = np.asarray(grids)
+    assert grids.shape[-2:] == (4, 4), "Each matrix must be 4×4"
+    return np.ascontiguousarray(grids.reshape(-1, 16), dtype=np.uint32)
+
+
+def lookup_ctm_4x4(grids, path=ctm_table_path):
+    """
+    Complexity of each 4×4 grid (NaN where no CTM value exists).
+    """
+    grids_flat = _grids_flat(grids)
+    out = np.empty(len(grids_flat), dtype=np.float64)
+
+    C.ctm4x4_lookup_batch(
+        open_ctm_table(path),
+        ffi.cast("uint32_t*", grids_flat.ctypes.data),
+        len(grids_flat),
+        ffi.cast("double*", out.ctypes.data)
+    )
+    return out
+
+
+def filter_by_ctm_4x4(xs, x_test, mode='absolute', threshold=2.0, path=ctm_table_path):
+    """
+    Boolean mask over xs of the grids whose complexity is within `threshold` of x_test's
+    (absolute difference, or difference relative to x_test's complexity for mode='percent').
+    """
+    if mode not in FILTER_MODES:
+        raise ValueError("mode must be 'absolute' or 'percent'")
+
+    xs_flat = _grids_flat(xs)
+    x_test_flat = _grids_flat(x_test)
+    keep = np.zeros(len(xs_flat), dtype=np.uint8)
+
+    kept = C.ctm4x4_filter(
+        open_ctm_table(path),
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        len(xs_flat),
+        ffi.cast("uint32_t*", x_test_flat.ctypes.data),
+        FILTER_MODES[mode],
+        threshold,
+        ffi.cast("uint8_t*", keep.ctypes.data)
+    )
+    if kept < 0:
+        raise KeyError("x_test has no CTM value in the 4×4 table")
+
+    return keep.astype(bool)
@@ -0,0 +1,146 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# === C Declarations ===
+ffi.cdef("""
+    typedef struct {
+        char magic[8];
+        uint32_t version;
+        uint32_t num_tasks;
+        uint32_t num_train;
+        uint32_t num_test;
+        uint32_t transformation;
+        int32_t boundary_mode;
+        int32_t depth;
+        uint32_t record_size;
+        uint64_t seed;
+        uint8_t reserved[16];
+    } DatasetHeader;
+
+    typedef struct {
+        const DatasetHeader* header;
+        const uint8_t* records;
+        void* mapping;
+        size_t mapping_size;
+    } Dataset;
+
+    int generate_dataset(
+        const char* path,
+        int num_tasks,
+        int num_train,
+        int num_test,
+        int transformation,
+        int depth,
+        uint64_t seed,
+        int boundary_mode,
+        int num_threads
+    );
+
+    Dataset* dataset_open(const char* path);
+    void dataset_close(Dataset* dataset);
+    int dataset_export_json(const Dataset* dataset, const char* output_dir, int first_task, int count);
+""")
+
+TRANSFORMATIONS = {'bit_inversion': 0, 'ca_rule': 1}
+HEADER_BYTES = 64
+
+# === Load shared library ===
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+C = ffi.dlopen(lib_path)
+
+
+def generate_dataset(path, num_tasks, num_train=4, num_test=1, transformation='ca_rule', depth=1,
+                     seed=42, boundary_mode=1, num_threads=0):
+    """
+    Generate num_tasks tasks natively (in parallel) into a binary dataset file.
+    """
+    assert transformation in TRANSFORMATIONS, f"transformation must be one of {list(TRANSFORMATIONS)}"
+
+    status = C.generate_dataset(
+        str(path).encode(),
+        num_tasks,
+        num_train,
+        num_test,
+        TRANSFORMATIONS[transformation],
+        depth,
+        seed,
+        boundary_mode,
+        num_threads
+    )
+    if status != 0:
+        raise RuntimeError(f"Dataset generation failed for {path}")
+
+
+def _unpack_grids(keys):
+    # matrix_hash layout: bit 15 is cell (0, 0)
+    bits = (keys[..., None] >> np.arange(15, -1, -1, dtype=np.uint16)) & 1
+    return bits.astype(np.uint8).reshape(keys.shape + (4, 4))
+
+
+def load_dataset(path, decode=True):
+    """
+    Memory-map a binary dataset.
+
+    Returns:
+        dict with 'metadata' and arrays 'rules' (N, 8) uint64, 'train_x'/'train_y'
+        (N, num_train, 4, 4) and 'test_x'/'test_y' (N, num_test, 4, 4) uint8.
+        With decode=False the grid arrays are the mapped uint16 matrix_hash keys
+        ((N, num_train) / (N, num_test)) and nothing is copied.
+    """
+    header = np.fromfile(path, dtype=np.uint8, count=HEADER_BYTES)
+    assert bytes(header[:8]) == b'AARCDS1\x00', f"{path} is not an Algorithmic-ARC dataset"
+
+    fields = header[8:40].view('<u4')
+    num_tasks, num_train, num_test, transformation = (int(v) for v in fields[1:5])
+    boundary_mode, depth = (int(v) for v in header[24:32].view('<i4'))
+    record_size = int(fields[7])
+    seed = int(header[40:48].view('<u8')[0])
+
+    n = num_train + num_test
+    record = np.dtype({
+        'names': ['rule', 'grids'],
+        'formats': ['(8,)<u8', f'({2 * n},)<u2'],
+        'offsets': [0, 64],
+        'itemsize': record_size,
+    })
+    records = np.memmap(path, dtype=record, mode='r', offset=HEADER_BYTES, shape=(num_tasks,))
+    grids = records['grids']
+    unpack = _unpack_grids if decode else (lambda keys: keys)
+
+    name = {v: k for k, v in TRANSFORMATIONS.items()}[transformation]
+    return {
+        'metadata': {'transformation': name, 'seed': seed, 'boundary_mode': boundary_mode, 'depth': depth},
+        'rules': records['rule'],
+        'train_x': unpack(grids[:, :num_train]),
+        'train_y': unpack(grids[:, num_train:2 * num_train]),
+        'test_x': unpack(grids[:, 2 * num_train:2 * num_train + num_test]),
+        'test_y': unpack(grids[:, 2 * num_train + num_test:]),
+    }
+
+
+def export_dataset_json(path, output_dir, first_task=0, count=-1):
+    """
+    Write tasks as JSON files in the AlgorithmicARCDatasetBuilder format.
+
+    Returns:
+        Number of files written.
+    """
+    os.makedirs(output_dir, exist_ok=True)
+    dataset = C.dataset_open(str(path).encode())
+    if dataset == ffi.NULL:
+        raise RuntimeError(f"{path} is not a valid dataset file")
+
+    try:
+        written = C.dataset_export_json(dataset, str(output_dir).encode(), first_task, count)
+    finally:
+        C.dataset_close(dataset)
+
+    if written < 0:
+        raise RuntimeError(f"JSON export to {output_dir} failed")
+    return written
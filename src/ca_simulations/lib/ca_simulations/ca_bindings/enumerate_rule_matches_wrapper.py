@@ -0,0 +1,137 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    uint64_t enumerate_rule_matches(
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int family,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        uint64_t*** match_rule_numbers,
+        int** match_rule_depths,
+        int* match_counts
+    );
+
+    uint64_t enumerate_rule_ctm(
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int family,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        uint64_t* match_counts,
+        int* min_depths
+    );
+
+    void free_matches(
+        int num_pairs,
+        int* match_counts,
+        int** match_rule_depths,
+        uint64_t*** match_rule_numbers
+    );
+""")
+
+# Enumerable binary rule families (see RULE_FAMILY_* in ca_dynamics.h); the symmetric
+# family is too large to enumerate and is sampled with CASession(family='symmetric')
+RULE_FAMILIES = {'totalistic': 1, 'outer_totalistic': 2}
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def _prepare_pairs(xs, ys, family):
+    assert family in RULE_FAMILIES, f"family must be one of {list(RULE_FAMILIES)}"
+    assert xs.shape == ys.shape
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+
+    num_pairs = len(xs)
+    xs_flat = xs.reshape(num_pairs, 16).astype("uint32")
+    ys_flat = ys.reshape(num_pairs, 16).astype("uint32")
+    return num_pairs, xs_flat, ys_flat
+
+
+def enumerate_rule_matches(xs, ys, family='outer_totalistic', boundary_mode=1, max_steps=65536, num_threads=0):
+    """
+    Exhaustive counterpart of simulate_rule_matches over a restricted rule family.
+
+    Returns:
+        (results, family_size): results has the same layout as simulate_rule_matches,
+        and len(results[i]) / family_size is the exact m(y_i|x_i) over the family.
+    """
+    num_pairs, xs_flat, ys_flat = _prepare_pairs(xs, ys, family)
+
+    match_counts = ffi.new("int[]", num_pairs)
+    match_rule_depths = ffi.new("int*[]", num_pairs)
+    match_rule_numbers = ffi.new("uint64_t**[]", num_pairs)
+
+    family_size = C.enumerate_rule_matches(
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        ffi.cast("uint32_t*", ys_flat.ctypes.data),
+        num_pairs,
+        RULE_FAMILIES[family],
+        boundary_mode,
+        max_steps,
+        num_threads,
+        match_rule_numbers,
+        match_rule_depths,
+        match_counts
+    )
+
+    # Decode results
+    results = []
+    for i in range(num_pairs):
+        matches = []
+        for j in range(match_counts[i]):
+            rule_ptr = match_rule_numbers[i][j]
+            rule_int = 0
+            for k in range(8):
+                rule_int |= int(rule_ptr[k]) << (64 * k)
+            matches.append((rule_int, match_rule_depths[i][j]))
+        results.append(matches)
+
+    # Free C-side memory
+    C.free_matches(num_pairs, match_counts, match_rule_depths, match_rule_numbers)
+
+    return results, int(family_size)
+
+
+def enumerate_rule_ctm(xs, ys, family='outer_totalistic', boundary_mode=1, max_steps=65536, num_threads=0):
+    """
+    Exact match counts and minimum depths over a restricted rule family.
+
+    Returns:
+        (match_counts, min_depths, family_size) with one entry per pair; min_depths is -1
+        where no rule reaches y.
+    """
+    num_pairs, xs_flat, ys_flat = _prepare_pairs(xs, ys, family)
+
+    match_counts = np.zeros(num_pairs, dtype=np.uint64)
+    min_depths = np.zeros(num_pairs, dtype=np.int32)
+
+    family_size = C.enumerate_rule_ctm(
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        ffi.cast("uint32_t*", ys_flat.ctypes.data),
+        num_pairs,
+        RULE_FAMILIES[family],
+        boundary_mode,
+        max_steps,
+        num_threads,
+        ffi.cast("uint64_t*", match_counts.ctypes.data),
+        ffi.cast("int*", min_depths.ctypes.data)
+    )
+
+    return match_counts, min_depths, int(family_size)
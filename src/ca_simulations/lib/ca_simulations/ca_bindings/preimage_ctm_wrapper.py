@@ -0,0 +1,69 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    int preimage_ctm(
+        uint32_t* y_flat,
+        unsigned int seed,
+        int num_rules,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        int* match_counts,
+        int* min_depths
+    );
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def preimage_ctm(y, num_rules=100_000, seed=42, boundary_mode=1, max_steps=65536, num_threads=0):
+    """
+    Column of the conditional CTM table for a fixed target y, from one backward
+    pass per rule (see preimage_ctm.h). Entry x of every array is the input whose
+    matrix_hash is x (cell (0, 0) is bit 15); states_to_matrices(np.arange(65536))
+    lists them.
+
+    Returns:
+        dict with 'match_counts', 'min_depths' (-1 if never reached), 'm' and 'ctm'
+        (inf where no rule reaches y), each of length 65536, plus 'num_rules'.
+    """
+    assert y.shape == (4, 4), "Target matrix must be 4×4"
+    y_flat = np.ascontiguousarray(y.flatten(), dtype=np.uint32)
+
+    match_counts = np.zeros(1 << 16, dtype=np.int32)
+    min_depths = np.zeros(1 << 16, dtype=np.int32)
+
+    total = C.preimage_ctm(
+        ffi.cast("uint32_t*", y_flat.ctypes.data),
+        seed,
+        num_rules,
+        boundary_mode,
+        max_steps,
+        num_threads,
+        ffi.cast("int*", match_counts.ctypes.data),
+        ffi.cast("int*", min_depths.ctypes.data)
+    )
+
+    m = match_counts / max(total, 1)
+    with np.errstate(divide='ignore'):
+        ctm = -np.log2(m)
+
+    return {
+        'match_counts': match_counts,
+        'min_depths': min_depths,
+        'm': m,
+        'ctm': ctm,
+        'num_rules': total,
+    }
@@ -0,0 +1,278 @@
+import os
+import platform
+import weakref
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    typedef struct {
+        uint64_t rule_number[8];
+        uint8_t (*outputs)[4][4];
+        int* depths;
+        int num_outputs;
+    } OutputMap;
+
+    typedef struct {
+        unsigned int seed;
+        int encoding;
+        int num_rules;
+        const uint64_t* rule_numbers;
+        void* mapping;
+        size_t mapping_size;
+    } RuleBank;
+
+    int rule_bank_write(const char* path, unsigned int seed, int num_rules);
+    RuleBank* rule_bank_open(const char* path);
+    void rule_bank_close(RuleBank* bank);
+
+    void rule_bank_matches(
+        const RuleBank* bank,
+        int begin,
+        int end,
+        const uint32_t* xs_flat,
+        const uint32_t* ys_flat,
+        int num_pairs,
+        int boundary_mode,
+        int max_steps,
+        int** match_rule_indices,
+        int** match_rule_depths,
+        int* match_counts
+    );
+
+    void rule_bank_free_matches(
+        int num_pairs,
+        int** match_rule_indices,
+        int** match_rule_depths
+    );
+
+    void rule_bank_ctm(
+        const RuleBank* bank,
+        int begin,
+        int end,
+        const uint32_t* xs_flat,
+        const uint32_t* ys_flat,
+        int num_pairs,
+        int boundary_mode,
+        int max_steps,
+        int* match_counts,
+        int* min_depths
+    );
+
+    void rule_bank_outputs(
+        const RuleBank* bank,
+        int begin,
+        int end,
+        const uint32_t* x_flat,
+        int boundary_mode,
+        int max_steps,
+        OutputMap** output_maps_out
+    );
+
+    void free_output_maps(
+        int num_rules,
+        OutputMap* output_maps
+    );
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def _flatten_pairs(xs, ys):
+    assert xs.shape == ys.shape
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+
+    num_pairs = len(xs)
+    xs_flat = np.ascontiguousarray(xs.reshape(num_pairs, 16), dtype=np.uint32)
+    ys_flat = np.ascontiguousarray(ys.reshape(num_pairs, 16), dtype=np.uint32)
+    return num_pairs, xs_flat, ys_flat
+
+
+class _MappedRules:
+    """Array interface over the mapped rule numbers that keeps its RuleBank open."""
+
+    def __init__(self, bank):
+        self.bank = bank
+        self.__array_interface__ = {
+            'shape': (bank.num_rules, 8),
+            'typestr': np.dtype(np.uint64).str,
+            'data': (int(ffi.cast("uintptr_t", bank._bank.rule_numbers)), True),
+            'version': 3,
+        }
+
+
+class RuleBank:
+    """
+    Seeded rule bank file, memory-mapped read-only (see rule_bank.h).
+
+    The bank holds the rules simulate_rule_matches(seed=seed, num_rules=num_rules)
+    would draw, in the same order. Pickling a RuleBank sends only its path, so
+    multiprocessing workers reopen the same page-cached file and query their own
+    index range:
+
+        bank = RuleBank.create('bank.bin', num_rules=1_000_000, seed=42)
+        with Pool() as pool:
+            parts = pool.starmap(bank.ctm, [(xs, ys, b, b + 250_000) for b in range(0, 1_000_000, 250_000)])
+        counts = sum(p[0] for p in parts)
+    """
+
+    def __init__(self, path):
+        self.path = os.path.abspath(path)
+        bank = C.rule_bank_open(self.path.encode())
+        if bank == ffi.NULL:
+            raise ValueError(f"Not a rule bank file: {self.path}")
+        self._bank = ffi.gc(bank, C.rule_bank_close)
+        self._views = weakref.WeakSet()
+        self.seed = bank.seed
+        self.num_rules = bank.num_rules
+
+    @classmethod
+    def create(cls, path, num_rules, seed=42):
+        """Generate the bank file (overwriting path) and open it."""
+        if C.rule_bank_write(os.path.abspath(path).encode(), seed, num_rules) != 0:
+            raise OSError(f"Could not write rule bank: {path}")
+        return cls(path)
+
+    def __reduce__(self):
+        return (RuleBank, (self.path,))
+
+    def __len__(self):
+        return self.num_rules
+
+    def close(self):
+        """Unmap the bank; refused while arrays from rules_flat are still alive."""
+        if any(True for _ in self._views):
+            raise BufferError("RuleBank.close(): rules_flat views are still alive")
+        if self._bank is not None:
+            ffi.release(self._bank)
+            self._bank = None
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+    @property
+    def rules_flat(self):
+        """
+        Zero-copy, read-only (num_rules, 8) uint64 view of the mapped rule numbers.
+        The view (and any slice of it) keeps the bank mapped until it is dropped.
+        """
+        if self._bank is None:
+            raise ValueError("RuleBank is closed")
+        mapped = _MappedRules(self)
+        self._views.add(mapped)
+        return np.asarray(mapped)
+
+    def rule_number(self, index):
+        """The 512-bit number of bank rule `index`."""
+        parts = self._bank.rule_numbers + 8 * index
+        return sum(int(parts[k]) << (64 * k) for k in range(8))
+
+    def _range(self, begin, end):
+        return begin, self.num_rules if end is None else end
+
+    def match_indices(self, xs, ys, begin=0, end=None, boundary_mode=1, max_steps=65536):
+        """Per pair, a list of (bank_index, depth) over rules [begin, end)."""
+        begin, end = self._range(begin, end)
+        num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+
+        match_counts = ffi.new("int[]", num_pairs)
+        match_rule_depths = ffi.new("int*[]", num_pairs)
+        match_rule_indices = ffi.new("int*[]", num_pairs)
+
+        C.rule_bank_matches(
+            self._bank,
+            begin,
+            end,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_pairs,
+            boundary_mode,
+            max_steps,
+            match_rule_indices,
+            match_rule_depths,
+            match_counts
+        )
+
+        results = []
+        for i in range(num_pairs):
+            results.append([(int(match_rule_indices[i][j]), int(match_rule_depths[i][j]))
+                            for j in range(match_counts[i])])
+
+        C.rule_bank_free_matches(num_pairs, match_rule_indices, match_rule_depths)
+        return results
+
+    def matches(self, xs, ys, begin=0, end=None, boundary_mode=1, max_steps=65536):
+        """simulate_rule_matches over rules [begin, end): per pair, a list of (rule_int, depth)."""
+        return [[(self.rule_number(index), depth) for index, depth in pair]
+                for pair in self.match_indices(xs, ys, begin, end, boundary_mode, max_steps)]
+
+    def ctm(self, xs, ys, begin=0, end=None, boundary_mode=1, max_steps=65536):
+        """
+        Returns:
+            (match_counts, min_depths) over rules [begin, end); min_depths is -1 where
+            no rule in the range reaches y. Counts over disjoint ranges add up.
+        """
+        begin, end = self._range(begin, end)
+        num_pairs, xs_flat, ys_flat = _flatten_pairs(xs, ys)
+
+        match_counts = np.zeros(num_pairs, dtype=np.int32)
+        min_depths = np.zeros(num_pairs, dtype=np.int32)
+
+        C.rule_bank_ctm(
+            self._bank,
+            begin,
+            end,
+            ffi.cast("uint32_t*", xs_flat.ctypes.data),
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_pairs,
+            boundary_mode,
+            max_steps,
+            ffi.cast("int*", match_counts.ctypes.data),
+            ffi.cast("int*", min_depths.ctypes.data)
+        )
+        return match_counts, min_depths
+
+    def outputs(self, x, begin=0, end=None, boundary_mode=1, max_steps=65536):
+        """simulate_rule_outputs over rules [begin, end): a list of (rule_int, [(matrix, depth), ...])."""
+        assert x.shape == (4, 4), "Input matrix must be 4×4"
+        begin, end = self._range(begin, end)
+        x_flat = np.ascontiguousarray(x.flatten(), dtype=np.uint32)
+        output_maps_ptr = ffi.new("OutputMap**")
+
+        C.rule_bank_outputs(
+            self._bank,
+            begin,
+            end,
+            ffi.cast("uint32_t*", x_flat.ctypes.data),
+            boundary_mode,
+            max_steps,
+            output_maps_ptr
+        )
+
+        count = max(min(end, self.num_rules) - max(begin, 0), 0)
+        output_maps = output_maps_ptr[0]
+        results = []
+        for r in range(count):
+            rule_struct = output_maps[r]
+            rule_number = sum(int(rule_struct.rule_number[k]) << (64 * k) for k in range(8))
+
+            outputs = []
+            for i in range(rule_struct.num_outputs):
+                matrix = np.frombuffer(ffi.buffer(rule_struct.outputs[i], 16), dtype=np.uint8).reshape(4, 4).copy()
+                outputs.append((matrix, int(rule_struct.depths[i])))
+
+            results.append((rule_number, outputs))
+
+        C.free_output_maps(count, output_maps)
+        return results
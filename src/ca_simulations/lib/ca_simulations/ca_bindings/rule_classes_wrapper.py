@@ -0,0 +1,72 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    int rule_equivalence_classes(
+        const uint64_t* rules_flat,
+        int num_rules,
+        const uint32_t* xs_flat,
+        int num_xs,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        int* class_of,
+        int* representatives,
+        int* multiplicities,
+        int* used_codes
+    );
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def rule_equivalence_classes(rules, xs, boundary_mode=1, max_steps=65536, num_threads=0):
+    """
+    Group rules (ints or an (n, 8) uint64 array) that produce identical trajectories
+    from every matrix in xs, because they agree on every neighborhood code those
+    trajectories read.
+
+    Returns:
+        (class_of, representatives, multiplicities): the class index of every rule,
+        and per class (in order of first appearance) the index of its first rule and
+        the number of rules it stands for.
+    """
+    if not isinstance(rules, np.ndarray):
+        rules = [[(int(rule) >> (64 * k)) & 0xFFFFFFFFFFFFFFFF for k in range(8)] for rule in rules]
+    rules_flat = np.ascontiguousarray(np.asarray(rules, dtype=np.uint64).reshape(-1, 8))
+    num_rules = rules_flat.shape[0]
+
+    xs = np.asarray(xs)
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+    xs_flat = np.ascontiguousarray(xs.reshape(len(xs), 16), dtype=np.uint32)
+
+    class_of = np.zeros(num_rules, dtype=np.int32)
+    representatives = np.zeros(num_rules, dtype=np.int32)
+    multiplicities = np.zeros(num_rules, dtype=np.int32)
+
+    num_classes = C.rule_equivalence_classes(
+        ffi.cast("uint64_t*", rules_flat.ctypes.data),
+        num_rules,
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        len(xs_flat),
+        boundary_mode,
+        max_steps,
+        num_threads,
+        ffi.cast("int*", class_of.ctypes.data),
+        ffi.cast("int*", representatives.ctypes.data),
+        ffi.cast("int*", multiplicities.ctypes.data),
+        ffi.NULL
+    )
+
+    return class_of, representatives[:num_classes], multiplicities[:num_classes]
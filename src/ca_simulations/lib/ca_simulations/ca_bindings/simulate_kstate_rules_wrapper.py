@@ -0,0 +1,184 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# === C Declarations ===
+ffi.cdef("""
+    typedef struct {
+        uint8_t table[730];
+        uint8_t (*outputs)[4][4];
+        int* depths;
+        int num_outputs;
+    } KOutputMap;
+
+    int kstate_table_size(int family, int num_colors);
+
+    void simulate_kstate_matches(
+        uint32_t* xs_flat,
+        uint32_t* ys_flat,
+        int num_pairs,
+        int num_rules,
+        unsigned int seed,
+        int num_colors,
+        int family,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        uint8_t*** match_rule_tables,
+        int** match_rule_depths,
+        int* match_counts
+    );
+
+    void free_kstate_matches(
+        int num_pairs,
+        int* match_counts,
+        int** match_rule_depths,
+        uint8_t*** match_rule_tables
+    );
+
+    void simulate_kstate_outputs(
+        uint32_t* x_flat,
+        uint8_t* tables_flat,
+        int num_rules,
+        int num_colors,
+        int family,
+        int boundary_mode,
+        int max_steps,
+        int num_threads,
+        KOutputMap** output_maps_out
+    );
+
+    void free_kstate_output_maps(
+        int num_rules,
+        KOutputMap* output_maps
+    );
+""")
+
+KSTATE_FAMILIES = {'totalistic': 0, 'outer_totalistic': 1}
+
+# === Load shared library ===
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+C = ffi.dlopen(lib_path)
+
+
+def _family_id(family):
+    assert family in KSTATE_FAMILIES, f"family must be one of {list(KSTATE_FAMILIES)}"
+    return KSTATE_FAMILIES[family]
+
+
+def simulate_kstate_matches(xs, ys, num_colors, family='outer_totalistic', num_rules=1_000_000, seed=42,
+                            boundary_mode=1, max_steps=65536, num_threads=0):
+    """
+    k-state counterpart of simulate_rule_matches.
+
+    Returns:
+        List (one entry per pair) of (rule_table, depth) tuples, where rule_table is a
+        bytes object of kstate_table_size(family, num_colors) colors.
+    """
+    num_pairs = len(xs)
+    assert xs.shape == ys.shape
+    assert xs.shape[1:] == (4, 4), "Each matrix must be 4×4"
+    assert xs.max(initial=0) < num_colors and ys.max(initial=0) < num_colors, "Colors must be < num_colors"
+
+    family_id = _family_id(family)
+    table_size = C.kstate_table_size(family_id, num_colors)
+    assert table_size > 0, f"Unsupported num_colors={num_colors}"
+
+    xs_flat = xs.reshape(num_pairs, 16).astype("uint32")
+    ys_flat = ys.reshape(num_pairs, 16).astype("uint32")
+
+    match_counts = ffi.new("int[]", num_pairs)
+    match_rule_depths = ffi.new("int*[]", num_pairs)
+    match_rule_tables = ffi.new("uint8_t**[]", num_pairs)
+
+    C.simulate_kstate_matches(
+        ffi.cast("uint32_t*", xs_flat.ctypes.data),
+        ffi.cast("uint32_t*", ys_flat.ctypes.data),
+        num_pairs,
+        num_rules,
+        seed,
+        num_colors,
+        family_id,
+        boundary_mode,
+        max_steps,
+        num_threads,
+        match_rule_tables,
+        match_rule_depths,
+        match_counts
+    )
+
+    # Decode results
+    results = []
+    for i in range(num_pairs):
+        matches = []
+        for j in range(match_counts[i]):
+            table = bytes(ffi.buffer(match_rule_tables[i][j], table_size))
+            matches.append((table, match_rule_depths[i][j]))
+        results.append(matches)
+
+    # Free C-side memory
+    C.free_kstate_matches(num_pairs, match_counts, match_rule_depths, match_rule_tables)
+
+    return results
+
+
+def simulate_kstate_outputs(x, tables, num_colors, family='outer_totalistic', boundary_mode=1, max_steps=65536,
+                            num_threads=0):
+    """
+    k-state counterpart of simulate_rule_outputs.
+
+    Parameters:
+        x: 4×4 input matrix with colors in [0, num_colors)
+        tables: iterable of rule tables (bytes or uint8 arrays) as returned by simulate_kstate_matches
+
+    Returns:
+        List of (rule_table, [(matrix, depth), ...]) tuples.
+    """
+    assert x.shape == (4, 4), "Input matrix must be 4×4"
+
+    family_id = _family_id(family)
+    table_size = C.kstate_table_size(family_id, num_colors)
+    assert table_size > 0, f"Unsupported num_colors={num_colors}"
+
+    tables = np.array([np.frombuffer(bytes(t), dtype=np.uint8) for t in tables], dtype=np.uint8)
+    assert tables.ndim == 2 and tables.shape[1] == table_size, f"Each rule table must have {table_size} entries"
+
+    num_rules = tables.shape[0]
+    x_flat = x.astype("uint32").flatten()
+    tables_flat = np.ascontiguousarray(tables).flatten()
+
+    output_maps_ptr = ffi.new("KOutputMap**")
+
+    C.simulate_kstate_outputs(
+        ffi.cast("uint32_t*", x_flat.ctypes.data),
+        ffi.cast("uint8_t*", tables_flat.ctypes.data),
+        num_rules,
+        num_colors,
+        family_id,
+        boundary_mode,
+        max_steps,
+        num_threads,
+        output_maps_ptr
+    )
+
+    output_maps = output_maps_ptr[0]
+    results = []
+
+    for r in range(num_rules):
+        rule_struct = output_maps[r]
+        table = bytes(ffi.buffer(rule_struct.table, table_size))
+
+        outputs = []
+        for i in range(rule_struct.num_outputs):
+            matrix = np.frombuffer(ffi.buffer(rule_struct.outputs[i], 16), dtype=np.uint8).reshape(4, 4).copy()
+            outputs.append((matrix, int(rule_struct.depths[i])))
+
+        results.append((table, outputs))
+
+    C.free_kstate_output_maps(num_rules, output_maps)
+    return results
@@ -0,0 +1,66 @@
+import os
+import json
+import platform
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations
+ffi.cdef("""
+    typedef struct {
+        unsigned int seed;
+        int num_rules;
+        int boundary_mode;
+        int max_steps;
+        int top_k;
+        const char* bdm_table_path;
+        int num_threads;
+    } RunnerOptions;
+
+    int runner_run_directory(const char* task_dir, const RunnerOptions* options, const char* output_path);
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+def run_task_directory(task_dir, output_path, num_rules=1_000_000, seed=42, boundary_mode=1, max_steps=65536,
+                       top_k=None, bdm_table_path=None, num_threads=0):
+    """
+    Native AlgorithmicAbductionInduction.run over every *.json task in task_dir,
+    in parallel over one shared rule bank (see task_runner.h).
+
+    With top_k, rules are ranked by BDM using bdm_table_path, or the table cached
+    by bdm_scoring_wrapper when not given.
+
+    Returns:
+        The results written to output_path: per task, the predictions with their
+        k_ctm and correctness, abduction/ranking counts and per-stage seconds.
+    """
+    if top_k is not None and bdm_table_path is None:
+        from .bdm_scoring_wrapper import load_ctm_table, ctm_table_path
+        load_ctm_table()
+        bdm_table_path = ctm_table_path
+
+    table_path = ffi.new("char[]", bdm_table_path.encode()) if bdm_table_path else ffi.NULL
+    options = ffi.new("RunnerOptions*", {
+        'seed': seed,
+        'num_rules': num_rules,
+        'boundary_mode': boundary_mode,
+        'max_steps': max_steps,
+        'top_k': top_k or 0,
+        'bdm_table_path': table_path,
+        'num_threads': num_threads,
+    })
+
+    status = C.runner_run_directory(str(task_dir).encode(), options, str(output_path).encode())
+    if status < 0:
+        raise RuntimeError(f"Native task runner failed on {task_dir}")
+
+    with open(output_path) as f:
+        return json.load(f)
@@ -0,0 +1,32 @@
+import numpy as np
+from simulate_kstate_rules_wrapper import simulate_kstate_matches, simulate_kstate_outputs
+
+def test_colored_pair():
+    xs = np.array([
+        [[0,0,0,0],
+         [0,3,3,0],
+         [0,3,3,0],
+         [0,0,0,0]]
+    ], dtype=np.uint8)
+
+    ys = np.array([
+        [[0,0,0,0],
+         [0,0,0,0],
+         [0,0,0,0],
+         [0,0,0,0]]
+    ], dtype=np.uint8)
+
+    print("Running 4-color outer-totalistic simulation with 100,000 rules...")
+    results = simulate_kstate_matches(xs, ys, num_colors=4, family='outer_totalistic',
+                                      num_rules=100_000, seed=42, boundary_mode=1, max_steps=256)
+
+    matches = results[0]
+    print(f"Pair 0: {len(matches)} rules matched.")
+
+    tables = [table for table, _ in matches[:3]]
+    for (table, outputs), (_, depth) in zip(simulate_kstate_outputs(xs[0], tables, num_colors=4), matches[:3]):
+        print(f"  Rule table {table[:8].hex()}…: {len(outputs)} outputs, match depth = {depth}")
+        assert any(d == depth and np.array_equal(m, ys[0]) for m, d in outputs)
+
+if __name__ == "__main__":
+    test_colored_pair()
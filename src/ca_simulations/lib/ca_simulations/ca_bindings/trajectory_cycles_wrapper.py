@@ -0,0 +1,141 @@
+import os
+import platform
+import numpy as np
+from cffi import FFI
+
+ffi = FFI()
+
+# C function declarations (the session is passed as an opaque CASession*)
+ffi.cdef("""
+    typedef struct {
+        int num_rules;
+        uint64_t* offsets;
+        int32_t* transients;
+        int32_t* periods;
+        uint16_t* states;
+        void* pool;
+    } Trajectories;
+
+    Trajectories* trajectories_build(void* session, const uint32_t* x_flat, const int* rule_indices, int num_indices);
+    Trajectories* trajectories_build_for_rules(void* session, const uint32_t* x_flat, const uint64_t* rules_flat, int num_rules);
+    void trajectories_free(Trajectories* trajectories);
+
+    void trajectories_state_at(const Trajectories* trajectories, const uint64_t* ts, int num_ts, uint16_t* states_out);
+    void trajectories_find(const Trajectories* trajectories, const uint32_t* ys_flat, int num_ys, int32_t* depths_out, uint8_t* on_cycle_out);
+""")
+
+# Determine correct shared library extension
+ext = 'dylib' if platform.system() == 'Darwin' else 'so'
+lib_name = f'libsimulate_rule_matches.{ext}'
+lib_path = os.path.abspath(os.path.join(os.path.dirname(__file__), '..', 'build', lib_name))
+
+# Load shared library
+C = ffi.dlopen(lib_path)
+
+
+class Trajectories:
+    """
+    Cycle-compressed orbits of x under many rules (see trajectory_cycles.h): per
+    rule, the transient followed by one period of the cycle, as packed states
+    (decode with states_to_matrices). The orbits are exact for any step, however
+    large, and independent of the session's max_steps.
+
+        orbits = Trajectories(session, x_test, rules=rules)
+        finals = orbits.state_at(10**9)          # (num_rules,) packed states
+        depths, cyclic = orbits.find(candidates)  # (num_rules, num_candidates)
+
+    rules are 512-bit ints or a (n, 8) uint64 array; indices are bank indices;
+    with neither, the whole session bank is used.
+    """
+
+    def __init__(self, session, x, rules=None, indices=None):
+        assert x.shape == (4, 4), "Input matrix must be 4×4"
+        x_flat = np.ascontiguousarray(x.flatten(), dtype=np.uint32)
+        x_ptr = ffi.cast("uint32_t*", x_flat.ctypes.data)
+        session_ptr = ffi.cast("void*", session._session)
+
+        if rules is not None:
+            if not isinstance(rules, np.ndarray):
+                rules = [[(int(rule) >> (64 * k)) & 0xFFFFFFFFFFFFFFFF for k in range(8)] for rule in rules]
+            rules_flat = np.ascontiguousarray(np.asarray(rules, dtype=np.uint64).reshape(-1, 8))
+            tr = C.trajectories_build_for_rules(
+                session_ptr, x_ptr, ffi.cast("uint64_t*", rules_flat.ctypes.data), rules_flat.shape[0]
+            )
+        elif indices is not None:
+            indices = np.ascontiguousarray(indices, dtype=np.int32)
+            tr = C.trajectories_build(session_ptr, x_ptr, ffi.cast("int*", indices.ctypes.data), len(indices))
+        else:
+            tr = C.trajectories_build(session_ptr, x_ptr, ffi.NULL, 0)
+
+        if tr == ffi.NULL:
+            raise KeyboardInterrupt
+        self.session = session  # the C side uses its worker pool
+        self._tr = ffi.gc(tr, C.trajectories_free)
+
+        n = tr.num_rules
+        self.num_rules = n
+        # Copied out: views over the C arrays (and orbit()/cycle() slices of them)
+        # would outlive self._tr once the caller drops this object.
+        self.offsets = np.frombuffer(ffi.buffer(tr.offsets, (n + 1) * 8), dtype=np.uint64).copy()
+        self.transients = np.frombuffer(ffi.buffer(tr.transients, n * 4), dtype=np.int32).copy()
+        self.periods = np.frombuffer(ffi.buffer(tr.periods, n * 4), dtype=np.int32).copy()
+        self.states = np.frombuffer(ffi.buffer(tr.states, int(self.offsets[-1]) * 2), dtype=np.uint16).copy()
+
+    def __len__(self):
+        return self.num_rules
+
+    def orbit(self, r):
+        """Packed states of rule r: the transient, then one period of the cycle."""
+        return self.states[int(self.offsets[r]):int(self.offsets[r + 1])]
+
+    def cycle(self, r):
+        """Packed states rule r revisits forever, in order from the cycle entry."""
+        return self.orbit(r)[int(self.transients[r]):]
+
+    def state_at(self, t):
+        """
+        Packed state of every rule after t steps: shape (num_rules,) for a scalar t,
+        (num_rules, len(t)) for a sequence of steps.
+        """
+        scalar = np.ndim(t) == 0
+        ts = np.ascontiguousarray(np.atleast_1d(t), dtype=np.uint64)
+        states = np.zeros((self.num_rules, len(ts)), dtype=np.uint16)
+        C.trajectories_state_at(
+            self._tr,
+            ffi.cast("uint64_t*", ts.ctypes.data),
+            len(ts),
+            ffi.cast("uint16_t*", states.ctypes.data)
+        )
+        return states[:, 0] if scalar else states
+
+    def find(self, ys):
+        """
+        Returns:
+            (depths, on_cycle): for every rule and target (ys is (4, 4) or (n, 4, 4)),
+            the first step the orbit is in y (-1 if never) and whether y lies on the
+            rule's cycle. Both have shape (num_rules, n), or (num_rules,) for one y.
+        """
+        ys = np.asarray(ys)
+        single = ys.shape == (4, 4)
+        ys_flat = np.ascontiguousarray(ys.reshape(-1, 16), dtype=np.uint32)
+        num_ys = ys_flat.shape[0]
+
+        depths = np.zeros((self.num_rules, num_ys), dtype=np.int32)
+        on_cycle = np.zeros((self.num_rules, num_ys), dtype=np.uint8)
+        C.trajectories_find(
+            self._tr,
+            ffi.cast("uint32_t*", ys_flat.ctypes.data),
+            num_ys,
+            ffi.cast("int32_t*", depths.ctypes.data),
+            ffi.cast("uint8_t*", on_cycle.ctypes.data)
+        )
+        on_cycle = on_cycle.astype(bool)
+        return (depths[:, 0], on_cycle[:, 0]) if single else (depths, on_cycle)
+
+    def first_hit(self, ys):
+        """First step each rule's orbit is in y, -1 if never (see find)."""
+        return self.find(ys)[0]
+
+    def on_cycle(self, ys):
+        """Whether y lies on each rule's cycle (see find)."""
+        return self.find(ys)[1]
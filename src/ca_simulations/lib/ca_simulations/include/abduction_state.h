@@ -0,0 +1,72 @@
+#ifndef ABDUCTION_STATE_H
+#define ABDUCTION_STATE_H
+
+#include <stdint.h>
+#include "ca_session.h"  // for CASession
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Incremental abduction over a session's rule bank: the bank rules that reach
+ * y from x on every training pair added so far ("survivors").
+ *
+ * Pairs are kept in insertion order. For pair j the state stores the bank
+ * indices (sorted uint32) of the rules that survived pairs 0 .. j-1 and also
+ * match pair j, with their depths on pair j; the last set is the survivor set.
+ *
+ * Adding a pair simulates only the current survivors on it. Removing pair k
+ * re-admits the rules that pair k had rejected: each later pair simulates only
+ * the re-admitted rules still alive and merges them into its stored set
+ * (removing the first pair therefore re-simulates most of the bank once).
+ */
+typedef struct AbductionState AbductionState;
+
+// The session must outlive the state.
+AbductionState* abduction_state_create(CASession* session);
+void abduction_state_destroy(AbductionState* state);
+
+// Add a training pair (flattened 4×4 x and y). Returns the number of survivors.
+int abduction_state_add_pair(AbductionState* state, const uint32_t* x_flat, const uint32_t* y_flat);
+
+// Remove pair `pair` (insertion order). Returns the number of survivors, -1 if out of range.
+int abduction_state_remove_pair(AbductionState* state, int pair);
+
+int abduction_state_num_pairs(const AbductionState* state);
+
+// Number of survivors; with no pairs every bank rule survives.
+int abduction_state_num_survivors(const AbductionState* state);
+
+/**
+ * Copy the survivors (ascending bank indices) into indices_out and, if depths_out
+ * is not NULL, their depths on every pair (num_survivors × num_pairs, row-major).
+ */
+void abduction_state_survivors(const AbductionState* state, uint32_t* indices_out, int32_t* depths_out);
+
+// Copy the training pairs (num_pairs × 16 each) in insertion order.
+void abduction_state_pairs(const AbductionState* state, uint32_t* xs_flat_out, uint32_t* ys_flat_out);
+
+/**
+ * Save the state with the session parameters it was computed under.
+ * File layout: "ABD1" magic, uint32 seed, int32 num_rules, boundary_mode,
+ * max_steps, family, num_pairs; then per pair uint16 x, uint16 y (matrix_hash),
+ * uint32 count, count uint32 indices and count int32 depths.
+ * Returns 0 on success, -1 on failure.
+ */
+int abduction_state_save(const AbductionState* state, const char* path);
+
+/**
+ * Read the session parameters stored in a state file, so a matching session can
+ * be created before abduction_state_load. Returns 0 on success, -1 if unreadable.
+ */
+int abduction_state_peek(const char* path, unsigned int* seed, int* num_rules, int* boundary_mode, int* max_steps, int* family);
+
+// Returns NULL if the file is unreadable or was saved under different session parameters.
+AbductionState* abduction_state_load(CASession* session, const char* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ABDUCTION_STATE_H
@@ -0,0 +1,61 @@
+#ifndef BDM_SCORING_H
+#define BDM_SCORING_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BDM_BLOCK_BITS 12                    // pybdm 1D block length (CTM-B2-D12)
+#define BDM_TABLE_SIZE (1 << BDM_BLOCK_BITS) // one CTM value per 12-bit block
+#define BDM_RULE_BLOCKS (512 / BDM_BLOCK_BITS)  // 42 blocks; the trailing 8 bits are ignored
+#define BDM_BYTE_ORDER 0x01020304u
+
+/**
+ * 1D block decomposition complexity of a 512-bit rule, matching pybdm's
+ * BDM(ndim=1).bdm(rule_to_1d_array(rule_int)): the rule is read as a binary
+ * string from its most significant bit, cut into non-overlapping 12-bit blocks
+ * (remainder ignored), and scored as sum over distinct blocks of
+ * CTM(block) + log2(multiplicity).
+ *
+ * @param rule_number   512-bit rule as 8 × uint64_t (compute_rule_number layout)
+ * @param ctm_table     BDM_TABLE_SIZE CTM values indexed by block value (first bit = MSB)
+ */
+double bdm_score_rule(const uint64_t* rule_number, const double* ctm_table);
+
+/**
+ * Score num_rules rules (num_rules × 8 uint64_t) in parallel.
+ *
+ * @param num_threads   Worker threads (<= 0: all online cores)
+ * @param scores_out    Output: num_rules scores
+ */
+void bdm_score_rules(
+    const uint64_t* rules_flat,
+    int num_rules,
+    const double* ctm_table,
+    int num_threads,
+    double* scores_out
+);
+
+/**
+ * Indices of the k lowest scores in ascending order (ties keep input order).
+ *
+ * @return Number of indices written (min(k, num_rules))
+ */
+int bdm_top_k(const double* scores, int num_rules, int k, int* indices_out);
+
+/**
+ * Read/write a CTM table file: "BDM2" magic, uint32 block bits, uint32
+ * byte-order marker (BDM_BYTE_ORDER), then 2^block_bits doubles. Numbers are in
+ * the writing host's byte order; a file from a host of the other byte order reads
+ * its marker byte-swapped and fails to load. Return 0 on success, -1 on failure.
+ */
+int bdm_load_ctm_table(const char* path, double* table_out);
+int bdm_save_ctm_table(const char* path, const double* table);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // BDM_SCORING_H
@@ -8,12 +8,80 @@
 extern "C" {
 #endif
 
+/**
+ * Rule families. Each family is parameterized by rule_family_bits(family) free bits
+ * and expands to a full Rule512 table.
+ *
+ * RULE_FAMILY_FULL:              every 512-bit table
+ * RULE_FAMILY_TOTALISTIC:        output depends on the number of ones in the 3×3 window (2^10)
+ * RULE_FAMILY_OUTER_TOTALISTIC:  output depends on the center and the number of ones among
+ *                                the 8 outer cells (2^18)
+ * RULE_FAMILY_SYMMETRIC:         output is invariant under rotations/reflections of the
+ *                                window (one bit per D4 orbit, 2^102)
+ */
+#define RULE_FAMILY_FULL 0
+#define RULE_FAMILY_TOTALISTIC 1
+#define RULE_FAMILY_OUTER_TOTALISTIC 2
+#define RULE_FAMILY_SYMMETRIC 3
+
+// Families with at most this many free bits can be enumerated exhaustively.
+#define RULE_FAMILY_MAX_ENUM_BITS 32
+
+/**
+ * Per-thread scratch for the packed simulation kernel: a generation-stamped
+ * visited set over all 2^16 binary 4×4 states.
+ */
+typedef struct {
+    uint32_t* stamps;     // 65536 entries; stamps[s] == generation means s was visited
+    uint32_t generation;
+} SimScratch;
+
 uint16_t get_neighborhood(const Matrix mat, int row, int col, int boundary_mode);
 void apply_rule(Matrix out, const Matrix in, const Rule512* rule, int boundary_mode);
 int simulate_with_depth(Matrix x_init, Matrix y_target, const Rule512* rule, int boundary_mode, int max_steps);
 void compute_rule_number(const Rule512* rule, uint64_t* out);
+void rule_from_number(Rule512* rule, const uint64_t* number);  // inverse of compute_rule_number
 void random_rule(Rule512* rule);
 
+// Number of free bits of a family, or -1 if unknown.
+int rule_family_bits(int family);
+// Expand family parameters (bit i of the family is bit i % 64 of params[i / 64]).
+void rule_family_expand(int family, const uint64_t* params, Rule512* rule);
+// Sample a rule uniformly from the family using the shared PRNG.
+void random_rule_in_family(Rule512* rule, int family);
+// Sample a rule uniformly among those with exactly `ones` of the 512 bits set.
+void random_rule_with_density(Rule512* rule, int ones);
+
+/**
+ * Packed kernel: states are the 16-bit matrix_hash of a binary matrix.
+ * simulate_packed_with_depth has the same contract as simulate_with_depth.
+ */
+uint16_t apply_rule_packed(uint16_t state, const Rule512* rule, int boundary_mode);
+int simulate_packed_with_depth(uint16_t x_init, uint16_t y_target, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch);
+/**
+ * Visited states from x_init, in order, until the first repeat or max_steps
+ * (the states simulate_rule_outputs reports). trail_out needs max_steps entries.
+ * Returns the number of states written.
+ */
+int simulate_packed_trajectory(uint16_t x_init, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch, uint16_t* trail_out);
+/**
+ * simulate_packed_trajectory that also ORs every neighborhood code the rule table is
+ * read at into used_mask (8 × uint64_t, code nb is bit nb % 64 of word nb / 64).
+ * Two rules that agree on those codes produce the same trajectory. trail_out may be NULL.
+ */
+int simulate_packed_trajectory_traced(uint16_t x_init, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch, uint16_t* trail_out, uint64_t* used_mask);
+/**
+ * Row-level form of the rule: table[(top << 8) | (mid << 4) | bot] is the output
+ * row nibble of a row `mid` between rows `top` and `bot` (4096 entries; rows as
+ * in matrix_hash, leftmost cell in the high bit). Column boundaries follow
+ * boundary_mode; row boundaries are left to the caller.
+ */
+void rule_row_table(const Rule512* rule, int boundary_mode, uint8_t* table);
+SimScratch* sim_scratch_create(void);
+void sim_scratch_free(SimScratch* scratch);
+// Starts a new visited set and returns its stamp value.
+uint32_t sim_scratch_begin(SimScratch* scratch);
+
 #ifdef __cplusplus
 }
 #endif
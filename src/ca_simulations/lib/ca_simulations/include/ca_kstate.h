@@ -0,0 +1,91 @@
+#ifndef CA_KSTATE_H
+#define CA_KSTATE_H
+
+#include <stdint.h>
+#include "matrix_utils.h"  // defines Matrix, MATRIX_SIZE
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define KSTATE_MAX_COLORS 10  // ARC palette
+#define KSTATE_PLANES 4       // ceil(log2(KSTATE_MAX_COLORS)) bit-planes per grid
+
+/**
+ * Compact k-state rule families.
+ *
+ * KSTATE_TOTALISTIC:        next = table[s9], s9 = sum of the 9 cell colors in the 3×3 window
+ *                           (table size 9·(k-1) + 1)
+ * KSTATE_OUTER_TOTALISTIC:  next = table[center · (8·(k-1) + 1) + s8], s8 = sum of the 8 outer colors
+ *                           (table size k · (8·(k-1) + 1))
+ */
+#define KSTATE_TOTALISTIC 0
+#define KSTATE_OUTER_TOTALISTIC 1
+
+#define KSTATE_MAX_TABLE (KSTATE_MAX_COLORS * (8 * (KSTATE_MAX_COLORS - 1) + 1))  // 730
+
+/**
+ * A k-state grid stored as bit-planes: bits [16·b, 16·b + 15] hold plane b, where
+ * bit (row * MATRIX_SIZE + col) of plane b is bit b of that cell's color.
+ */
+typedef uint64_t KState;
+
+typedef struct {
+    int num_colors;                   // k, 2..KSTATE_MAX_COLORS
+    int family;                       // KSTATE_TOTALISTIC or KSTATE_OUTER_TOTALISTIC
+    uint8_t table[KSTATE_MAX_TABLE];  // only the first kstate_table_size() entries are used
+} KRule;
+
+/**
+ * Number of table entries for a (family, num_colors) pair, or -1 if unsupported.
+ */
+int kstate_table_size(int family, int num_colors);
+
+KState kstate_from_matrix(const Matrix m);
+void kstate_to_matrix(Matrix out, KState s);
+
+/**
+ * Advance a bit-plane grid by one step. Neighborhood color sums for all 16 cells are
+ * computed at once with bit-sliced adders over shifted planes.
+ */
+KState kstate_apply_rule(KState in, const KRule* rule, int boundary_mode);
+
+/**
+ * Per-thread scratch for k-state simulation: a hashed, generation-stamped visited
+ * set sized for trajectories of up to max_steps states (k-state grids have up to
+ * 2^64 states, so the binary kernel's direct-indexed SimScratch does not apply).
+ */
+typedef struct {
+    KState* keys;
+    uint32_t* stamps;     // stamps[h] == generation means keys[h] is in the set
+    uint32_t generation;
+    int bits;             // 2^bits slots, at least twice max_steps
+} KStateScratch;
+
+// max_steps <= 0 means the default.
+KStateScratch* kstate_scratch_create(int max_steps);
+void kstate_scratch_free(KStateScratch* scratch);
+
+/**
+ * Same contract as simulate_with_depth: first step t at which y_target is reached,
+ * or -1 if a cycle closes first or max_steps is exhausted. max_steps must not
+ * exceed the one the scratch was created for.
+ */
+int kstate_simulate_with_depth(KState x_init, KState y_target, const KRule* rule, int boundary_mode, int max_steps, KStateScratch* scratch);
+
+/**
+ * Visited states from x_init, in order, until the first repeat or max_steps.
+ * trail_out needs max_steps entries. Returns the number of states written.
+ */
+int kstate_simulate_trajectory(KState x_init, const KRule* rule, int boundary_mode, int max_steps, KStateScratch* scratch, KState* trail_out);
+
+/**
+ * Sample a rule uniformly from the family using the shared PRNG (see prng_seed).
+ */
+void kstate_random_rule(KRule* rule, int family, int num_colors);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CA_KSTATE_H
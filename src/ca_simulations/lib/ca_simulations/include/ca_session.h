@@ -0,0 +1,118 @@
+#ifndef CA_SESSION_H
+#define CA_SESSION_H
+
+#include <stdint.h>
+#include "matrix_utils.h"           // for Rule512, Matrix
+#include "ca_dynamics.h"            // for SimScratch
+#include "parallel.h"               // for WorkerPool
+#include "simulate_rule_outputs.h"  // for OutputMap
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * A warm engine for repeated queries against one seeded rule bank.
+ *
+ * The bank holds exactly the rules simulate_rule_matches generates for the same
+ * seed, in the same order, both as Rule512 tables and as 512-bit numbers. Scratch
+ * buffers and worker threads are created once; the SIGINT handler is installed
+ * once at creation and the flag is cleared at the start of every query.
+ */
+typedef struct {
+    unsigned int seed;
+    int num_rules;
+    int boundary_mode;
+    int max_steps;
+
+    Rule512* rules;          // num_rules rule tables
+    uint64_t* rule_numbers;  // num_rules × 8, compute_rule_number layout
+
+    WorkerPool* pool;
+    SimScratch** scratch;    // one per worker
+    uint16_t** trails;       // one max_steps state buffer per worker
+
+    int family;              // RULE_FAMILY_* the bank was sampled from
+} CASession;
+
+/**
+ * @param seed            Random seed for rule generation (as in simulate_rule_matches)
+ * @param num_rules       Number of rules in the bank
+ * @param boundary_mode   1 = toroidal, 0 = zero-padded
+ * @param max_steps       Maximum simulation steps per rule (<= 0: default)
+ * @param num_threads     Worker threads (<= 0: all online cores)
+ */
+CASession* ca_session_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads);
+
+/**
+ * Same, but the bank is sampled with random_rule_in_family (any RULE_FAMILY_*,
+ * including the non-enumerable RULE_FAMILY_SYMMETRIC). RULE_FAMILY_FULL gives
+ * exactly the ca_session_create bank. Returns NULL for an unknown family.
+ */
+CASession* ca_session_create_in_family(unsigned int seed, int num_rules, int family, int boundary_mode, int max_steps, int num_threads);
+void ca_session_destroy(CASession* session);
+
+/**
+ * Same results as simulate_rule_matches over the session bank, but matches are
+ * reported as bank indices (ascending); look numbers up in session->rule_numbers.
+ * Free with ca_session_free_matches.
+ */
+void ca_session_matches(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths,
+    int* match_counts
+);
+
+void ca_session_free_matches(
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths
+);
+
+/**
+ * Counts-only query for conditional CTM: per pair, the number of bank rules that
+ * reach y from x and the smallest such depth (-1 if none). The sweep is rule-major,
+ * so every rule is decoded once for all pairs.
+ */
+void ca_session_ctm(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int* match_counts,
+    int* min_depths
+);
+
+/**
+ * Same results as simulate_rule_outputs for the given bank indices
+ * (rule_indices == NULL means the whole bank). Free with free_output_maps.
+ */
+void ca_session_outputs(
+    CASession* session,
+    const uint32_t* x_flat,
+    const int* rule_indices,
+    int num_indices,
+    OutputMap** output_maps_out
+);
+
+/**
+ * Same results as simulate_rule_outputs for arbitrary rules (num_rules × 8
+ * uint64_t), using the session's threads and scratch buffers.
+ */
+void ca_session_outputs_for_rules(
+    CASession* session,
+    const uint32_t* x_flat,
+    const uint64_t* rules_flat,
+    int num_rules,
+    OutputMap** output_maps_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CA_SESSION_H
@@ -0,0 +1,77 @@
+#ifndef CTM_SERVER_H
+#define CTM_SERVER_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Conditional-CTM query server over one warm rule bank (a CASession).
+ *
+ * Queries that arrive within batch_window_us of the oldest pending query are
+ * coalesced (up to max_batch_pairs pairs) into one rule-major ca_session_ctm
+ * sweep, and each caller gets back its own per-pair match counts and minimum
+ * depths. Queries come from in-process callers (ctm_server_submit) or, once
+ * ctm_server_listen has been called, from ctm_client_query over a Unix socket.
+ *
+ * Wire format (native endianness): a request is "CTMQ", uint32 num_pairs, then
+ * num_pairs × 16 uint8 input cells and num_pairs × 16 uint8 target cells; the
+ * reply is int32 status followed by num_pairs × (int32 count, int32 min_depth).
+ */
+typedef struct CTMServer CTMServer;
+
+typedef struct {
+    uint64_t queries;          // answered queries
+    uint64_t pairs;            // answered (x, y) pairs
+    uint64_t batches;          // rule sweeps run
+    int queue_depth;           // queries waiting right now
+    int max_queue_depth;       // largest queue seen
+    int last_batch_queries;
+    int max_batch_queries;
+    int max_batch_pairs;
+    double mean_batch_pairs;   // pairs / batches
+    double sweep_seconds;      // total time spent in sweeps
+} CTMServerMetrics;
+
+#define CTM_SERVER_MAX_PAIRS 65536  // per query
+
+/**
+ * @param seed, num_rules, boundary_mode, max_steps, num_threads   As in ca_session_create
+ * @param batch_window_us    Latency budget: how long the oldest query may wait for company
+ * @param max_batch_pairs    A sweep starts early once this many pairs are queued (<= 0: no limit)
+ */
+CTMServer* ctm_server_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads,
+                             int batch_window_us, int max_batch_pairs);
+
+/**
+ * Blocking in-process query: match_counts[i] / num_rules is m(y_i|x_i).
+ * @return 0 on success, -1 if the server is shutting down or the query is too large
+ */
+int ctm_server_submit(CTMServer* server, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                      int* match_counts, int* min_depths);
+
+/**
+ * Accept ctm_client_query connections on a Unix socket (an existing file at
+ * socket_path is replaced). Returns 0 on success, -1 on socket errors.
+ */
+int ctm_server_listen(CTMServer* server, const char* socket_path);
+
+void ctm_server_metrics(CTMServer* server, CTMServerMetrics* metrics);
+
+// Stops listening, answers the queries already queued and frees the server.
+void ctm_server_destroy(CTMServer* server);
+
+/**
+ * One query against a listening server.
+ * @return 0 on success, -1 on connection or protocol errors
+ */
+int ctm_client_query(const char* socket_path, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                     int* match_counts, int* min_depths);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CTM_SERVER_H
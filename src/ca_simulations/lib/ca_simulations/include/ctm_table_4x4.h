@@ -0,0 +1,73 @@
+#ifndef CTM_TABLE_4X4_H
+#define CTM_TABLE_4X4_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CTM4X4_ENTRIES 65536  // one entry per binary 4×4 matrix, indexed by matrix_hash
+#define CTM4X4_BYTE_ORDER 0x01020304u
+
+#define CTM4X4_MODE_ABSOLUTE 0  // keep |c_i - c_test| <= threshold
+#define CTM4X4_MODE_PERCENT 1   // keep |c_i - c_test| / c_test <= threshold
+
+/**
+ * Dense complexity table for 4×4 binary matrices, memory-mapped read-only.
+ * Missing entries (matrices without a CTM value) are stored as NaN.
+ *
+ * File layout: "CTM4" magic, uint32 entry count, uint32 byte-order marker
+ * (CTM4X4_BYTE_ORDER), 4 bytes padding, then CTM4X4_ENTRIES doubles. As in the
+ * rule bank and BDM table files, numbers are in the writing host's byte order so
+ * the values can be used straight from the mapping; a file from a host of the
+ * other byte order reads its marker byte-swapped and is rejected.
+ */
+typedef struct {
+    const double* values;  // CTM4X4_ENTRIES values
+    void* mapping;
+    size_t mapping_size;
+} CTMTable4x4;
+
+// Returns NULL if the file is missing, malformed or of the other byte order.
+CTMTable4x4* ctm4x4_open(const char* path);
+void ctm4x4_close(CTMTable4x4* table);
+
+// Write a table file from CTM4X4_ENTRIES values. Returns 0 on success, -1 on failure.
+int ctm4x4_write(const char* path, const double* values);
+
+/**
+ * Complexity of num_grids flattened 4×4 grids (num_grids × 16).
+ */
+void ctm4x4_lookup_batch(
+    const CTMTable4x4* table,
+    const uint32_t* grids_flat,
+    int num_grids,
+    double* complexities_out
+);
+
+/**
+ * Complexity filter of training inputs against a test input, as in
+ * AlgorithmicAbductionInduction.filter_by_ctm_input. Inputs without a table
+ * entry are dropped.
+ *
+ * @param keep_out   Output: num_grids flags (1 = retained)
+ * @return           Number of retained grids, or -1 if x_test has no table entry
+ *                   or mode is unknown
+ */
+int ctm4x4_filter(
+    const CTMTable4x4* table,
+    const uint32_t* xs_flat,
+    int num_grids,
+    const uint32_t* x_test_flat,
+    int mode,
+    double threshold,
+    uint8_t* keep_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // CTM_TABLE_4X4_H
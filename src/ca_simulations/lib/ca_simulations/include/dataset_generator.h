@@ -0,0 +1,83 @@
+#ifndef DATASET_GENERATOR_H
+#define DATASET_GENERATOR_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define GEN_TRANSFORM_BIT_INVERSION 0  // y = 1 - x
+#define GEN_TRANSFORM_CA_RULE 1        // y = depth applications of a random per-task rule
+
+#define DATASET_MAGIC "AARCDS1"        // 8 bytes including the terminator
+#define DATASET_VERSION 1
+
+/**
+ * Binary dataset layout: a 64-byte DatasetHeader followed by num_tasks fixed-size
+ * records. Each record holds the task rule (8 × uint64_t, compute_rule_number
+ * layout; zero for non-CA transformations) followed by 2 · (num_train + num_test)
+ * grids as uint16_t matrix_hash keys, ordered train inputs, train outputs, test
+ * inputs, test outputs, padded to record_size bytes.
+ */
+typedef struct {
+    char magic[8];
+    uint32_t version;
+    uint32_t num_tasks;
+    uint32_t num_train;
+    uint32_t num_test;
+    uint32_t transformation;
+    int32_t boundary_mode;
+    int32_t depth;
+    uint32_t record_size;
+    uint64_t seed;
+    uint8_t reserved[16];
+} DatasetHeader;
+
+typedef struct {
+    const DatasetHeader* header;
+    const uint8_t* records;
+    void* mapping;
+    size_t mapping_size;
+} Dataset;
+
+/**
+ * Generate num_tasks tasks in parallel and write them to `path`. Every task draws
+ * its distinct input grids (and rule) from its own splitmix64 stream derived from
+ * (seed, task index), so the file does not depend on num_threads.
+ *
+ * @return 0 on success, -1 on invalid arguments or I/O failure
+ */
+int generate_dataset(
+    const char* path,
+    int num_tasks,
+    int num_train,
+    int num_test,
+    int transformation,
+    int depth,
+    uint64_t seed,
+    int boundary_mode,
+    int num_threads
+);
+
+// Memory-map a dataset file read-only. Returns NULL if missing or malformed.
+Dataset* dataset_open(const char* path);
+void dataset_close(Dataset* dataset);
+
+const uint64_t* dataset_task_rule(const Dataset* dataset, int task);
+const uint16_t* dataset_task_grids(const Dataset* dataset, int task);
+
+/**
+ * Write tasks [first_task, first_task + count) as JSON files in the format of
+ * AlgorithmicARCDatasetBuilder (task_<id>_<transformation>_<seed>.json, id = task + 1).
+ *
+ * @return Number of files written, or -1 on I/O failure
+ */
+int dataset_export_json(const Dataset* dataset, const char* output_dir, int first_task, int count);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // DATASET_GENERATOR_H
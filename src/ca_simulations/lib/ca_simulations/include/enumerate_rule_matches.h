@@ -0,0 +1,64 @@
+#ifndef ENUMERATE_RULE_MATCHES_H
+#define ENUMERATE_RULE_MATCHES_H
+
+#include <stdint.h>
+#include "matrix_utils.h"  // includes Rule512, RULE_BYTES, Matrix
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Exhaustive counterpart of simulate_rule_matches: every rule of an enumerable
+ * family (rule_family_bits(family) <= RULE_FAMILY_MAX_ENUM_BITS) is simulated once,
+ * so m(y|x) = match_counts[i] / family_size is exact. The family index range is
+ * split across num_threads threads; matches are reported in family-index order.
+ *
+ * @param xs_flat              Flattened 4×4 input matrices (num_pairs × 16)
+ * @param ys_flat              Flattened 4×4 target matrices (num_pairs × 16)
+ * @param num_pairs            Number of (x, y) pairs
+ * @param family               RULE_FAMILY_* identifier (see ca_dynamics.h)
+ * @param boundary_mode        1 = toroidal, 0 = zero-padded
+ * @param max_steps            Maximum simulation steps per rule
+ * @param num_threads          Worker threads (<= 0: all online cores)
+ * @param match_rule_numbers   Output: per pair, 512-bit numbers of matching rules
+ * @param match_rule_depths    Output: per pair, depth at which y was reached
+ * @param match_counts         Output: per pair, number of matching rules
+ * @return                     Family size, or 0 if the family cannot be enumerated
+ */
+uint64_t enumerate_rule_matches(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint64_t*** match_rule_numbers,
+    int** match_rule_depths,
+    int* match_counts
+);
+
+/**
+ * Counts-only variant for CTM estimates: per pair, the number of matching rules
+ * and the smallest depth at which y was reached (-1 if never).
+ *
+ * @return Family size, or 0 if the family cannot be enumerated
+ */
+uint64_t enumerate_rule_ctm(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint64_t* match_counts,
+    int* min_depths
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // ENUMERATE_RULE_MATCHES_H
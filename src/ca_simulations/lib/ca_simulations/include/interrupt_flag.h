@@ -4,6 +4,9 @@
 // Initializes SIGINT handler
 void init_interrupt_flag(void);
 
+// Clears a previously received SIGINT without reinstalling the handler
+void reset_interrupt_flag(void);
+
 // Checks if SIGINT was received
 int is_interrupted(void);
 
@@ -15,6 +15,7 @@ typedef struct {
 void copy_matrix(Matrix dst, const Matrix src);
 int matrix_equals(const Matrix a, const Matrix b);
 uint64_t matrix_hash(const Matrix m);
+void hash_to_matrix(Matrix out, uint64_t h);  // inverse of matrix_hash for binary matrices
 void flat_to_matrix(Matrix out, const uint32_t* flat);
 void matrix_to_flat(uint32_t* flat, const Matrix in);
 void print_matrix(const Matrix m);
@@ -0,0 +1,40 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Work callback for parallel_for: process items [begin, end) on thread `thread_id`.
+ */
+typedef void (*parallel_range_fn)(void* ctx, int thread_id, int64_t begin, int64_t end);
+
+// Returns `requested` if positive, otherwise the number of online cores.
+int resolve_num_threads(int requested);
+
+/**
+ * Split [0, n) into contiguous, ordered chunks (chunk t goes to thread t) and run
+ * them on up to num_threads POSIX threads. Returns when every chunk is done.
+ */
+void parallel_for(int num_threads, int64_t n, parallel_range_fn fn, void* ctx);
+
+/**
+ * Persistent worker threads with the same chunking contract as parallel_for,
+ * for callers that run many short jobs. Concurrent worker_pool_run calls on one
+ * pool are serialized.
+ */
+typedef struct WorkerPool WorkerPool;
+
+WorkerPool* worker_pool_create(int num_threads);
+int worker_pool_size(const WorkerPool* pool);
+void worker_pool_run(WorkerPool* pool, int64_t n, parallel_range_fn fn, void* ctx);
+void worker_pool_destroy(WorkerPool* pool);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PARALLEL_H
@@ -0,0 +1,83 @@
+#ifndef PREIMAGE_CTM_H
+#define PREIMAGE_CTM_H
+
+#include <stdint.h>
+#include "matrix_utils.h"  // includes Rule512, RULE_BYTES, Matrix
+#include "ca_dynamics.h"   // for SimScratch
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Backward engine: which inputs x reach a fixed target y, and at what depth.
+ *
+ * An output row depends only on the input row and its two neighbours, so the
+ * predecessors of a state are found row by row: fix the first rows, and each
+ * further row must be one of the (few) rows that yield the required output
+ * below it. Walking these predecessors breadth-first from y visits every x whose
+ * trajectory reaches y, level d holding the x first reaching y after d steps —
+ * the depth simulate_with_depth reports.
+ */
+
+typedef struct {
+    uint8_t rows[4096];   // rule_row_table
+    uint16_t bots[4096];  // [(top << 8) | (mid << 4) | out] -> mask of bot rows yielding out
+    uint16_t any_top[256];  // [(mid << 4) | out] -> bots OR-ed over every top row
+} PreimageTable;
+
+void preimage_table_build(PreimageTable* table, const Rule512* rule, int boundary_mode);
+
+/**
+ * All states that map to `state` in one step, in ascending order.
+ * out needs room for 65536 entries. Returns the number of predecessors.
+ */
+int rule_preimages(uint16_t state, const PreimageTable* table, int boundary_mode, uint16_t* out);
+
+/**
+ * Breadth-first walk of the reverse graph from y_target over depths 0 .. max_steps - 1.
+ * states_out / depths_out (65536 entries each) receive every x that reaches y_target
+ * with its depth, in nondecreasing depth order. Returns the number of such x.
+ */
+int reverse_reach(
+    uint16_t y_target,
+    const PreimageTable* table,
+    int boundary_mode,
+    int max_steps,
+    SimScratch* scratch,
+    uint16_t* states_out,
+    int* depths_out
+);
+
+/**
+ * Column of the conditional CTM table for target y: for every input x (indexed by
+ * matrix_hash), the number of sampled rules that reach y from x and the smallest
+ * depth. The rules are the ones simulate_rule_matches draws for the same seed, so
+ * match_counts[x] equals its match count for the pair (x, y).
+ *
+ * @param y_flat          Flattened 4×4 target matrix
+ * @param seed            Random seed for rule generation
+ * @param num_rules       Number of rules to sample
+ * @param boundary_mode   1 = toroidal, 0 = zero-padded
+ * @param max_steps       Maximum simulation steps per rule
+ * @param num_threads     Worker threads (<= 0: all online cores)
+ * @param match_counts    Output: 65536 counts
+ * @param min_depths      Output: 65536 smallest depths (-1 if never reached)
+ * @return                Number of rules drawn (the sweep stops early on SIGINT)
+ */
+int preimage_ctm(
+    uint32_t* y_flat,
+    unsigned int seed,
+    int num_rules,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    int* match_counts,
+    int* min_depths
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // PREIMAGE_CTM_H
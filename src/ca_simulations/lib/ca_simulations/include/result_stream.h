@@ -0,0 +1,85 @@
+#ifndef RESULT_STREAM_H
+#define RESULT_STREAM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "ca_session.h"  // for CASession
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Streaming counterparts of ca_session_matches / ca_session_outputs.
+ *
+ * A background thread sweeps the rules in blocks (using the session's workers)
+ * and writes fixed-size records into a ring of num_chunks chunks of
+ * chunk_records records each. result_stream_next copies out the oldest
+ * complete chunk; when every chunk is full the sweep waits for the consumer.
+ * A block stops taking rules once it holds as many records as the ring, so
+ * memory stays bounded by about twice the ring plus one trajectory per worker.
+ * Records come in rule order, exactly as the blocking calls would list them.
+ *
+ * Records carry the rule's index only: its number is stored once, in the
+ * session bank (session->rule_numbers) or the caller's rules_flat.
+ */
+
+typedef struct {
+    int32_t rule_index;       // bank index
+    int32_t pair;
+    int32_t depth;
+} StreamMatch;
+
+typedef struct {
+    int32_t rule_index;       // position in rules_flat
+    int32_t depth;
+    uint16_t state;           // matrix_hash of the output
+    uint16_t reserved;
+} StreamOutput;
+
+typedef struct ResultStream ResultStream;
+
+/**
+ * Stream StreamMatch records: every bank rule that reaches ys[i] from xs[i].
+ * The session must outlive the stream and must not be destroyed while it runs.
+ */
+ResultStream* result_stream_matches(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int chunk_records,
+    int num_chunks
+);
+
+/**
+ * Stream StreamOutput records: the states each rule (num_rules × 8 uint64_t)
+ * visits from x, as simulate_rule_outputs reports them.
+ */
+ResultStream* result_stream_outputs(
+    CASession* session,
+    const uint32_t* x_flat,
+    const uint64_t* rules_flat,
+    int num_rules,
+    int chunk_records,
+    int num_chunks
+);
+
+/**
+ * Copy the next chunk into buffer (room for chunk_records records), blocking
+ * until one is complete. Returns the number of records, 0 once the sweep is
+ * done, or -1 once the records before a SIGINT have been read.
+ */
+int result_stream_next(ResultStream* stream, void* buffer);
+
+// Most records the sweep has held outside the ring at once (for monitoring).
+size_t result_stream_peak_records(ResultStream* stream);
+
+// Stops the sweep if it is still running and frees the stream.
+void result_stream_close(ResultStream* stream);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RESULT_STREAM_H
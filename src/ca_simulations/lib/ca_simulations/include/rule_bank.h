@@ -0,0 +1,110 @@
+#ifndef RULE_BANK_H
+#define RULE_BANK_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "matrix_utils.h"           // for Rule512, Matrix
+#include "simulate_rule_outputs.h"  // for OutputMap
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define RULE_BANK_ENCODING_NUMBERS 0  // compute_rule_number layout, 8 × uint64_t per rule
+#define RULE_BANK_BYTE_ORDER 0x01020304u
+
+/**
+ * Seeded rule bank stored on disk and memory-mapped read-only, so that worker
+ * processes share one page-cached copy instead of regenerating or receiving rules.
+ *
+ * File layout: "RBK1" magic, uint32 encoding, uint32 seed, uint32 byte-order
+ * marker (RULE_BANK_BYTE_ORDER), uint64 rule count, padding to 64 bytes, then
+ * count × 8 uint64_t (the rules_flat layout simulate_rule_outputs consumes).
+ * Integers are in the writing host's byte order, so the rules can be used
+ * straight from the mapping; a file written on a host of the other byte order
+ * reads its marker byte-swapped and is rejected.
+ *
+ * The query entry points below touch no global state (no shared PRNG, no
+ * interrupt flag) and run on the calling thread, so any number of processes or
+ * threads can query disjoint or overlapping index ranges [begin, end) concurrently.
+ */
+typedef struct {
+    unsigned int seed;
+    int encoding;
+    int num_rules;
+    const uint64_t* rule_numbers;  // num_rules × 8
+    void* mapping;
+    size_t mapping_size;
+} RuleBank;
+
+/**
+ * Write the num_rules rules simulate_rule_matches draws for seed, in order.
+ * Uses the shared PRNG. Returns 0 on success, -1 on failure.
+ */
+int rule_bank_write(const char* path, unsigned int seed, int num_rules);
+
+// Returns NULL if the file is missing, malformed or of the other byte order.
+RuleBank* rule_bank_open(const char* path);
+void rule_bank_close(RuleBank* bank);
+
+/**
+ * simulate_rule_matches restricted to bank rules [begin, end). Matches are
+ * reported as bank indices (ascending). Free with rule_bank_free_matches.
+ */
+void rule_bank_matches(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int boundary_mode,
+    int max_steps,
+    int** match_rule_indices,
+    int** match_rule_depths,
+    int* match_counts
+);
+
+void rule_bank_free_matches(
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths
+);
+
+/**
+ * Counts-only form of rule_bank_matches: per pair, the number of rules in
+ * [begin, end) that reach y from x and the smallest such depth (-1 if none).
+ * Counts over disjoint ranges add up.
+ */
+void rule_bank_ctm(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int boundary_mode,
+    int max_steps,
+    int* match_counts,
+    int* min_depths
+);
+
+/**
+ * simulate_rule_outputs for bank rules [begin, end): output_maps_out receives
+ * end - begin maps. Free with free_output_maps.
+ */
+void rule_bank_outputs(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* x_flat,
+    int boundary_mode,
+    int max_steps,
+    OutputMap** output_maps_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RULE_BANK_H
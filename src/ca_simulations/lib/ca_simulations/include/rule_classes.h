@@ -0,0 +1,50 @@
+#ifndef RULE_CLASSES_H
+#define RULE_CLASSES_H
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Group rules that are indistinguishable on a set of start states.
+ *
+ * Each rule is run from every x in xs_flat (until the first repeated state or
+ * max_steps, as in simulate_rule_outputs) while recording the neighborhood
+ * codes its table is read at. Rules with the same recorded codes and the same
+ * table bits at those codes produce identical trajectories from every x, so
+ * one representative per class, weighted by the class size, gives exactly the
+ * per-rule counts, depths and outputs for those inputs.
+ *
+ * Classes are numbered by first appearance; the representative of a class is
+ * its first rule in input order.
+ *
+ * @param rules_flat        num_rules × 8 uint64_t (compute_rule_number layout)
+ * @param xs_flat           Flattened 4×4 start matrices (num_xs × 16)
+ * @param num_threads       Worker threads (<= 0: all online cores)
+ * @param class_of          Output: class index of every rule (num_rules)
+ * @param representatives   Output: rule index of each class (capacity num_rules)
+ * @param multiplicities    Output: number of rules in each class (capacity num_rules)
+ * @param used_codes        Output (may be NULL): number of distinct codes each class reads
+ * @return                  Number of classes
+ */
+int rule_equivalence_classes(
+    const uint64_t* rules_flat,
+    int num_rules,
+    const uint32_t* xs_flat,
+    int num_xs,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    int* class_of,
+    int* representatives,
+    int* multiplicities,
+    int* used_codes
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // RULE_CLASSES_H
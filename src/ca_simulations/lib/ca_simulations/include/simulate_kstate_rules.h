@@ -0,0 +1,98 @@
+#ifndef SIMULATE_KSTATE_RULES_H
+#define SIMULATE_KSTATE_RULES_H
+
+#include <stdint.h>
+#include "matrix_utils.h"  // for Matrix
+#include "ca_kstate.h"     // for KSTATE_MAX_TABLE, rule families
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * k-state counterpart of simulate_rule_matches. Rules are sampled from `family`
+ * with `num_colors` colors; each match is reported as its rule table
+ * (kstate_table_size(family, num_colors) bytes) instead of a 512-bit number.
+ *
+ * @param xs_flat              Flattened 4×4 input matrices (num_pairs × 16), colors in [0, num_colors)
+ * @param ys_flat              Flattened 4×4 target matrices (num_pairs × 16)
+ * @param num_pairs            Number of (x, y) pairs
+ * @param num_rules            Number of random rules to simulate
+ * @param seed                 Random seed for rule generation
+ * @param num_colors           Number of cell colors k
+ * @param family               KSTATE_TOTALISTIC or KSTATE_OUTER_TOTALISTIC
+ * @param boundary_mode        1 = toroidal, 0 = zero-padded
+ * @param max_steps            Maximum simulation steps per rule
+ * @param num_threads          Worker threads splitting the rules (<= 0: all online cores)
+ * @param match_rule_tables    Output: per pair, array of matching rule tables
+ * @param match_rule_depths    Output: per pair, depth at which y was reached
+ * @param match_counts         Output: per pair, number of matching rules
+ */
+void simulate_kstate_matches(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int num_rules,
+    unsigned int seed,
+    int num_colors,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint8_t*** match_rule_tables,
+    int** match_rule_depths,
+    int* match_counts
+);
+
+void free_kstate_matches(
+    int num_pairs,
+    int* match_counts,
+    int** match_rule_depths,
+    uint8_t*** match_rule_tables
+);
+
+/**
+ * Struct to hold simulation outputs for a single k-state rule.
+ */
+typedef struct {
+    uint8_t table[KSTATE_MAX_TABLE];  // Rule table (first table_size entries)
+    Matrix* outputs;                  // Array of output matrices
+    int* depths;                      // Corresponding step/depth for each output
+    int num_outputs;                  // Number of outputs found
+} KOutputMap;
+
+/**
+ * k-state counterpart of simulate_rule_outputs.
+ *
+ * @param x_flat             Flattened 4×4 input matrix (length 16)
+ * @param tables_flat        Rule tables, num_rules × kstate_table_size(family, num_colors) bytes
+ * @param num_rules          Number of rules
+ * @param num_colors         Number of cell colors k
+ * @param family             KSTATE_TOTALISTIC or KSTATE_OUTER_TOTALISTIC
+ * @param boundary_mode      1 = toroidal, 0 = zero-padded
+ * @param max_steps          Max simulation steps
+ * @param num_threads        Worker threads splitting the rules (<= 0: all online cores)
+ * @param output_maps_out    Output: array of KOutputMap[num_rules]
+ */
+void simulate_kstate_outputs(
+    uint32_t* x_flat,
+    uint8_t* tables_flat,
+    int num_rules,
+    int num_colors,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    KOutputMap** output_maps_out
+);
+
+void free_kstate_output_maps(
+    int num_rules,
+    KOutputMap* output_maps
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // SIMULATE_KSTATE_RULES_H
@@ -0,0 +1,100 @@
+#ifndef TASK_RUNNER_H
+#define TASK_RUNNER_H
+
+#include <stdint.h>
+#include "ca_session.h"  // for CASession
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Native counterpart of AlgorithmicAbductionInduction.run over a directory of
+ * task files (the JSON format of AlgorithmicARCDatasetBuilder).
+ *
+ * Per task: abduction keeps the bank rules that map every train input to its
+ * output; ranking (top_k > 0) keeps the top_k of them by BDM score; induction
+ * runs those rules from each test input and collects the visited states; each
+ * candidate y' gets k_ctm = -log2(count / num_rules) + log2(t_min), and the
+ * prediction is the candidate with t_min > 0 and the smallest finite k_ctm
+ * (ties go to the candidate seen first, in bank order).
+ *
+ * Tasks run in parallel over one shared rule bank; with fewer tasks than
+ * threads they run one at a time, each abduction sweep split over the bank
+ * session's workers.
+ */
+
+#define RUNNER_STAGE_PARSE 0
+#define RUNNER_STAGE_ABDUCTION 1
+#define RUNNER_STAGE_RANKING 2
+#define RUNNER_STAGE_INDUCTION 3
+#define RUNNER_STAGE_SELECTION 4
+#define RUNNER_NUM_STAGES 5
+
+typedef struct {
+    unsigned int seed;
+    int num_rules;
+    int boundary_mode;
+    int max_steps;
+    int top_k;                    // <= 0: no ranking
+    const char* bdm_table_path;   // bdm_save_ctm_table file, required when top_k > 0
+    int num_threads;              // <= 0: all online cores
+} RunnerOptions;
+
+typedef struct {
+    char* name;                   // file name within the task directory
+    int num_train;
+    int num_test;
+    uint16_t* train_inputs;       // matrix_hash keys
+    uint16_t* train_outputs;
+    uint16_t* test_inputs;
+    uint16_t* test_outputs;       // may be absent (has_test_outputs == 0)
+    int has_test_outputs;
+} RunnerTask;
+
+typedef struct {
+    int num_abducted;             // rules matching every train pair
+    int num_ranked;               // rules used for induction
+    int* num_candidates;          // per test input: distinct y' reached
+    int* has_prediction;          // per test input
+    uint16_t* predictions;        // per test input, matrix_hash key
+    double* k_ctm;                // per test input, k_ctm of the prediction
+    int* correct;                 // per test input: 1/0, or -1 without a test output
+    double seconds[RUNNER_NUM_STAGES];
+} TaskResult;
+
+/**
+ * Parse one task file. Grids must be 4×4 and binary.
+ * @return 0 on success, -1 on I/O or format errors
+ */
+int runner_load_task(const char* path, RunnerTask* task);
+void runner_free_task(RunnerTask* task);
+
+/**
+ * Run the pipeline for num_tasks tasks against the session bank. bdm_table is
+ * required when options->top_k > 0. Free each result with runner_free_result.
+ */
+void runner_run_tasks(
+    const CASession* bank,
+    const RunnerTask* tasks,
+    int num_tasks,
+    const RunnerOptions* options,
+    const double* bdm_table,
+    TaskResult* results
+);
+void runner_free_result(TaskResult* result);
+
+/**
+ * Load every *.json file of task_dir (in name order), run the pipeline and write
+ * predictions and per-stage timings to output_path as JSON.
+ *
+ * @return Number of tasks run, or -1 on errors (unreadable directory, task or
+ *         BDM table, or unwritable output)
+ */
+int runner_run_directory(const char* task_dir, const RunnerOptions* options, const char* output_path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TASK_RUNNER_H
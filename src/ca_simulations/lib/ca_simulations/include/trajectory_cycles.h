@@ -0,0 +1,85 @@
+#ifndef TRAJECTORY_CYCLES_H
+#define TRAJECTORY_CYCLES_H
+
+#include <stdint.h>
+#include "parallel.h"    // for WorkerPool
+#include "ca_session.h"  // for CASession
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * Cycle-compressed trajectories: the orbit of x under each rule, stored as its
+ * transient (the states before the cycle is entered) followed by one period of
+ * the cycle, as packed states (matrix_hash).
+ *
+ * There are only 2^16 states, so every orbit enters its cycle within 65536 steps
+ * and the form is exact: the session's max_steps does not truncate it, and the
+ * state at any step t is states[t] for t < transient, otherwise
+ * states[transient + (t - transient) % period]. A rule's stored states are
+ * distinct, and the first step at which y appears is its position among them
+ * (compare with max_steps to get simulate_with_depth's answer).
+ */
+typedef struct {
+    int num_rules;
+    uint64_t* offsets;     // num_rules + 1; rule r owns states[offsets[r] .. offsets[r + 1])
+    int32_t* transients;   // steps before the cycle is entered
+    int32_t* periods;      // cycle length (>= 1)
+    uint16_t* states;      // transient then one period, per rule
+    WorkerPool* pool;      // the session's, used by the batch queries
+} Trajectories;
+
+/**
+ * Orbits of x (flattened 4×4) under the given bank rules (rule_indices == NULL
+ * means the whole bank), in that order. The session must outlive the result.
+ * Returns NULL if interrupted by SIGINT.
+ */
+Trajectories* trajectories_build(
+    CASession* session,
+    const uint32_t* x_flat,
+    const int* rule_indices,
+    int num_indices
+);
+
+// Same, for arbitrary rules (num_rules × 8 uint64_t, compute_rule_number layout).
+Trajectories* trajectories_build_for_rules(
+    CASession* session,
+    const uint32_t* x_flat,
+    const uint64_t* rules_flat,
+    int num_rules
+);
+
+void trajectories_free(Trajectories* trajectories);
+
+/**
+ * Packed state of every rule at each of the steps ts: states_out[r * num_ts + k]
+ * is rule r's state after ts[k] steps. O(1) per entry, whatever the step.
+ */
+void trajectories_state_at(
+    const Trajectories* trajectories,
+    const uint64_t* ts,
+    int num_ts,
+    uint16_t* states_out
+);
+
+/**
+ * For every rule r and target ys[j] (flattened 4×4, num_ys of them), with
+ * k = r * num_ys + j:
+ *   depths_out[k]    first step at which the orbit is in ys[j], -1 if never;
+ *   on_cycle_out[k]  1 if ys[j] lies on the rule's cycle (is revisited forever).
+ * Either output may be NULL. Each orbit is scanned once for all targets.
+ */
+void trajectories_find(
+    const Trajectories* trajectories,
+    const uint32_t* ys_flat,
+    int num_ys,
+    int32_t* depths_out,
+    uint8_t* on_cycle_out
+);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  // TRAJECTORY_CYCLES_H
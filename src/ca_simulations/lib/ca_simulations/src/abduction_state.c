@@ -0,0 +1,339 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "ca_session.h"
+#include "abduction_state.h"
+
+#define ABDUCTION_MAGIC "ABD1"
+#define NUM_PARAMS 5  // num_rules, boundary_mode, max_steps, family, num_pairs
+
+typedef struct {
+    uint16_t x;
+    uint16_t y;
+    uint32_t* indices;  // ascending bank indices
+    int32_t* depths;    // depth on this pair
+    int count;
+} PairSet;
+
+struct AbductionState {
+    CASession* session;
+    PairSet* pairs;
+    int num_pairs;
+    int capacity;
+};
+
+static void* checked_malloc(size_t size) {
+    void* p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed for abduction state.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static uint16_t flat_key(const uint32_t* flat) {
+    Matrix m;
+    flat_to_matrix(m, flat);
+    return (uint16_t)matrix_hash(m);
+}
+
+// -------------------- Filtering --------------------
+
+typedef struct {
+    CASession* session;
+    uint16_t x;
+    uint16_t y;
+    const uint32_t* candidates;  // NULL: the whole bank
+    int32_t* depths;
+} FilterContext;
+
+static void filter_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    FilterContext* ctx = arg;
+    CASession* session = ctx->session;
+    SimScratch* scratch = session->scratch[thread_id];
+
+    for (int64_t k = begin; k < end; ++k) {
+        uint32_t r = ctx->candidates ? ctx->candidates[k] : (uint32_t)k;
+        ctx->depths[k] = simulate_packed_with_depth(ctx->x, ctx->y, &session->rules[r], session->boundary_mode, session->max_steps, scratch);
+    }
+}
+
+// The candidates (ascending) that reach y from x, kept in order.
+static void filter_candidates(CASession* session, uint16_t x, uint16_t y, const uint32_t* candidates, int n, PairSet* out) {
+    FilterContext ctx = {session, x, y, candidates, checked_malloc((size_t)n * sizeof(int32_t))};
+    worker_pool_run(session->pool, n, filter_range, &ctx);
+
+    int count = 0;
+    for (int k = 0; k < n; ++k) count += ctx.depths[k] >= 0;
+
+    out->x = x;
+    out->y = y;
+    out->indices = checked_malloc((size_t)count * sizeof(uint32_t));
+    out->depths = checked_malloc((size_t)count * sizeof(int32_t));
+    out->count = 0;
+    for (int k = 0; k < n; ++k) {
+        if (ctx.depths[k] < 0) continue;
+        out->indices[out->count] = candidates ? candidates[k] : (uint32_t)k;
+        out->depths[out->count] = ctx.depths[k];
+        out->count++;
+    }
+    free(ctx.depths);
+}
+
+// -------------------- Lifecycle --------------------
+
+AbductionState* abduction_state_create(CASession* session) {
+    AbductionState* state = calloc(1, sizeof(AbductionState));
+    if (!state) {
+        fprintf(stderr, "Memory allocation failed for abduction state.\n");
+        exit(EXIT_FAILURE);
+    }
+    state->session = session;
+    return state;
+}
+
+void abduction_state_destroy(AbductionState* state) {
+    if (!state) return;
+    for (int j = 0; j < state->num_pairs; ++j) {
+        free(state->pairs[j].indices);
+        free(state->pairs[j].depths);
+    }
+    free(state->pairs);
+    free(state);
+}
+
+static PairSet* append_pair(AbductionState* state) {
+    if (state->num_pairs == state->capacity) {
+        state->capacity = state->capacity ? 2 * state->capacity : 8;
+        state->pairs = realloc(state->pairs, state->capacity * sizeof(PairSet));
+        if (!state->pairs) {
+            fprintf(stderr, "Memory allocation failed for abduction state.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return &state->pairs[state->num_pairs++];
+}
+
+int abduction_state_num_pairs(const AbductionState* state) {
+    return state->num_pairs;
+}
+
+int abduction_state_num_survivors(const AbductionState* state) {
+    return state->num_pairs ? state->pairs[state->num_pairs - 1].count : state->session->num_rules;
+}
+
+// -------------------- Refinement --------------------
+
+int abduction_state_add_pair(AbductionState* state, const uint32_t* x_flat, const uint32_t* y_flat) {
+    const PairSet* last = state->num_pairs ? &state->pairs[state->num_pairs - 1] : NULL;
+    const uint32_t* domain = last ? last->indices : NULL;
+    int n = last ? last->count : state->session->num_rules;
+
+    PairSet added;
+    filter_candidates(state->session, flat_key(x_flat), flat_key(y_flat), domain, n, &added);
+    *append_pair(state) = added;
+    return added.count;
+}
+
+int abduction_state_remove_pair(AbductionState* state, int pair) {
+    if (pair < 0 || pair >= state->num_pairs) return -1;
+
+    // Rules the removed pair rejected from its domain: the bank, or the previous set.
+    const PairSet* removed = &state->pairs[pair];
+    const PairSet* previous = pair > 0 ? &state->pairs[pair - 1] : NULL;
+    int domain_size = previous ? previous->count : state->session->num_rules;
+
+    uint32_t* admitted = checked_malloc((size_t)(domain_size - removed->count) * sizeof(uint32_t));
+    int num_admitted = 0;
+    for (int k = 0, m = 0; k < domain_size; ++k) {
+        uint32_t r = previous ? previous->indices[k] : (uint32_t)k;
+        if (m < removed->count && removed->indices[m] == r) m++;
+        else admitted[num_admitted++] = r;
+    }
+
+    free(state->pairs[pair].indices);
+    free(state->pairs[pair].depths);
+    memmove(&state->pairs[pair], &state->pairs[pair + 1], (state->num_pairs - pair - 1) * sizeof(PairSet));
+    state->num_pairs--;
+
+    // Each later pair tests only the re-admitted rules still alive; its old set is disjoint from them.
+    for (int j = pair; j < state->num_pairs && num_admitted > 0; ++j) {
+        PairSet* set = &state->pairs[j];
+        PairSet extra;
+        filter_candidates(state->session, set->x, set->y, admitted, num_admitted, &extra);
+
+        uint32_t* indices = checked_malloc((size_t)(set->count + extra.count) * sizeof(uint32_t));
+        int32_t* depths = checked_malloc((size_t)(set->count + extra.count) * sizeof(int32_t));
+        int a = 0, b = 0, n = 0;
+        while (a < set->count || b < extra.count) {
+            if (b == extra.count || (a < set->count && set->indices[a] < extra.indices[b])) {
+                indices[n] = set->indices[a];
+                depths[n++] = set->depths[a++];
+            } else {
+                indices[n] = extra.indices[b];
+                depths[n++] = extra.depths[b++];
+            }
+        }
+
+        free(set->indices);
+        free(set->depths);
+        set->indices = indices;
+        set->depths = depths;
+        set->count = n;
+
+        free(admitted);
+        admitted = extra.indices;
+        num_admitted = extra.count;
+        free(extra.depths);
+    }
+    free(admitted);
+
+    return abduction_state_num_survivors(state);
+}
+
+// -------------------- Queries --------------------
+
+void abduction_state_survivors(const AbductionState* state, uint32_t* indices_out, int32_t* depths_out) {
+    int n = abduction_state_num_survivors(state);
+    if (state->num_pairs == 0) {
+        for (int k = 0; k < n; ++k) indices_out[k] = (uint32_t)k;
+        return;
+    }
+
+    memcpy(indices_out, state->pairs[state->num_pairs - 1].indices, (size_t)n * sizeof(uint32_t));
+    if (!depths_out) return;
+
+    // Survivors are a subset of every pair's set, so one merge walk per pair finds their depths.
+    for (int j = 0; j < state->num_pairs; ++j) {
+        const PairSet* set = &state->pairs[j];
+        int m = 0;
+        for (int k = 0; k < n; ++k) {
+            while (m < set->count && set->indices[m] < indices_out[k]) m++;
+            int found = m < set->count && set->indices[m] == indices_out[k];
+            depths_out[(size_t)k * state->num_pairs + j] = found ? set->depths[m] : -1;
+        }
+    }
+}
+
+void abduction_state_pairs(const AbductionState* state, uint32_t* xs_flat_out, uint32_t* ys_flat_out) {
+    for (int j = 0; j < state->num_pairs; ++j) {
+        for (int k = 0; k < 16; ++k) {
+            xs_flat_out[j * 16 + k] = (state->pairs[j].x >> (15 - k)) & 1;
+            ys_flat_out[j * 16 + k] = (state->pairs[j].y >> (15 - k)) & 1;
+        }
+    }
+}
+
+// -------------------- Persistence --------------------
+
+int abduction_state_save(const AbductionState* state, const char* path) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    const CASession* session = state->session;
+    uint32_t seed = session->seed;
+    int32_t params[NUM_PARAMS] = {session->num_rules, session->boundary_mode, session->max_steps, session->family, state->num_pairs};
+
+    int ok = fwrite(ABDUCTION_MAGIC, 1, 4, f) == 4
+          && fwrite(&seed, sizeof(uint32_t), 1, f) == 1
+          && fwrite(params, sizeof(int32_t), NUM_PARAMS, f) == NUM_PARAMS;
+
+    for (int j = 0; ok && j < state->num_pairs; ++j) {
+        const PairSet* set = &state->pairs[j];
+        uint16_t keys[2] = {set->x, set->y};
+        uint32_t count = (uint32_t)set->count;
+        ok = fwrite(keys, sizeof(uint16_t), 2, f) == 2
+          && fwrite(&count, sizeof(uint32_t), 1, f) == 1
+          && fwrite(set->indices, sizeof(uint32_t), count, f) == count
+          && fwrite(set->depths, sizeof(int32_t), count, f) == count;
+    }
+
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+static int read_header(FILE* f, uint32_t* seed, int32_t* params) {
+    char magic[4];
+    return fread(magic, 1, 4, f) == 4
+        && memcmp(magic, ABDUCTION_MAGIC, 4) == 0
+        && fread(seed, sizeof(uint32_t), 1, f) == 1
+        && fread(params, sizeof(int32_t), NUM_PARAMS, f) == NUM_PARAMS
+        && params[4] >= 0;
+}
+
+int abduction_state_peek(const char* path, unsigned int* seed, int* num_rules, int* boundary_mode, int* max_steps, int* family) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    uint32_t stored_seed;
+    int32_t params[NUM_PARAMS];
+    int ok = read_header(f, &stored_seed, params);
+    fclose(f);
+    if (!ok) return -1;
+
+    *seed = stored_seed;
+    *num_rules = params[0];
+    *boundary_mode = params[1];
+    *max_steps = params[2];
+    *family = params[3];
+    return 0;
+}
+
+AbductionState* abduction_state_load(CASession* session, const char* path) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return NULL;
+
+    uint32_t seed;
+    int32_t params[NUM_PARAMS];
+    int ok = read_header(f, &seed, params)
+          && seed == session->seed
+          && params[0] == session->num_rules
+          && params[1] == session->boundary_mode
+          && params[2] == session->max_steps
+          && params[3] == session->family;
+
+    AbductionState* state = abduction_state_create(session);
+    uint32_t num_rules = (uint32_t)session->num_rules;
+
+    for (int j = 0; ok && j < params[4]; ++j) {
+        uint16_t keys[2];
+        uint32_t count;
+        ok = fread(keys, sizeof(uint16_t), 2, f) == 2
+          && fread(&count, sizeof(uint32_t), 1, f) == 1
+          && count <= (j > 0 ? (uint32_t)state->pairs[j - 1].count : num_rules);
+        if (!ok) break;
+
+        PairSet* set = append_pair(state);
+        set->x = keys[0];
+        set->y = keys[1];
+        set->count = (int)count;
+        set->indices = checked_malloc((size_t)count * sizeof(uint32_t));
+        set->depths = checked_malloc((size_t)count * sizeof(int32_t));
+        ok = fread(set->indices, sizeof(uint32_t), count, f) == count
+          && fread(set->depths, sizeof(int32_t), count, f) == count;
+
+        // Each set is ascending and a subset of the previous one (checked by a merge
+        // walk), as refinement leaves it; removals rely on the counts only shrinking.
+        const PairSet* prev = j > 0 ? set - 1 : NULL;
+        int p = 0;
+        for (uint32_t k = 0; ok && k < count; ++k) {
+            uint32_t r = set->indices[k];
+            ok = r < num_rules && (k == 0 || set->indices[k - 1] < r);
+            if (ok && prev) {
+                while (p < prev->count && prev->indices[p] < r) p++;
+                ok = p < prev->count && prev->indices[p] == r;
+            }
+        }
+    }
+
+    fclose(f);
+    if (!ok) {
+        abduction_state_destroy(state);
+        return NULL;
+    }
+    return state;
+}
@@ -0,0 +1,138 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+#include "parallel.h"
+#include "bdm_scoring.h"
+
+#define RULE_UINT64_PARTS 8
+#define BDM_MAGIC "BDM2"
+
+// Block j covers string positions [12j, 12j + 12), i.e. rule bits [500 - 12j, 512 - 12j).
+static inline int rule_block(const uint64_t* rule_number, int j) {
+    int shift = 512 - BDM_BLOCK_BITS * (j + 1);
+    int word = shift / 64;
+    int offset = shift % 64;
+
+    uint64_t v = rule_number[word] >> offset;
+    if (offset > 64 - BDM_BLOCK_BITS) v |= rule_number[word + 1] << (64 - offset);
+    return (int)(v & (BDM_TABLE_SIZE - 1));
+}
+
+double bdm_score_rule(const uint64_t* rule_number, const double* ctm_table) {
+    int blocks[BDM_RULE_BLOCKS];
+    for (int j = 0; j < BDM_RULE_BLOCKS; ++j) {
+        int v = rule_block(rule_number, j);
+
+        // Insertion sort keeps equal blocks adjacent for multiplicity counting.
+        int i = j;
+        while (i > 0 && blocks[i - 1] > v) {
+            blocks[i] = blocks[i - 1];
+            --i;
+        }
+        blocks[i] = v;
+    }
+
+    double score = 0.0;
+    for (int j = 0; j < BDM_RULE_BLOCKS; ) {
+        int run = 1;
+        while (j + run < BDM_RULE_BLOCKS && blocks[j + run] == blocks[j]) ++run;
+        score += ctm_table[blocks[j]] + log2((double)run);
+        j += run;
+    }
+    return score;
+}
+
+typedef struct {
+    const uint64_t* rules_flat;
+    const double* ctm_table;
+    double* scores;
+} ScoreContext;
+
+static void score_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    (void)thread_id;
+    ScoreContext* ctx = arg;
+    for (int64_t r = begin; r < end; ++r) {
+        ctx->scores[r] = bdm_score_rule(&ctx->rules_flat[r * RULE_UINT64_PARTS], ctx->ctm_table);
+    }
+}
+
+void bdm_score_rules(
+    const uint64_t* rules_flat,
+    int num_rules,
+    const double* ctm_table,
+    int num_threads,
+    double* scores_out
+) {
+    ScoreContext ctx = { rules_flat, ctm_table, scores_out };
+    parallel_for(num_threads, num_rules, score_range, &ctx);
+}
+
+typedef struct {
+    double score;
+    int index;
+} ScoredIndex;
+
+static int compare_scored(const void* a, const void* b) {
+    const ScoredIndex* x = a;
+    const ScoredIndex* y = b;
+    if (x->score < y->score) return -1;
+    if (x->score > y->score) return 1;
+    return (x->index > y->index) - (x->index < y->index);
+}
+
+int bdm_top_k(const double* scores, int num_rules, int k, int* indices_out) {
+    if (k > num_rules) k = num_rules;
+    if (k <= 0) return 0;
+
+    ScoredIndex* items = malloc((size_t)num_rules * sizeof(ScoredIndex));
+    if (!items) {
+        fprintf(stderr, "Memory allocation failed for top-k selection.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_rules; ++i) {
+        items[i].score = scores[i];
+        items[i].index = i;
+    }
+    qsort(items, num_rules, sizeof(ScoredIndex), compare_scored);
+
+    for (int i = 0; i < k; ++i) indices_out[i] = items[i].index;
+
+    free(items);
+    return k;
+}
+
+int bdm_load_ctm_table(const char* path, double* table_out) {
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+
+    char magic[4];
+    uint32_t block_bits = 0, byte_order = 0;
+    int ok = fread(magic, 1, 4, f) == 4
+          && memcmp(magic, BDM_MAGIC, 4) == 0
+          && fread(&block_bits, sizeof(uint32_t), 1, f) == 1
+          && block_bits == BDM_BLOCK_BITS
+          && fread(&byte_order, sizeof(uint32_t), 1, f) == 1
+          && byte_order == BDM_BYTE_ORDER
+          && fread(table_out, sizeof(double), BDM_TABLE_SIZE, f) == BDM_TABLE_SIZE;
+
+    fclose(f);
+    return ok ? 0 : -1;
+}
+
+int bdm_save_ctm_table(const char* path, const double* table) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    uint32_t block_bits = BDM_BLOCK_BITS;
+    uint32_t byte_order = BDM_BYTE_ORDER;
+    int ok = fwrite(BDM_MAGIC, 1, 4, f) == 4
+          && fwrite(&block_bits, sizeof(uint32_t), 1, f) == 1
+          && fwrite(&byte_order, sizeof(uint32_t), 1, f) == 1
+          && fwrite(table, sizeof(double), BDM_TABLE_SIZE, f) == BDM_TABLE_SIZE;
+
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
@@ -1,6 +1,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <pthread.h>
 #include "ca_dynamics.h"
 #include "matrix_utils.h"
 
@@ -91,6 +92,14 @@ void compute_rule_number(const Rule512* rule, uint64_t* out) {
     }
 }
 
+void rule_from_number(Rule512* rule, const uint64_t* number) {
+    for (int i = 0; i < RULE_UINT64_PARTS; ++i) {
+        for (int j = 0; j < 8; ++j) {
+            rule->table[i * 8 + (7 - j)] = (number[i] >> (8 * j)) & 0xFF;
+        }
+    }
+}
+
 // Optional: For rule sampling from a PRNG
 #include <prng/prng.h>
 
@@ -99,3 +108,271 @@ void random_rule(Rule512* rule) {
         rule->table[i] = prng_next_byte();
     }
 }
+
+// -------------------- Rule families --------------------
+
+#define SYMMETRIC_ORBITS 102  // D4 orbits of the 512 binary 3×3 windows
+
+static uint8_t symmetric_orbit[RULE_BITS];    // neighborhood code -> orbit id
+static uint8_t window_code[2][MATRIX_SIZE][16];  // [boundary][col][row nibble] -> 3-bit window
+static pthread_once_t tables_once = PTHREAD_ONCE_INIT;
+
+// Maps window position (a, b) through one of the 8 symmetries of the square.
+static int transform_position(int t, int a, int b) {
+    int ra, rb;
+    switch (t) {
+        case 0:  ra = a;     rb = b;     break;
+        case 1:  ra = b;     rb = 2 - a; break;
+        case 2:  ra = 2 - a; rb = 2 - b; break;
+        case 3:  ra = 2 - b; rb = a;     break;
+        case 4:  ra = a;     rb = 2 - b; break;
+        case 5:  ra = b;     rb = a;     break;
+        case 6:  ra = 2 - a; rb = b;     break;
+        default: ra = 2 - b; rb = 2 - a; break;
+    }
+    return ra * 3 + rb;
+}
+
+static void init_tables(void) {
+    // Orbit ids are the ranks of the smallest code in each orbit.
+    int representative[RULE_BITS];
+    for (int code = 0; code < RULE_BITS; ++code) {
+        int best = code;
+        for (int t = 1; t < 8; ++t) {
+            int image = 0;
+            for (int k = 0; k < 9; ++k) {
+                if ((code >> k) & 1) image |= 1 << transform_position(t, k / 3, k % 3);
+            }
+            if (image < best) best = image;
+        }
+        representative[code] = best;
+    }
+
+    int orbit_of_rep[RULE_BITS];
+    int orbits = 0;
+    for (int code = 0; code < RULE_BITS; ++code) {
+        if (representative[code] == code) orbit_of_rep[code] = orbits++;
+    }
+    for (int code = 0; code < RULE_BITS; ++code) {
+        symmetric_orbit[code] = orbit_of_rep[representative[code]];
+    }
+
+    // Row nibbles follow matrix_hash: column 0 is the most significant bit.
+    for (int boundary_mode = 0; boundary_mode <= 1; ++boundary_mode) {
+        for (int col = 0; col < MATRIX_SIZE; ++col) {
+            for (int nibble = 0; nibble < 16; ++nibble) {
+                int w = 0;
+                for (int dc = -1; dc <= 1; ++dc) {
+                    int c = col + dc;
+                    if (boundary_mode == 1) {
+                        c = (c + MATRIX_SIZE) % MATRIX_SIZE;
+                    } else if (c < 0 || c >= MATRIX_SIZE) {
+                        continue;
+                    }
+                    w |= ((nibble >> (MATRIX_SIZE - 1 - c)) & 1) << (dc + 1);
+                }
+                window_code[boundary_mode][col][nibble] = w;
+            }
+        }
+    }
+}
+
+static inline int param_bit(const uint64_t* params, int i) {
+    return (params[i / 64] >> (i % 64)) & 1;
+}
+
+int rule_family_bits(int family) {
+    switch (family) {
+        case RULE_FAMILY_FULL:              return RULE_BITS;
+        case RULE_FAMILY_TOTALISTIC:        return 10;
+        case RULE_FAMILY_OUTER_TOTALISTIC:  return 18;
+        case RULE_FAMILY_SYMMETRIC:         return SYMMETRIC_ORBITS;
+        default:                            return -1;
+    }
+}
+
+void rule_family_expand(int family, const uint64_t* params, Rule512* rule) {
+    if (family == RULE_FAMILY_FULL) {
+        rule_from_number(rule, params);
+        return;
+    }
+
+    pthread_once(&tables_once, init_tables);
+
+    for (int i = 0; i < RULE_BYTES; ++i) rule->table[i] = 0;
+
+    for (int nb = 0; nb < RULE_BITS; ++nb) {
+        int bit;
+        switch (family) {
+            case RULE_FAMILY_TOTALISTIC:
+                bit = __builtin_popcount(nb);
+                break;
+            case RULE_FAMILY_OUTER_TOTALISTIC:
+                bit = ((nb >> 4) & 1) * 9 + __builtin_popcount(nb & ~0x10);
+                break;
+            default:
+                bit = symmetric_orbit[nb];
+                break;
+        }
+        if (param_bit(params, bit)) rule->table[nb / 8] |= 1 << (nb % 8);
+    }
+}
+
+void random_rule_in_family(Rule512* rule, int family) {
+    if (family == RULE_FAMILY_FULL) {
+        random_rule(rule);
+        return;
+    }
+
+    uint64_t params[RULE_UINT64_PARTS] = {0};
+    int bits = rule_family_bits(family);
+    for (int i = 0; i < (bits + 63) / 64; ++i) {
+        params[i] = prng_next();
+    }
+    rule_family_expand(family, params, rule);
+}
+
+void random_rule_with_density(Rule512* rule, int ones) {
+    uint16_t positions[RULE_BITS];
+    for (int i = 0; i < RULE_BITS; ++i) positions[i] = (uint16_t)i;
+
+    for (int i = 0; i < RULE_BYTES; ++i) rule->table[i] = 0;
+    if (ones < 0) ones = 0;
+    if (ones > RULE_BITS) ones = RULE_BITS;
+
+    // Partial Fisher-Yates: the first `ones` positions are a uniform subset.
+    for (int i = 0; i < ones; ++i) {
+        uint32_t span = (uint32_t)(RULE_BITS - i);
+        int j = i + (int)(((prng_next() >> 32) * span) >> 32);
+        uint16_t tmp = positions[i];
+        positions[i] = positions[j];
+        positions[j] = tmp;
+        rule->table[positions[i] / 8] |= (uint8_t)(1u << (positions[i] % 8));
+    }
+}
+
+// -------------------- Packed kernel --------------------
+
+static inline int rule_bit(const Rule512* rule, int nb) {
+    return (rule->table[nb / 8] >> (nb % 8)) & 1;
+}
+
+// Shared by the plain and traced kernels; `used` (if not NULL) collects the codes read.
+static inline uint16_t apply_packed(uint16_t state, const Rule512* rule, int boundary_mode, uint64_t* used) {
+    pthread_once(&tables_once, init_tables);
+
+    int toroidal = (boundary_mode == 1);
+    uint8_t (*window)[16] = window_code[toroidal];
+
+    int rows[MATRIX_SIZE];
+    for (int r = 0; r < MATRIX_SIZE; ++r) {
+        rows[r] = (state >> (4 * (MATRIX_SIZE - 1 - r))) & 0xF;
+    }
+
+    uint16_t out = 0;
+    for (int r = 0; r < MATRIX_SIZE; ++r) {
+        int top = (r > 0) ? rows[r - 1] : (toroidal ? rows[MATRIX_SIZE - 1] : 0);
+        int bot = (r < MATRIX_SIZE - 1) ? rows[r + 1] : (toroidal ? rows[0] : 0);
+        int mid = rows[r];
+
+        for (int c = 0; c < MATRIX_SIZE; ++c) {
+            int nb = window[c][top] | (window[c][mid] << 3) | (window[c][bot] << 6);
+            if (used) used[nb / 64] |= 1ULL << (nb % 64);
+            out = (out << 1) | rule_bit(rule, nb);
+        }
+    }
+    return out;
+}
+
+uint16_t apply_rule_packed(uint16_t state, const Rule512* rule, int boundary_mode) {
+    return apply_packed(state, rule, boundary_mode, NULL);
+}
+
+void rule_row_table(const Rule512* rule, int boundary_mode, uint8_t* table) {
+    pthread_once(&tables_once, init_tables);
+
+    uint8_t (*window)[16] = window_code[boundary_mode == 1];
+
+    for (int top = 0; top < 16; ++top) {
+        for (int mid = 0; mid < 16; ++mid) {
+            for (int bot = 0; bot < 16; ++bot) {
+                int out = 0;
+                for (int c = 0; c < MATRIX_SIZE; ++c) {
+                    int nb = window[c][top] | (window[c][mid] << 3) | (window[c][bot] << 6);
+                    out = (out << 1) | rule_bit(rule, nb);
+                }
+                table[(top << 8) | (mid << 4) | bot] = (uint8_t)out;
+            }
+        }
+    }
+}
+
+// Starts a new visited set; stamps are cleared only when the generation wraps.
+uint32_t sim_scratch_begin(SimScratch* scratch) {
+    if (++scratch->generation == 0) {
+        for (int i = 0; i < (1 << 16); ++i) scratch->stamps[i] = 0;
+        scratch->generation = 1;
+    }
+    return scratch->generation;
+}
+
+int simulate_packed_with_depth(uint16_t x_init, uint16_t y_target, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    uint32_t gen = sim_scratch_begin(scratch);
+
+    uint16_t current = x_init;
+    for (int t = 0; t < max_steps; ++t) {
+        if (current == y_target) return t;
+        if (scratch->stamps[current] == gen) return -1;
+
+        scratch->stamps[current] = gen;
+        current = apply_rule_packed(current, rule, boundary_mode);
+    }
+    return -1;
+}
+
+static int trajectory(uint16_t x_init, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch, uint16_t* trail_out, uint64_t* used) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    uint32_t gen = sim_scratch_begin(scratch);
+
+    int count = 0;
+    uint16_t current = x_init;
+    for (int t = 0; t < max_steps; ++t) {
+        if (scratch->stamps[current] == gen) break;
+
+        scratch->stamps[current] = gen;
+        if (trail_out) trail_out[count] = current;
+        count++;
+        current = apply_packed(current, rule, boundary_mode, used);
+    }
+    return count;
+}
+
+int simulate_packed_trajectory(uint16_t x_init, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch, uint16_t* trail_out) {
+    return trajectory(x_init, rule, boundary_mode, max_steps, scratch, trail_out, NULL);
+}
+
+int simulate_packed_trajectory_traced(uint16_t x_init, const Rule512* rule, int boundary_mode, int max_steps, SimScratch* scratch, uint16_t* trail_out, uint64_t* used_mask) {
+    return trajectory(x_init, rule, boundary_mode, max_steps, scratch, trail_out, used_mask);
+}
+
+SimScratch* sim_scratch_create(void) {
+    SimScratch* scratch = malloc(sizeof(SimScratch));
+    if (scratch) {
+        scratch->stamps = calloc(1 << 16, sizeof(uint32_t));
+        scratch->generation = 0;
+    }
+    if (!scratch || !scratch->stamps) {
+        fprintf(stderr, "Memory allocation failed for simulation scratch.\n");
+        exit(EXIT_FAILURE);
+    }
+    return scratch;
+}
+
+void sim_scratch_free(SimScratch* scratch) {
+    if (!scratch) return;
+    free(scratch->stamps);
+    free(scratch);
+}
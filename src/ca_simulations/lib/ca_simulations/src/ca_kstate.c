@@ -0,0 +1,219 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include "ca_kstate.h"
+#include "matrix_utils.h"
+#include <prng/prng.h>
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+#define CELLS (MATRIX_SIZE * MATRIX_SIZE)
+#define SUM_BITS 7  // 9 · 9 = 81 < 2^7
+
+int kstate_table_size(int family, int num_colors) {
+    if (num_colors < 2 || num_colors > KSTATE_MAX_COLORS) return -1;
+
+    switch (family) {
+        case KSTATE_TOTALISTIC:       return 9 * (num_colors - 1) + 1;
+        case KSTATE_OUTER_TOTALISTIC: return num_colors * (8 * (num_colors - 1) + 1);
+        default:                      return -1;
+    }
+}
+
+static int planes_for(int num_colors) {
+    int planes = 1;
+    while ((1 << planes) < num_colors) ++planes;
+    return planes;
+}
+
+static uint16_t get_plane(KState s, int b) {
+    return (uint16_t)(s >> (16 * b));
+}
+
+KState kstate_from_matrix(const Matrix m) {
+    KState s = 0;
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            int p = i * MATRIX_SIZE + j;
+            for (int b = 0; b < KSTATE_PLANES; ++b) {
+                if ((m[i][j] >> b) & 1) s |= (KState)1 << (16 * b + p);
+            }
+        }
+    }
+    return s;
+}
+
+void kstate_to_matrix(Matrix out, KState s) {
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            int p = i * MATRIX_SIZE + j;
+            uint8_t v = 0;
+            for (int b = 0; b < KSTATE_PLANES; ++b) {
+                v |= ((get_plane(s, b) >> p) & 1) << b;
+            }
+            out[i][j] = v;
+        }
+    }
+}
+
+// Returns a plane whose bit (r, c) holds the input bit at (r + dr, c + dc).
+static uint16_t shift_plane(uint16_t x, int dr, int dc, int boundary_mode) {
+    int toroidal = (boundary_mode == 1);
+
+    if (dc == 1) {
+        x = ((x >> 1) & 0x7777) | (toroidal ? ((x << 3) & 0x8888) : 0);
+    } else if (dc == -1) {
+        x = ((x << 1) & 0xEEEE) | (toroidal ? ((x >> 3) & 0x1111) : 0);
+    }
+
+    if (dr == 1) {
+        x = (uint16_t)((x >> 4) | (toroidal ? (x << 12) : 0));
+    } else if (dr == -1) {
+        x = (uint16_t)((x << 4) | (toroidal ? (x >> 12) : 0));
+    }
+
+    return x;
+}
+
+// Adds (mask · 2^weight_bit) to a bit-sliced counter holding one value per cell.
+static void sliced_add(uint16_t acc[SUM_BITS], uint16_t mask, int weight_bit) {
+    uint16_t carry = mask;
+    for (int i = weight_bit; carry && i < SUM_BITS; ++i) {
+        uint16_t t = acc[i] & carry;
+        acc[i] ^= carry;
+        carry = t;
+    }
+}
+
+KState kstate_apply_rule(KState in, const KRule* rule, int boundary_mode) {
+    int k = rule->num_colors;
+    int planes = planes_for(k);
+    int outer = (rule->family == KSTATE_OUTER_TOTALISTIC);
+    int stride = 8 * (k - 1) + 1;
+
+    uint16_t acc[SUM_BITS] = {0};
+    for (int dr = -1; dr <= 1; ++dr) {
+        for (int dc = -1; dc <= 1; ++dc) {
+            if (outer && dr == 0 && dc == 0) continue;
+            for (int b = 0; b < planes; ++b) {
+                sliced_add(acc, shift_plane(get_plane(in, b), dr, dc, boundary_mode), b);
+            }
+        }
+    }
+
+    KState out = 0;
+    for (int p = 0; p < CELLS; ++p) {
+        int s = 0;
+        for (int i = 0; i < SUM_BITS; ++i) {
+            s |= ((acc[i] >> p) & 1) << i;
+        }
+
+        int idx = s;
+        if (outer) {
+            int center = 0;
+            for (int b = 0; b < planes; ++b) {
+                center |= ((get_plane(in, b) >> p) & 1) << b;
+            }
+            idx = center * stride + s;
+        }
+
+        uint8_t v = rule->table[idx];
+        for (int b = 0; b < planes; ++b) {
+            if ((v >> b) & 1) out |= (KState)1 << (16 * b + p);
+        }
+    }
+
+    return out;
+}
+
+// -------------------- Visited set --------------------
+
+KStateScratch* kstate_scratch_create(int max_steps) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    int bits = 4;
+    while ((1LL << bits) < 2LL * max_steps) ++bits;
+
+    KStateScratch* scratch = malloc(sizeof(KStateScratch));
+    if (scratch) {
+        scratch->keys = malloc(sizeof(KState) << bits);
+        scratch->stamps = calloc((size_t)1 << bits, sizeof(uint32_t));
+        scratch->generation = 0;
+        scratch->bits = bits;
+    }
+    if (!scratch || !scratch->keys || !scratch->stamps) {
+        fprintf(stderr, "Memory allocation failed for state tracking.\n");
+        exit(EXIT_FAILURE);
+    }
+    return scratch;
+}
+
+void kstate_scratch_free(KStateScratch* scratch) {
+    if (!scratch) return;
+    free(scratch->keys);
+    free(scratch->stamps);
+    free(scratch);
+}
+
+// Starts a new visited set; stamps are cleared only when the generation wraps.
+static void scratch_begin(KStateScratch* scratch) {
+    if (++scratch->generation == 0) {
+        for (size_t i = 0; i < ((size_t)1 << scratch->bits); ++i) scratch->stamps[i] = 0;
+        scratch->generation = 1;
+    }
+}
+
+// Adds state to the set (linear probing). Returns 0 if it was already there.
+static int scratch_visit(KStateScratch* scratch, KState state) {
+    size_t mask = ((size_t)1 << scratch->bits) - 1;
+    size_t h = (size_t)((state * 0x9E3779B97F4A7C15ULL) >> (64 - scratch->bits));
+
+    while (scratch->stamps[h] == scratch->generation) {
+        if (scratch->keys[h] == state) return 0;
+        h = (h + 1) & mask;
+    }
+    scratch->stamps[h] = scratch->generation;
+    scratch->keys[h] = state;
+    return 1;
+}
+
+int kstate_simulate_with_depth(KState x_init, KState y_target, const KRule* rule, int boundary_mode, int max_steps, KStateScratch* scratch) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    scratch_begin(scratch);
+
+    KState current = x_init;
+    for (int t = 0; t < max_steps; ++t) {
+        if (current == y_target) return t;
+        if (!scratch_visit(scratch, current)) return -1;
+        current = kstate_apply_rule(current, rule, boundary_mode);
+    }
+    return -1;
+}
+
+int kstate_simulate_trajectory(KState x_init, const KRule* rule, int boundary_mode, int max_steps, KStateScratch* scratch, KState* trail_out) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    scratch_begin(scratch);
+
+    int count = 0;
+    KState current = x_init;
+    for (int t = 0; t < max_steps; ++t) {
+        if (!scratch_visit(scratch, current)) break;
+        trail_out[count++] = current;
+        current = kstate_apply_rule(current, rule, boundary_mode);
+    }
+    return count;
+}
+
+void kstate_random_rule(KRule* rule, int family, int num_colors) {
+    int size = kstate_table_size(family, num_colors);
+
+    rule->num_colors = num_colors;
+    rule->family = family;
+    for (int i = 0; i < KSTATE_MAX_TABLE; ++i) {
+        rule->table[i] = (i < size) ? (uint8_t)(prng_next() % num_colors) : 0;
+    }
+}
@@ -0,0 +1,394 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <prng/prng.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "simulate_rule_outputs.h"
+#include "ca_session.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+typedef struct {
+    int* indices;
+    int* depths;
+    int count;
+    int capacity;
+} IndexList;
+
+static void index_list_push(IndexList* list, int index, int depth) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 64;
+        list->indices = realloc(list->indices, list->capacity * sizeof(int));
+        list->depths = realloc(list->depths, list->capacity * sizeof(int));
+        if (!list->indices || !list->depths) {
+            fprintf(stderr, "Memory allocation failed for match tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    list->indices[list->count] = index;
+    list->depths[list->count] = depth;
+    list->count++;
+}
+
+static void pack_pairs(const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs, uint16_t* xs, uint16_t* ys) {
+    Matrix m;
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        xs[i] = (uint16_t)matrix_hash(m);
+        flat_to_matrix(m, &ys_flat[i * 16]);
+        ys[i] = (uint16_t)matrix_hash(m);
+    }
+}
+
+CASession* ca_session_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads) {
+    return ca_session_create_in_family(seed, num_rules, RULE_FAMILY_FULL, boundary_mode, max_steps, num_threads);
+}
+
+CASession* ca_session_create_in_family(unsigned int seed, int num_rules, int family, int boundary_mode, int max_steps, int num_threads) {
+    if (rule_family_bits(family) < 0) return NULL;
+
+    init_interrupt_flag();
+
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    CASession* session = calloc(1, sizeof(CASession));
+    if (!session) {
+        fprintf(stderr, "Memory allocation failed for session.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    session->seed = seed;
+    session->num_rules = num_rules;
+    session->boundary_mode = boundary_mode;
+    session->max_steps = max_steps;
+    session->family = family;
+
+    session->rules = calloc(num_rules, sizeof(Rule512));
+    session->rule_numbers = calloc((size_t)num_rules * 8, sizeof(uint64_t));
+    if (!session->rules || !session->rule_numbers) {
+        fprintf(stderr, "Memory allocation failed for rules.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // For the full family, the same sequence as simulate_rule_matches, so bank index r is the r-th rule there.
+    prng_seed(seed);
+    for (int r = 0; r < num_rules; ++r) {
+        random_rule_in_family(&session->rules[r], family);
+        compute_rule_number(&session->rules[r], &session->rule_numbers[(size_t)r * 8]);
+    }
+
+    session->pool = worker_pool_create(num_threads);
+    int workers = worker_pool_size(session->pool);
+
+    session->scratch = calloc(workers, sizeof(SimScratch*));
+    session->trails = calloc(workers, sizeof(uint16_t*));
+    if (!session->scratch || !session->trails) {
+        fprintf(stderr, "Memory allocation failed for session scratch.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < workers; ++t) {
+        session->scratch[t] = sim_scratch_create();
+        session->trails[t] = malloc((size_t)max_steps * sizeof(uint16_t));
+        if (!session->trails[t]) {
+            fprintf(stderr, "Memory allocation failed for session scratch.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    return session;
+}
+
+void ca_session_destroy(CASession* session) {
+    if (!session) return;
+
+    int workers = worker_pool_size(session->pool);
+    worker_pool_destroy(session->pool);
+
+    for (int t = 0; t < workers; ++t) {
+        sim_scratch_free(session->scratch[t]);
+        free(session->trails[t]);
+    }
+    free(session->scratch);
+    free(session->trails);
+    free(session->rule_numbers);
+    free(session->rules);
+    free(session);
+}
+
+// -------------------- Matches / CTM --------------------
+
+typedef struct {
+    CASession* session;
+    const uint16_t* xs;
+    const uint16_t* ys;
+    int num_pairs;
+    IndexList* lists;  // [thread][pair], NULL for counts-only sweeps
+    int* counts;       // [thread][pair]
+    int* min_depths;   // [thread][pair]
+} MatchContext;
+
+static void match_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    MatchContext* ctx = arg;
+    CASession* session = ctx->session;
+    SimScratch* scratch = session->scratch[thread_id];
+
+    size_t base = (size_t)thread_id * ctx->num_pairs;
+
+    for (int64_t r = begin; r < end; ++r) {
+        if (is_interrupted()) break;
+
+        const Rule512* rule = &session->rules[r];
+        for (int i = 0; i < ctx->num_pairs; ++i) {
+            int depth = simulate_packed_with_depth(ctx->xs[i], ctx->ys[i], rule, session->boundary_mode, session->max_steps, scratch);
+            if (depth < 0) continue;
+
+            ctx->counts[base + i]++;
+            if (ctx->min_depths[base + i] < 0 || depth < ctx->min_depths[base + i]) ctx->min_depths[base + i] = depth;
+            if (ctx->lists) index_list_push(&ctx->lists[base + i], (int)r, depth);
+        }
+    }
+}
+
+static void run_match_sweep(CASession* session, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs, int collect, MatchContext* ctx) {
+    reset_interrupt_flag();
+
+    int workers = worker_pool_size(session->pool);
+    size_t slots = (size_t)workers * num_pairs;
+
+    uint16_t* packed = malloc(2 * (size_t)num_pairs * sizeof(uint16_t));
+    ctx->counts = calloc(slots, sizeof(int));
+    ctx->min_depths = malloc(slots * sizeof(int));
+    ctx->lists = collect ? calloc(slots, sizeof(IndexList)) : NULL;
+    if (!packed || !ctx->counts || !ctx->min_depths || (collect && !ctx->lists)) {
+        fprintf(stderr, "Memory allocation failed for match tracking.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t k = 0; k < slots; ++k) ctx->min_depths[k] = -1;
+
+    pack_pairs(xs_flat, ys_flat, num_pairs, packed, packed + num_pairs);
+
+    ctx->session = session;
+    ctx->xs = packed;
+    ctx->ys = packed + num_pairs;
+    ctx->num_pairs = num_pairs;
+
+    worker_pool_run(session->pool, session->num_rules, match_range, ctx);
+
+    free(packed);
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+}
+
+void ca_session_matches(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths,
+    int* match_counts
+) {
+    MatchContext ctx;
+    run_match_sweep(session, xs_flat, ys_flat, num_pairs, 1, &ctx);
+
+    int workers = worker_pool_size(session->pool);
+
+    // Worker t owns the t-th contiguous slice of the bank, so concatenation keeps bank order.
+    for (int i = 0; i < num_pairs; ++i) {
+        int total = 0;
+        for (int t = 0; t < workers; ++t) total += ctx.lists[(size_t)t * num_pairs + i].count;
+
+        match_counts[i] = 0;
+        match_rule_indices[i] = malloc((total > 0 ? total : 1) * sizeof(int));
+        match_rule_depths[i] = malloc((total > 0 ? total : 1) * sizeof(int));
+        if (!match_rule_indices[i] || !match_rule_depths[i]) {
+            fprintf(stderr, "Memory allocation failed for match tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int t = 0; t < workers; ++t) {
+            IndexList* list = &ctx.lists[(size_t)t * num_pairs + i];
+            memcpy(&match_rule_indices[i][match_counts[i]], list->indices, list->count * sizeof(int));
+            memcpy(&match_rule_depths[i][match_counts[i]], list->depths, list->count * sizeof(int));
+            match_counts[i] += list->count;
+        }
+    }
+
+    for (size_t k = 0; k < (size_t)workers * num_pairs; ++k) {
+        free(ctx.lists[k].indices);
+        free(ctx.lists[k].depths);
+    }
+    free(ctx.lists);
+    free(ctx.counts);
+    free(ctx.min_depths);
+}
+
+void ca_session_free_matches(
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths
+) {
+    for (int i = 0; i < num_pairs; ++i) {
+        free(match_rule_indices[i]);
+        free(match_rule_depths[i]);
+    }
+}
+
+void ca_session_ctm(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int* match_counts,
+    int* min_depths
+) {
+    MatchContext ctx;
+    run_match_sweep(session, xs_flat, ys_flat, num_pairs, 0, &ctx);
+
+    int workers = worker_pool_size(session->pool);
+    for (int i = 0; i < num_pairs; ++i) {
+        match_counts[i] = 0;
+        min_depths[i] = -1;
+        for (int t = 0; t < workers; ++t) {
+            size_t k = (size_t)t * num_pairs + i;
+            match_counts[i] += ctx.counts[k];
+            if (ctx.min_depths[k] >= 0 && (min_depths[i] < 0 || ctx.min_depths[k] < min_depths[i])) {
+                min_depths[i] = ctx.min_depths[k];
+            }
+        }
+    }
+
+    free(ctx.counts);
+    free(ctx.min_depths);
+}
+
+// -------------------- Outputs --------------------
+
+typedef struct {
+    CASession* session;
+    uint16_t x;
+    const int* rule_indices;   // bank indices, or NULL
+    const Rule512* rules;      // explicit rules when rule_indices is NULL
+    const uint64_t* numbers;   // rule numbers matching `rules`
+    OutputMap* output_maps;
+} OutputContext;
+
+static void output_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    OutputContext* ctx = arg;
+    CASession* session = ctx->session;
+    SimScratch* scratch = session->scratch[thread_id];
+    uint16_t* trail = session->trails[thread_id];
+
+    for (int64_t r = begin; r < end; ++r) {
+        if (is_interrupted()) break;
+
+        const Rule512* rule;
+        const uint64_t* number;
+        if (ctx->rule_indices) {
+            int index = ctx->rule_indices[r];
+            rule = &session->rules[index];
+            number = &session->rule_numbers[(size_t)index * 8];
+        } else {
+            rule = &ctx->rules[r];
+            number = &ctx->numbers[(size_t)r * 8];
+        }
+
+        int n = simulate_packed_trajectory(ctx->x, rule, session->boundary_mode, session->max_steps, scratch, trail);
+
+        OutputMap* map = &ctx->output_maps[r];
+        memcpy(map->rule_number, number, sizeof(uint64_t) * 8);
+        map->outputs = malloc((n > 0 ? n : 1) * sizeof(Matrix));
+        map->depths = malloc((n > 0 ? n : 1) * sizeof(int));
+        if (!map->outputs || !map->depths) {
+            fprintf(stderr, "Memory allocation failed for output tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int t = 0; t < n; ++t) {
+            hash_to_matrix(map->outputs[t], trail[t]);
+            map->depths[t] = t;
+        }
+        map->num_outputs = n;
+    }
+}
+
+static void run_outputs(CASession* session, OutputContext* ctx, int count, const uint32_t* x_flat, OutputMap** output_maps_out) {
+    reset_interrupt_flag();
+
+    Matrix x;
+    flat_to_matrix(x, x_flat);
+
+    ctx->session = session;
+    ctx->x = (uint16_t)matrix_hash(x);
+    ctx->output_maps = calloc(count > 0 ? count : 1, sizeof(OutputMap));
+    if (!ctx->output_maps) {
+        fprintf(stderr, "Memory allocation failed for output maps.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    worker_pool_run(session->pool, count, output_range, ctx);
+    *output_maps_out = ctx->output_maps;
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+}
+
+void ca_session_outputs(
+    CASession* session,
+    const uint32_t* x_flat,
+    const int* rule_indices,
+    int num_indices,
+    OutputMap** output_maps_out
+) {
+    OutputContext ctx = {0};
+    int* all = NULL;
+
+    if (!rule_indices) {
+        num_indices = session->num_rules;
+        all = malloc((num_indices > 0 ? num_indices : 1) * sizeof(int));
+        if (!all) {
+            fprintf(stderr, "Memory allocation failed for rule indices.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int r = 0; r < num_indices; ++r) all[r] = r;
+        rule_indices = all;
+    }
+
+    ctx.rule_indices = rule_indices;
+    run_outputs(session, &ctx, num_indices, x_flat, output_maps_out);
+    free(all);
+}
+
+void ca_session_outputs_for_rules(
+    CASession* session,
+    const uint32_t* x_flat,
+    const uint64_t* rules_flat,
+    int num_rules,
+    OutputMap** output_maps_out
+) {
+    Rule512* rules = malloc((num_rules > 0 ? num_rules : 1) * sizeof(Rule512));
+    if (!rules) {
+        fprintf(stderr, "Memory allocation failed for rules.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int r = 0; r < num_rules; ++r) {
+        rule_from_number(&rules[r], &rules_flat[(size_t)r * 8]);
+    }
+
+    OutputContext ctx = {0};
+    ctx.rules = rules;
+    ctx.numbers = rules_flat;
+    run_outputs(session, &ctx, num_rules, x_flat, output_maps_out);
+    free(rules);
+}
@@ -0,0 +1,486 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "ca_session.h"
+#include "ctm_server.h"
+
+static const char request_magic[4] = {'C', 'T', 'M', 'Q'};
+
+typedef struct CTMRequest {
+    const uint32_t* xs_flat;
+    const uint32_t* ys_flat;
+    int num_pairs;
+    int* match_counts;
+    int* min_depths;
+    struct timespec arrival;
+    int done;
+    struct CTMRequest* next;
+} CTMRequest;
+
+typedef struct {
+    CTMServer* server;
+    pthread_t thread;
+    int fd;
+    int finished;  // handler returned; joined and freed by the acceptor
+} Connection;
+
+struct CTMServer {
+    CASession* session;
+    int batch_window_us;
+    int max_batch_pairs;
+
+    pthread_mutex_t lock;
+    pthread_cond_t queue_ready;   // new request or shutdown
+    pthread_cond_t batch_done;    // some requests were answered
+    CTMRequest* head;
+    CTMRequest* tail;
+    int queued_pairs;
+    int stopping;
+    pthread_t batcher;
+
+    CTMServerMetrics metrics;
+
+    int listen_fd;
+    char* socket_path;
+    pthread_t acceptor;
+    int listening;
+    Connection** connections;
+    int num_connections;
+};
+
+static double elapsed_seconds(const struct timespec* a, const struct timespec* b) {
+    return (b->tv_sec - a->tv_sec) + (b->tv_nsec - a->tv_nsec) * 1e-9;
+}
+
+// -------------------- Batching --------------------
+
+static void run_batch(CTMServer* server, CTMRequest* batch, int num_queries, int num_pairs) {
+    uint32_t* xs = malloc((size_t)num_pairs * 16 * sizeof(uint32_t));
+    uint32_t* ys = malloc((size_t)num_pairs * 16 * sizeof(uint32_t));
+    int* counts = malloc(num_pairs * sizeof(int));
+    int* depths = malloc(num_pairs * sizeof(int));
+    if (!xs || !ys || !counts || !depths) {
+        fprintf(stderr, "Memory allocation failed for query batch.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int offset = 0;
+    for (CTMRequest* r = batch; r; r = r->next) {
+        memcpy(&xs[offset * 16], r->xs_flat, (size_t)r->num_pairs * 16 * sizeof(uint32_t));
+        memcpy(&ys[offset * 16], r->ys_flat, (size_t)r->num_pairs * 16 * sizeof(uint32_t));
+        offset += r->num_pairs;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    ca_session_ctm(server->session, xs, ys, num_pairs, counts, depths);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+
+    pthread_mutex_lock(&server->lock);
+    offset = 0;
+    for (CTMRequest* r = batch; r;) {
+        CTMRequest* next = r->next;  // r belongs to its submitter once done is set
+        memcpy(r->match_counts, &counts[offset], r->num_pairs * sizeof(int));
+        memcpy(r->min_depths, &depths[offset], r->num_pairs * sizeof(int));
+        offset += r->num_pairs;
+        r->done = 1;
+        r = next;
+    }
+
+    CTMServerMetrics* m = &server->metrics;
+    m->queries += num_queries;
+    m->pairs += num_pairs;
+    m->batches++;
+    m->last_batch_queries = num_queries;
+    if (num_queries > m->max_batch_queries) m->max_batch_queries = num_queries;
+    if (num_pairs > m->max_batch_pairs) m->max_batch_pairs = num_pairs;
+    m->mean_batch_pairs = (double)m->pairs / m->batches;
+    m->sweep_seconds += elapsed_seconds(&start, &end);
+
+    pthread_cond_broadcast(&server->batch_done);
+    pthread_mutex_unlock(&server->lock);
+
+    free(depths);
+    free(counts);
+    free(ys);
+    free(xs);
+}
+
+static void* batcher_main(void* arg) {
+    CTMServer* server = arg;
+
+    pthread_mutex_lock(&server->lock);
+    for (;;) {
+        while (!server->stopping && !server->head) {
+            pthread_cond_wait(&server->queue_ready, &server->lock);
+        }
+        if (!server->head) break;  // stopping with nothing left to answer
+
+        // Wait out the oldest query's latency budget unless the batch is already full.
+        struct timespec deadline = server->head->arrival;
+        deadline.tv_nsec += (long)server->batch_window_us * 1000;
+        deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+        deadline.tv_nsec %= 1000000000L;
+        while (!server->stopping &&
+               (server->max_batch_pairs <= 0 || server->queued_pairs < server->max_batch_pairs)) {
+            if (pthread_cond_timedwait(&server->queue_ready, &server->lock, &deadline) == ETIMEDOUT) break;
+        }
+
+        CTMRequest* batch = server->head;
+        CTMRequest* last = batch;
+        int num_queries = 1, num_pairs = batch->num_pairs;
+        while (last->next && (server->max_batch_pairs <= 0 ||
+                              num_pairs + last->next->num_pairs <= server->max_batch_pairs)) {
+            last = last->next;
+            num_queries++;
+            num_pairs += last->num_pairs;
+        }
+        server->head = last->next;
+        if (!server->head) server->tail = NULL;
+        last->next = NULL;
+        server->queued_pairs -= num_pairs;
+        server->metrics.queue_depth -= num_queries;
+
+        pthread_mutex_unlock(&server->lock);
+        run_batch(server, batch, num_queries, num_pairs);
+        pthread_mutex_lock(&server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+CTMServer* ctm_server_create(unsigned int seed, int num_rules, int boundary_mode, int max_steps, int num_threads,
+                             int batch_window_us, int max_batch_pairs) {
+    CTMServer* server = calloc(1, sizeof(CTMServer));
+    if (!server) {
+        fprintf(stderr, "Memory allocation failed for CTM server.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    server->session = ca_session_create(seed, num_rules, boundary_mode, max_steps, num_threads);
+    server->batch_window_us = batch_window_us > 0 ? batch_window_us : 0;
+    server->max_batch_pairs = max_batch_pairs;
+    server->listen_fd = -1;
+
+    pthread_mutex_init(&server->lock, NULL);
+    pthread_cond_init(&server->queue_ready, NULL);
+    pthread_cond_init(&server->batch_done, NULL);
+
+    if (pthread_create(&server->batcher, NULL, batcher_main, server) != 0) {
+        fprintf(stderr, "Failed to start batching thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    return server;
+}
+
+int ctm_server_submit(CTMServer* server, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                      int* match_counts, int* min_depths) {
+    if (num_pairs <= 0) return num_pairs == 0 ? 0 : -1;
+    if (num_pairs > CTM_SERVER_MAX_PAIRS) return -1;
+
+    CTMRequest request = {xs_flat, ys_flat, num_pairs, match_counts, min_depths, {0, 0}, 0, NULL};
+    clock_gettime(CLOCK_REALTIME, &request.arrival);
+
+    pthread_mutex_lock(&server->lock);
+    if (server->stopping) {
+        pthread_mutex_unlock(&server->lock);
+        return -1;
+    }
+
+    if (server->tail) server->tail->next = &request;
+    else server->head = &request;
+    server->tail = &request;
+    server->queued_pairs += num_pairs;
+    if (++server->metrics.queue_depth > server->metrics.max_queue_depth) {
+        server->metrics.max_queue_depth = server->metrics.queue_depth;
+    }
+    pthread_cond_signal(&server->queue_ready);
+
+    while (!request.done) {
+        pthread_cond_wait(&server->batch_done, &server->lock);
+    }
+    pthread_mutex_unlock(&server->lock);
+    return 0;
+}
+
+void ctm_server_metrics(CTMServer* server, CTMServerMetrics* metrics) {
+    pthread_mutex_lock(&server->lock);
+    *metrics = server->metrics;
+    pthread_mutex_unlock(&server->lock);
+}
+
+// -------------------- Socket transport --------------------
+
+static int read_full(int fd, void* buf, size_t n) {
+    uint8_t* p = buf;
+    while (n > 0) {
+        ssize_t got = read(fd, p, n);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) return -1;
+        p += got;
+        n -= (size_t)got;
+    }
+    return 0;
+}
+
+// A peer that closed early must not raise SIGPIPE (which would kill the daemon);
+// the send fails with EPIPE instead and the connection is dropped.
+#ifdef MSG_NOSIGNAL
+#define SEND_FLAGS MSG_NOSIGNAL
+#else
+#define SEND_FLAGS 0  // no MSG_NOSIGNAL (macOS): SO_NOSIGPIPE is set on the socket instead
+#endif
+
+static void suppress_sigpipe(int fd) {
+#ifdef SO_NOSIGPIPE
+    int on = 1;
+    setsockopt(fd, SOL_SOCKET, SO_NOSIGPIPE, &on, sizeof(on));
+#else
+    (void)fd;
+#endif
+}
+
+static int write_full(int fd, const void* buf, size_t n) {
+    const uint8_t* p = buf;
+    while (n > 0) {
+        ssize_t put = send(fd, p, n, SEND_FLAGS);
+        if (put < 0 && errno == EINTR) continue;
+        if (put <= 0) return -1;  // EPIPE / ECONNRESET: peer gone
+        p += put;
+        n -= (size_t)put;
+    }
+    return 0;
+}
+
+static void* connection_main(void* arg) {
+    Connection* conn = arg;
+    CTMServer* server = conn->server;
+
+    for (;;) {
+        char magic[4];
+        uint32_t num_pairs;
+        if (read_full(conn->fd, magic, 4) != 0 || read_full(conn->fd, &num_pairs, sizeof(num_pairs)) != 0) break;
+        if (memcmp(magic, request_magic, 4) != 0 || num_pairs == 0 || num_pairs > CTM_SERVER_MAX_PAIRS) break;
+
+        size_t cells = (size_t)num_pairs * 16;
+        uint8_t* raw = malloc(2 * cells);
+        uint32_t* flat = malloc(2 * cells * sizeof(uint32_t));
+        int32_t* reply = malloc((1 + 2 * (size_t)num_pairs) * sizeof(int32_t));
+        int* counts = malloc(num_pairs * sizeof(int));
+        int* depths = malloc(num_pairs * sizeof(int));
+        if (!raw || !flat || !reply || !counts || !depths) {
+            fprintf(stderr, "Memory allocation failed for client request.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        int ok = read_full(conn->fd, raw, 2 * cells) == 0;
+        if (ok) {
+            for (size_t k = 0; k < 2 * cells; ++k) flat[k] = raw[k];
+            reply[0] = ctm_server_submit(server, flat, flat + cells, (int)num_pairs, counts, depths);
+            for (uint32_t i = 0; i < num_pairs; ++i) {
+                reply[1 + 2 * i] = reply[0] == 0 ? counts[i] : 0;
+                reply[2 + 2 * i] = reply[0] == 0 ? depths[i] : -1;
+            }
+            ok = write_full(conn->fd, reply, (1 + 2 * (size_t)num_pairs) * sizeof(int32_t)) == 0;
+        }
+
+        free(depths);
+        free(counts);
+        free(reply);
+        free(flat);
+        free(raw);
+        if (!ok) break;
+    }
+
+    pthread_mutex_lock(&server->lock);
+    conn->finished = 1;
+    pthread_mutex_unlock(&server->lock);
+    return NULL;
+}
+
+static void* acceptor_main(void* arg) {
+    CTMServer* server = arg;
+
+    for (;;) {
+        int fd = accept(server->listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) continue;
+            break;  // listening socket shut down
+        }
+        suppress_sigpipe(fd);
+
+        Connection* conn = calloc(1, sizeof(Connection));
+        if (!conn) {
+            fprintf(stderr, "Memory allocation failed for client connection.\n");
+            exit(EXIT_FAILURE);
+        }
+        conn->server = server;
+        conn->fd = fd;
+
+        pthread_mutex_lock(&server->lock);
+        if (server->stopping) {
+            pthread_mutex_unlock(&server->lock);
+            close(fd);
+            free(conn);
+            break;
+        }
+
+        // Reap handlers of closed connections so one-shot clients do not accumulate threads.
+        int kept = 0;
+        for (int c = 0; c < server->num_connections; ++c) {
+            Connection* old = server->connections[c];
+            if (old->finished) {
+                pthread_join(old->thread, NULL);
+                close(old->fd);
+                free(old);
+            } else {
+                server->connections[kept++] = old;
+            }
+        }
+        server->num_connections = kept;
+
+        Connection** grown = realloc(server->connections, (server->num_connections + 1) * sizeof(Connection*));
+        if (!grown) {
+            fprintf(stderr, "Memory allocation failed for client connection.\n");
+            exit(EXIT_FAILURE);
+        }
+        server->connections = grown;
+        server->connections[server->num_connections++] = conn;
+        pthread_mutex_unlock(&server->lock);
+
+        if (pthread_create(&conn->thread, NULL, connection_main, conn) != 0) {
+            fprintf(stderr, "Failed to start connection thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return NULL;
+}
+
+int ctm_server_listen(CTMServer* server, const char* socket_path) {
+    if (server->listening) return -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+
+    unlink(socket_path);
+    if (bind(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(fd, 64) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    server->listen_fd = fd;
+    server->socket_path = strdup(socket_path);
+    if (pthread_create(&server->acceptor, NULL, acceptor_main, server) != 0) {
+        fprintf(stderr, "Failed to start acceptor thread.\n");
+        exit(EXIT_FAILURE);
+    }
+    server->listening = 1;
+    return 0;
+}
+
+void ctm_server_destroy(CTMServer* server) {
+    if (!server) return;
+
+    if (server->listening) {
+        pthread_mutex_lock(&server->lock);
+        server->stopping = 1;
+        pthread_mutex_unlock(&server->lock);
+
+        shutdown(server->listen_fd, SHUT_RDWR);
+        close(server->listen_fd);
+        pthread_join(server->acceptor, NULL);
+        unlink(server->socket_path);
+        free(server->socket_path);
+
+        // Idle connections are woken by the shutdown; busy ones finish their query first.
+        for (int c = 0; c < server->num_connections; ++c) {
+            Connection* conn = server->connections[c];
+            shutdown(conn->fd, SHUT_RD);
+            pthread_join(conn->thread, NULL);
+            close(conn->fd);
+            free(conn);
+        }
+        free(server->connections);
+    }
+
+    pthread_mutex_lock(&server->lock);
+    server->stopping = 1;
+    pthread_cond_broadcast(&server->queue_ready);
+    pthread_mutex_unlock(&server->lock);
+    pthread_join(server->batcher, NULL);
+
+    pthread_cond_destroy(&server->batch_done);
+    pthread_cond_destroy(&server->queue_ready);
+    pthread_mutex_destroy(&server->lock);
+    ca_session_destroy(server->session);
+    free(server);
+}
+
+// -------------------- Client --------------------
+
+int ctm_client_query(const char* socket_path, const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs,
+                     int* match_counts, int* min_depths) {
+    if (num_pairs <= 0 || num_pairs > CTM_SERVER_MAX_PAIRS) return num_pairs == 0 ? 0 : -1;
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path)) return -1;
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    if (connect(fd, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(fd);
+        return -1;
+    }
+    suppress_sigpipe(fd);
+
+    size_t cells = (size_t)num_pairs * 16;
+    size_t request_size = 4 + sizeof(uint32_t) + 2 * cells;
+    uint8_t* request = malloc(request_size);
+    int32_t* reply = malloc((1 + 2 * (size_t)num_pairs) * sizeof(int32_t));
+    if (!request || !reply) {
+        fprintf(stderr, "Memory allocation failed for CTM query.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    uint32_t n = (uint32_t)num_pairs;
+    memcpy(request, request_magic, 4);
+    memcpy(request + 4, &n, sizeof(n));
+    uint8_t* cells_out = request + 4 + sizeof(n);
+    for (size_t k = 0; k < cells; ++k) {
+        cells_out[k] = (uint8_t)xs_flat[k];
+        cells_out[cells + k] = (uint8_t)ys_flat[k];
+    }
+
+    int status = -1;
+    if (write_full(fd, request, request_size) == 0 &&
+        read_full(fd, reply, (1 + 2 * (size_t)num_pairs) * sizeof(int32_t)) == 0 &&
+        reply[0] == 0) {
+        for (int i = 0; i < num_pairs; ++i) {
+            match_counts[i] = reply[1 + 2 * i];
+            min_depths[i] = reply[2 + 2 * i];
+        }
+        status = 0;
+    }
+
+    free(reply);
+    free(request);
+    close(fd);
+    return status;
+}
@@ -0,0 +1,117 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "ctm_table_4x4.h"
+
+#define CTM4X4_MAGIC "CTM4"
+#define CTM4X4_HEADER_BYTES 16
+
+static inline uint16_t flat_key(const uint32_t* flat) {
+    // Same bit order as matrix_hash: (0, 0) is the most significant bit.
+    uint16_t key = 0;
+    for (int i = 0; i < 16; ++i) key = (key << 1) | (flat[i] & 1);
+    return key;
+}
+
+CTMTable4x4* ctm4x4_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    size_t expected = CTM4X4_HEADER_BYTES + CTM4X4_ENTRIES * sizeof(double);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size != expected) {
+        close(fd);
+        return NULL;
+    }
+
+    void* mapping = mmap(NULL, expected, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+
+    const unsigned char* header = mapping;
+    uint32_t entries, byte_order;
+    memcpy(&entries, header + 4, sizeof(uint32_t));
+    memcpy(&byte_order, header + 8, sizeof(uint32_t));
+    if (memcmp(header, CTM4X4_MAGIC, 4) != 0 || entries != CTM4X4_ENTRIES || byte_order != CTM4X4_BYTE_ORDER) {
+        munmap(mapping, expected);
+        return NULL;
+    }
+
+    CTMTable4x4* table = malloc(sizeof(CTMTable4x4));
+    if (!table) {
+        fprintf(stderr, "Memory allocation failed for CTM table.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    table->values = (const double*)(header + CTM4X4_HEADER_BYTES);
+    table->mapping = mapping;
+    table->mapping_size = expected;
+    return table;
+}
+
+void ctm4x4_close(CTMTable4x4* table) {
+    if (!table) return;
+    munmap(table->mapping, table->mapping_size);
+    free(table);
+}
+
+int ctm4x4_write(const char* path, const double* values) {
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    unsigned char header[CTM4X4_HEADER_BYTES] = {0};
+    uint32_t entries = CTM4X4_ENTRIES;
+    uint32_t byte_order = CTM4X4_BYTE_ORDER;
+    memcpy(header, CTM4X4_MAGIC, 4);
+    memcpy(header + 4, &entries, sizeof(uint32_t));
+    memcpy(header + 8, &byte_order, sizeof(uint32_t));
+
+    int ok = fwrite(header, 1, CTM4X4_HEADER_BYTES, f) == CTM4X4_HEADER_BYTES
+          && fwrite(values, sizeof(double), CTM4X4_ENTRIES, f) == CTM4X4_ENTRIES;
+
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+void ctm4x4_lookup_batch(
+    const CTMTable4x4* table,
+    const uint32_t* grids_flat,
+    int num_grids,
+    double* complexities_out
+) {
+    for (int i = 0; i < num_grids; ++i) {
+        complexities_out[i] = table->values[flat_key(&grids_flat[i * 16])];
+    }
+}
+
+int ctm4x4_filter(
+    const CTMTable4x4* table,
+    const uint32_t* xs_flat,
+    int num_grids,
+    const uint32_t* x_test_flat,
+    int mode,
+    double threshold,
+    uint8_t* keep_out
+) {
+    if (mode != CTM4X4_MODE_ABSOLUTE && mode != CTM4X4_MODE_PERCENT) return -1;
+
+    double c_test = table->values[flat_key(x_test_flat)];
+    if (isnan(c_test)) return -1;
+
+    int kept = 0;
+    for (int i = 0; i < num_grids; ++i) {
+        double c_i = table->values[flat_key(&xs_flat[i * 16])];
+        double distance = fabs(c_i - c_test);
+        if (mode == CTM4X4_MODE_PERCENT) distance /= c_test;
+
+        keep_out[i] = !isnan(c_i) && distance <= threshold;
+        kept += keep_out[i];
+    }
+    return kept;
+}
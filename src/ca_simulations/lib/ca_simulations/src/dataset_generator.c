@@ -0,0 +1,273 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <prng/splitmix64.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "dataset_generator.h"
+
+#define RULE_UINT64_PARTS 8
+#define MAX_GRIDS_PER_TASK 4096
+#define TASK_STREAM_STRIDE 0xD1B54A32D192ED03ULL  // odd constant separating task streams
+
+typedef struct {
+    uint8_t* records;
+    const DatasetHeader* header;
+} GenerateContext;
+
+static size_t record_size_for(int num_train, int num_test) {
+    size_t bytes = RULE_UINT64_PARTS * sizeof(uint64_t) + 2 * (size_t)(num_train + num_test) * sizeof(uint16_t);
+    return (bytes + 7) & ~(size_t)7;
+}
+
+// Grid slot of pair i (train pairs first, then test pairs) within a record.
+static inline int input_slot(const DatasetHeader* h, int i) {
+    return i < (int)h->num_train ? i : (int)h->num_train + i;
+}
+
+static inline int output_slot(const DatasetHeader* h, int i) {
+    return i < (int)h->num_train ? (int)h->num_train + i : (int)(h->num_train + h->num_test) + i;
+}
+
+static void generate_task(const DatasetHeader* h, uint64_t task, uint8_t* record) {
+    uint64_t state = h->seed + (task + 1) * TASK_STREAM_STRIDE;
+    int n = h->num_train + h->num_test;
+
+    uint64_t* rule_number = (uint64_t*)record;
+    uint16_t* grids = (uint16_t*)(record + RULE_UINT64_PARTS * sizeof(uint64_t));
+
+    Rule512 rule;
+    memset(rule_number, 0, RULE_UINT64_PARTS * sizeof(uint64_t));
+    if (h->transformation == GEN_TRANSFORM_CA_RULE) {
+        for (int k = 0; k < RULE_UINT64_PARTS; ++k) rule_number[k] = splitmix64_next(&state);
+        rule_from_number(&rule, rule_number);
+    }
+
+    for (int i = 0; i < n; ++i) {
+        // Inputs are distinct within a task.
+        uint16_t x;
+        int duplicate;
+        do {
+            x = (uint16_t)splitmix64_next(&state);
+            duplicate = 0;
+            for (int j = 0; j < i; ++j) {
+                if (grids[input_slot(h, j)] == x) {
+                    duplicate = 1;
+                    break;
+                }
+            }
+        } while (duplicate);
+
+        uint16_t y = x;
+        if (h->transformation == GEN_TRANSFORM_BIT_INVERSION) {
+            y = (uint16_t)~x;
+        } else {
+            for (int t = 0; t < h->depth; ++t) y = apply_rule_packed(y, &rule, h->boundary_mode);
+        }
+
+        grids[input_slot(h, i)] = x;
+        grids[output_slot(h, i)] = y;
+    }
+}
+
+static void generate_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    (void)thread_id;
+    GenerateContext* ctx = arg;
+    for (int64_t t = begin; t < end; ++t) {
+        generate_task(ctx->header, (uint64_t)t, ctx->records + (size_t)t * ctx->header->record_size);
+    }
+}
+
+int generate_dataset(
+    const char* path,
+    int num_tasks,
+    int num_train,
+    int num_test,
+    int transformation,
+    int depth,
+    uint64_t seed,
+    int boundary_mode,
+    int num_threads
+) {
+    if (num_tasks <= 0 || num_train <= 0 || num_test < 0 || num_train + num_test > MAX_GRIDS_PER_TASK) return -1;
+    if (transformation != GEN_TRANSFORM_BIT_INVERSION && transformation != GEN_TRANSFORM_CA_RULE) return -1;
+    if (transformation == GEN_TRANSFORM_CA_RULE && depth <= 0) return -1;
+
+    DatasetHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, DATASET_MAGIC, sizeof(DATASET_MAGIC));
+    header.version = DATASET_VERSION;
+    header.num_tasks = num_tasks;
+    header.num_train = num_train;
+    header.num_test = num_test;
+    header.transformation = transformation;
+    header.boundary_mode = boundary_mode;
+    header.depth = (transformation == GEN_TRANSFORM_CA_RULE) ? depth : 0;
+    header.record_size = (uint32_t)record_size_for(num_train, num_test);
+    header.seed = seed;
+
+    size_t size = sizeof(DatasetHeader) + (size_t)num_tasks * header.record_size;
+
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return -1;
+    if (ftruncate(fd, (off_t)size) != 0) {
+        close(fd);
+        return -1;
+    }
+
+    uint8_t* mapping = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return -1;
+
+    memcpy(mapping, &header, sizeof(header));
+
+    GenerateContext ctx = { mapping + sizeof(DatasetHeader), (const DatasetHeader*)mapping };
+    parallel_for(num_threads, num_tasks, generate_range, &ctx);
+
+    int status = msync(mapping, size, MS_SYNC);
+    munmap(mapping, size);
+    return status == 0 ? 0 : -1;
+}
+
+Dataset* dataset_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(DatasetHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+
+    const DatasetHeader* h = mapping;
+    if (memcmp(h->magic, DATASET_MAGIC, sizeof(DATASET_MAGIC)) != 0
+        || h->version != DATASET_VERSION
+        || h->record_size != record_size_for(h->num_train, h->num_test)
+        || size != sizeof(DatasetHeader) + (size_t)h->num_tasks * h->record_size) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    Dataset* dataset = malloc(sizeof(Dataset));
+    if (!dataset) {
+        fprintf(stderr, "Memory allocation failed for dataset.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    dataset->header = h;
+    dataset->records = (const uint8_t*)mapping + sizeof(DatasetHeader);
+    dataset->mapping = mapping;
+    dataset->mapping_size = size;
+    return dataset;
+}
+
+void dataset_close(Dataset* dataset) {
+    if (!dataset) return;
+    munmap(dataset->mapping, dataset->mapping_size);
+    free(dataset);
+}
+
+const uint64_t* dataset_task_rule(const Dataset* dataset, int task) {
+    return (const uint64_t*)(dataset->records + (size_t)task * dataset->header->record_size);
+}
+
+const uint16_t* dataset_task_grids(const Dataset* dataset, int task) {
+    return (const uint16_t*)((const uint8_t*)dataset_task_rule(dataset, task) + RULE_UINT64_PARTS * sizeof(uint64_t));
+}
+
+// -------------------- JSON export --------------------
+
+static const char* transformation_name(uint32_t transformation) {
+    return transformation == GEN_TRANSFORM_CA_RULE ? "ca_rule" : "bit_inversion";
+}
+
+// Matches json.dump(..., indent=2): every list element on its own line.
+static void write_grid_json(FILE* f, uint16_t key, int indent) {
+    Matrix m;
+    hash_to_matrix(m, key);
+
+    fprintf(f, "[\n");
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        fprintf(f, "%*s[\n", indent + 2, "");
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            fprintf(f, "%*s%d%s\n", indent + 4, "", m[i][j], j < MATRIX_SIZE - 1 ? "," : "");
+        }
+        fprintf(f, "%*s]%s\n", indent + 2, "", i < MATRIX_SIZE - 1 ? "," : "");
+    }
+    fprintf(f, "%*s]", indent, "");
+}
+
+static void write_pairs_json(FILE* f, const char* name, const uint16_t* inputs, const uint16_t* outputs, int n, int last) {
+    fprintf(f, "  \"%s\": [", name);
+    if (n == 0) {
+        fprintf(f, "]%s\n", last ? "" : ",");
+        return;
+    }
+
+    fprintf(f, "\n");
+    for (int i = 0; i < n; ++i) {
+        fprintf(f, "    {\n      \"input\": ");
+        write_grid_json(f, inputs[i], 6);
+        fprintf(f, ",\n      \"output\": ");
+        write_grid_json(f, outputs[i], 6);
+        fprintf(f, "\n    }%s\n", i < n - 1 ? "," : "");
+    }
+    fprintf(f, "  ]%s\n", last ? "" : ",");
+}
+
+int dataset_export_json(const Dataset* dataset, const char* output_dir, int first_task, int count) {
+    const DatasetHeader* h = dataset->header;
+    if (first_task < 0) first_task = 0;
+    if (count < 0 || first_task + count > (int)h->num_tasks) count = (int)h->num_tasks - first_task;
+
+    const char* name = transformation_name(h->transformation);
+    int nt = h->num_train, ns = h->num_test;
+    int written = 0;
+
+    for (int t = first_task; t < first_task + count; ++t) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/task_%04d_%s_%" PRIu64 ".json", output_dir, t + 1, name, h->seed);
+
+        FILE* f = fopen(path, "w");
+        if (!f) return -1;
+
+        const uint16_t* grids = dataset_task_grids(dataset, t);
+        fprintf(f, "{\n");
+        write_pairs_json(f, "train", grids, grids + nt, nt, 0);
+        write_pairs_json(f, "test", grids + 2 * nt, grids + 2 * nt + ns, ns, 0);
+
+        fprintf(f, "  \"metadata\": {\n");
+        fprintf(f, "    \"transformation\": \"%s\",\n", name);
+        fprintf(f, "    \"seed\": %" PRIu64 ",\n", h->seed);
+        if (h->transformation == GEN_TRANSFORM_CA_RULE) {
+            const uint64_t* rule_number = dataset_task_rule(dataset, t);
+            fprintf(f, "    \"boundary_mode\": %d,\n", h->boundary_mode);
+            fprintf(f, "    \"depth\": %d,\n", h->depth);
+            fprintf(f, "    \"rule\": \"0x");
+            for (int k = RULE_UINT64_PARTS - 1; k >= 0; --k) fprintf(f, "%016" PRIx64, rule_number[k]);
+            fprintf(f, "\"\n");
+        } else {
+            fprintf(f, "    \"boundary_mode\": %d\n", h->boundary_mode);
+        }
+        fprintf(f, "  }\n}");
+
+        if (fclose(f) != 0) return -1;
+        written++;
+    }
+
+    return written;
+}
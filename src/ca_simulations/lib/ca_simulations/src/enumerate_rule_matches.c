@@ -0,0 +1,251 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "enumerate_rule_matches.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+#define RULE_BITS 512
+#define RULE_UINT64_PARTS (RULE_BITS / 64)
+
+typedef struct {
+    uint64_t* indices;  // family indices of matching rules
+    int* depths;
+    int count;
+    int capacity;
+} MatchList;
+
+typedef struct {
+    const uint16_t* xs;
+    const uint16_t* ys;
+    int num_pairs;
+    int family;
+    int boundary_mode;
+    int max_steps;
+    int collect;           // 1: fill lists, 0: counts and min depths only
+    MatchList* lists;      // [thread][pair]
+    uint64_t* counts;      // [thread][pair]
+    int* min_depths;       // [thread][pair]
+} EnumerateContext;
+
+static void match_list_push(MatchList* list, uint64_t index, int depth) {
+    if (list->count == list->capacity) {
+        list->capacity = list->capacity ? 2 * list->capacity : 64;
+        list->indices = realloc(list->indices, list->capacity * sizeof(uint64_t));
+        list->depths = realloc(list->depths, list->capacity * sizeof(int));
+        if (!list->indices || !list->depths) {
+            fprintf(stderr, "Memory allocation failed for match tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    list->indices[list->count] = index;
+    list->depths[list->count] = depth;
+    list->count++;
+}
+
+static void enumerate_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    EnumerateContext* ctx = arg;
+    SimScratch* scratch = sim_scratch_create();
+    Rule512 rule;
+
+    MatchList* lists = &ctx->lists[(size_t)thread_id * ctx->num_pairs];
+    uint64_t* counts = &ctx->counts[(size_t)thread_id * ctx->num_pairs];
+    int* min_depths = &ctx->min_depths[(size_t)thread_id * ctx->num_pairs];
+
+    for (int64_t index = begin; index < end; ++index) {
+        if ((index & 0xFFF) == 0 && is_interrupted()) break;
+
+        uint64_t params = (uint64_t)index;
+        rule_family_expand(ctx->family, &params, &rule);
+
+        for (int i = 0; i < ctx->num_pairs; ++i) {
+            int depth = simulate_packed_with_depth(ctx->xs[i], ctx->ys[i], &rule, ctx->boundary_mode, ctx->max_steps, scratch);
+            if (depth < 0) continue;
+
+            counts[i]++;
+            if (min_depths[i] < 0 || depth < min_depths[i]) min_depths[i] = depth;
+            if (ctx->collect) match_list_push(&lists[i], (uint64_t)index, depth);
+        }
+    }
+
+    sim_scratch_free(scratch);
+}
+
+static uint64_t run_enumeration(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    int collect,
+    EnumerateContext* ctx
+) {
+    int bits = rule_family_bits(family);
+    if (bits < 0 || bits > RULE_FAMILY_MAX_ENUM_BITS) {
+        fprintf(stderr, "Rule family %d cannot be enumerated exhaustively.\n", family);
+        return 0;
+    }
+
+    init_interrupt_flag();
+
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    num_threads = resolve_num_threads(num_threads);
+
+    uint64_t family_size = (uint64_t)1 << bits;
+
+    uint16_t* packed = malloc(2 * (size_t)num_pairs * sizeof(uint16_t));
+    ctx->lists = calloc((size_t)num_threads * num_pairs, sizeof(MatchList));
+    ctx->counts = calloc((size_t)num_threads * num_pairs, sizeof(uint64_t));
+    ctx->min_depths = malloc((size_t)num_threads * num_pairs * sizeof(int));
+    if (!packed || !ctx->lists || !ctx->counts || !ctx->min_depths) {
+        fprintf(stderr, "Memory allocation failed for enumeration.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Matrix m;
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        packed[i] = (uint16_t)matrix_hash(m);
+        flat_to_matrix(m, &ys_flat[i * 16]);
+        packed[num_pairs + i] = (uint16_t)matrix_hash(m);
+    }
+    for (size_t i = 0; i < (size_t)num_threads * num_pairs; ++i) {
+        ctx->min_depths[i] = -1;
+    }
+
+    ctx->xs = packed;
+    ctx->ys = packed + num_pairs;
+    ctx->num_pairs = num_pairs;
+    ctx->family = family;
+    ctx->boundary_mode = boundary_mode;
+    ctx->max_steps = max_steps;
+    ctx->collect = collect;
+
+    parallel_for(num_threads, (int64_t)family_size, enumerate_range, ctx);
+
+    free(packed);
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+    return family_size;
+}
+
+static void free_context(EnumerateContext* ctx, int num_threads, int num_pairs) {
+    if (ctx->lists) {
+        for (size_t i = 0; i < (size_t)num_threads * num_pairs; ++i) {
+            free(ctx->lists[i].indices);
+            free(ctx->lists[i].depths);
+        }
+    }
+    free(ctx->lists);
+    free(ctx->counts);
+    free(ctx->min_depths);
+}
+
+uint64_t enumerate_rule_matches(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint64_t*** match_rule_numbers,
+    int** match_rule_depths,
+    int* match_counts
+) {
+    EnumerateContext ctx = {0};
+    num_threads = resolve_num_threads(num_threads);
+
+    for (int i = 0; i < num_pairs; ++i) {
+        match_counts[i] = 0;
+        match_rule_depths[i] = NULL;
+        match_rule_numbers[i] = NULL;
+    }
+
+    uint64_t family_size = run_enumeration(xs_flat, ys_flat, num_pairs, family, boundary_mode,
+                                           max_steps, num_threads, 1, &ctx);
+    if (family_size == 0) return 0;
+
+    // Threads own contiguous, ordered index ranges, so concatenation keeps family order.
+    Rule512 rule;
+    for (int i = 0; i < num_pairs; ++i) {
+        int total = 0;
+        for (int t = 0; t < num_threads; ++t) total += ctx.lists[(size_t)t * num_pairs + i].count;
+
+        match_rule_depths[i] = calloc(total > 0 ? total : 1, sizeof(int));
+        match_rule_numbers[i] = calloc(total > 0 ? total : 1, sizeof(uint64_t*));
+        if (!match_rule_depths[i] || !match_rule_numbers[i]) {
+            fprintf(stderr, "Memory allocation failed for match tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int t = 0; t < num_threads; ++t) {
+            MatchList* list = &ctx.lists[(size_t)t * num_pairs + i];
+            for (int j = 0; j < list->count; ++j) {
+                int idx = match_counts[i]++;
+                match_rule_depths[i][idx] = list->depths[j];
+
+                match_rule_numbers[i][idx] = calloc(RULE_UINT64_PARTS, sizeof(uint64_t));
+                if (!match_rule_numbers[i][idx]) {
+                    fprintf(stderr, "Memory allocation failed for rule number.\n");
+                    exit(EXIT_FAILURE);
+                }
+
+                rule_family_expand(family, &list->indices[j], &rule);
+                compute_rule_number(&rule, match_rule_numbers[i][idx]);
+            }
+        }
+    }
+
+    free_context(&ctx, num_threads, num_pairs);
+    return family_size;
+}
+
+uint64_t enumerate_rule_ctm(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint64_t* match_counts,
+    int* min_depths
+) {
+    EnumerateContext ctx = {0};
+    num_threads = resolve_num_threads(num_threads);
+
+    for (int i = 0; i < num_pairs; ++i) {
+        match_counts[i] = 0;
+        min_depths[i] = -1;
+    }
+
+    uint64_t family_size = run_enumeration(xs_flat, ys_flat, num_pairs, family, boundary_mode,
+                                           max_steps, num_threads, 0, &ctx);
+    if (family_size == 0) return 0;
+
+    for (int t = 0; t < num_threads; ++t) {
+        for (int i = 0; i < num_pairs; ++i) {
+            size_t k = (size_t)t * num_pairs + i;
+            match_counts[i] += ctx.counts[k];
+            if (ctx.min_depths[k] >= 0 && (min_depths[i] < 0 || ctx.min_depths[k] < min_depths[i])) {
+                min_depths[i] = ctx.min_depths[k];
+            }
+        }
+    }
+
+    free_context(&ctx, num_threads, num_pairs);
+    return family_size;
+}
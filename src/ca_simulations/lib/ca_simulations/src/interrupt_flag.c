@@ -15,6 +15,10 @@ void init_interrupt_flag(void) {
     signal(SIGINT, handle_sigint);
 }
 
+void reset_interrupt_flag(void) {
+    stop_requested = 0;
+}
+
 int is_interrupted(void) {
     return stop_requested;
 }
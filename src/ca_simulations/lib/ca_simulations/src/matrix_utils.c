@@ -21,6 +21,14 @@ uint64_t matrix_hash(const Matrix m) {
     return h;
 }
 
+void hash_to_matrix(Matrix out, uint64_t h) {
+    for (int i = MATRIX_SIZE - 1; i >= 0; --i)
+        for (int j = MATRIX_SIZE - 1; j >= 0; --j) {
+            out[i][j] = h & 1;
+            h >>= 1;
+        }
+}
+
 void flat_to_matrix(Matrix out, const uint32_t* flat) {
     for (int i = 0; i < MATRIX_SIZE; ++i)
         for (int j = 0; j < MATRIX_SIZE; ++j)
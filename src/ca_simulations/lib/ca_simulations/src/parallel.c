@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "parallel.h"
+
+typedef struct {
+    parallel_range_fn fn;
+    void* ctx;
+    int thread_id;
+    int64_t begin;
+    int64_t end;
+} ParallelTask;
+
+static void* run_task(void* arg) {
+    ParallelTask* task = arg;
+    task->fn(task->ctx, task->thread_id, task->begin, task->end);
+    return NULL;
+}
+
+int resolve_num_threads(int requested) {
+    if (requested > 0) return requested;
+
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return cores > 0 ? (int)cores : 1;
+}
+
+void parallel_for(int num_threads, int64_t n, parallel_range_fn fn, void* ctx) {
+    if (n <= 0) return;
+
+    num_threads = resolve_num_threads(num_threads);
+    if (num_threads > n) num_threads = (int)n;
+
+    if (num_threads == 1) {
+        fn(ctx, 0, 0, n);
+        return;
+    }
+
+    ParallelTask* tasks = calloc(num_threads, sizeof(ParallelTask));
+    pthread_t* threads = calloc(num_threads, sizeof(pthread_t));
+    if (!tasks || !threads) {
+        fprintf(stderr, "Memory allocation failed for worker threads.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int t = 0; t < num_threads; ++t) {
+        tasks[t].fn = fn;
+        tasks[t].ctx = ctx;
+        tasks[t].thread_id = t;
+        tasks[t].begin = n * t / num_threads;
+        tasks[t].end = n * (t + 1) / num_threads;
+    }
+
+    // Thread 0's chunk runs on the calling thread.
+    for (int t = 1; t < num_threads; ++t) {
+        if (pthread_create(&threads[t], NULL, run_task, &tasks[t]) != 0) {
+            fprintf(stderr, "Failed to start worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    run_task(&tasks[0]);
+
+    for (int t = 1; t < num_threads; ++t) {
+        pthread_join(threads[t], NULL);
+    }
+
+    free(threads);
+    free(tasks);
+}
+
+// -------------------- Worker pool --------------------
+
+struct WorkerPool {
+    int num_threads;
+    pthread_t* threads;
+    ParallelTask* tasks;
+
+    pthread_mutex_t run_lock;  // serializes worker_pool_run callers
+    pthread_mutex_t lock;
+    pthread_cond_t work_ready;
+    pthread_cond_t work_done;
+    uint64_t generation;       // bumped for every job
+    int pending;               // workers still running the current job
+    int shutdown;
+};
+
+typedef struct {
+    WorkerPool* pool;
+    int index;
+} WorkerArg;
+
+static void* worker_main(void* arg) {
+    WorkerArg* worker = arg;
+    WorkerPool* pool = worker->pool;
+    int index = worker->index;
+    free(worker);
+
+    uint64_t seen = 0;
+    for (;;) {
+        pthread_mutex_lock(&pool->lock);
+        while (!pool->shutdown && pool->generation == seen) {
+            pthread_cond_wait(&pool->work_ready, &pool->lock);
+        }
+        if (pool->shutdown) {
+            pthread_mutex_unlock(&pool->lock);
+            return NULL;
+        }
+        seen = pool->generation;
+        ParallelTask task = pool->tasks[index];
+        pthread_mutex_unlock(&pool->lock);
+
+        if (task.begin < task.end) run_task(&task);
+
+        pthread_mutex_lock(&pool->lock);
+        if (--pool->pending == 0) pthread_cond_signal(&pool->work_done);
+        pthread_mutex_unlock(&pool->lock);
+    }
+}
+
+WorkerPool* worker_pool_create(int num_threads) {
+    WorkerPool* pool = calloc(1, sizeof(WorkerPool));
+    if (!pool) {
+        fprintf(stderr, "Memory allocation failed for worker pool.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pool->num_threads = resolve_num_threads(num_threads);
+    pool->threads = calloc(pool->num_threads, sizeof(pthread_t));
+    pool->tasks = calloc(pool->num_threads, sizeof(ParallelTask));
+    if (!pool->threads || !pool->tasks) {
+        fprintf(stderr, "Memory allocation failed for worker pool.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    pthread_mutex_init(&pool->run_lock, NULL);
+    pthread_mutex_init(&pool->lock, NULL);
+    pthread_cond_init(&pool->work_ready, NULL);
+    pthread_cond_init(&pool->work_done, NULL);
+
+    // Slot 0 runs on the calling thread; slots 1.. are persistent workers.
+    for (int t = 1; t < pool->num_threads; ++t) {
+        WorkerArg* arg = malloc(sizeof(WorkerArg));
+        if (!arg) {
+            fprintf(stderr, "Memory allocation failed for worker pool.\n");
+            exit(EXIT_FAILURE);
+        }
+        arg->pool = pool;
+        arg->index = t;
+        if (pthread_create(&pool->threads[t], NULL, worker_main, arg) != 0) {
+            fprintf(stderr, "Failed to start worker thread.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return pool;
+}
+
+int worker_pool_size(const WorkerPool* pool) {
+    return pool->num_threads;
+}
+
+void worker_pool_run(WorkerPool* pool, int64_t n, parallel_range_fn fn, void* ctx) {
+    if (n <= 0) return;
+
+    pthread_mutex_lock(&pool->run_lock);
+
+    int num_threads = pool->num_threads;
+    int active = (num_threads > n) ? (int)n : num_threads;
+
+    pthread_mutex_lock(&pool->lock);
+    for (int t = 0; t < num_threads; ++t) {
+        pool->tasks[t].fn = fn;
+        pool->tasks[t].ctx = ctx;
+        pool->tasks[t].thread_id = t;
+        pool->tasks[t].begin = (t < active) ? n * t / active : 0;
+        pool->tasks[t].end = (t < active) ? n * (t + 1) / active : 0;
+    }
+    pool->pending = num_threads - 1;
+    pool->generation++;
+    ParallelTask own = pool->tasks[0];
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    run_task(&own);
+
+    pthread_mutex_lock(&pool->lock);
+    while (pool->pending > 0) {
+        pthread_cond_wait(&pool->work_done, &pool->lock);
+    }
+    pthread_mutex_unlock(&pool->lock);
+
+    pthread_mutex_unlock(&pool->run_lock);
+}
+
+void worker_pool_destroy(WorkerPool* pool) {
+    if (!pool) return;
+
+    pthread_mutex_lock(&pool->lock);
+    pool->shutdown = 1;
+    pthread_cond_broadcast(&pool->work_ready);
+    pthread_mutex_unlock(&pool->lock);
+
+    for (int t = 1; t < pool->num_threads; ++t) {
+        pthread_join(pool->threads[t], NULL);
+    }
+
+    pthread_cond_destroy(&pool->work_done);
+    pthread_cond_destroy(&pool->work_ready);
+    pthread_mutex_destroy(&pool->lock);
+    pthread_mutex_destroy(&pool->run_lock);
+    free(pool->tasks);
+    free(pool->threads);
+    free(pool);
+}
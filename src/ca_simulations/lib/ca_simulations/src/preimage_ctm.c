@@ -0,0 +1,229 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <prng/prng.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "preimage_ctm.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+#define NUM_STATES (1 << 16)
+#define CHUNK_RULES 65536  // rules generated per batch before the parallel sweep
+
+#define ROW_INDEX(top, mid, bot) (((top) << 8) | ((mid) << 4) | (bot))
+
+void preimage_table_build(PreimageTable* table, const Rule512* rule, int boundary_mode) {
+    rule_row_table(rule, boundary_mode, table->rows);
+
+    memset(table->bots, 0, sizeof(table->bots));
+    memset(table->any_top, 0, sizeof(table->any_top));
+    for (int top = 0; top < 16; ++top) {
+        for (int mid = 0; mid < 16; ++mid) {
+            for (int bot = 0; bot < 16; ++bot) {
+                int out = table->rows[ROW_INDEX(top, mid, bot)];
+                table->bots[ROW_INDEX(top, mid, out)] |= 1 << bot;
+                table->any_top[(mid << 4) | out] |= 1 << bot;
+            }
+        }
+    }
+}
+
+/**
+ * Appends the predecessors of `state` to out[count..], skipping (and then marking)
+ * states already stamped with gen when stamps is not NULL. Returns the new count.
+ *
+ * Rows s1, s2, s3 are drawn from the bot masks of the rows above them, so only
+ * the two wrap-around constraints (output rows 0 and 3) are left to check.
+ */
+static int append_preimages(uint16_t state, const PreimageTable* table, int boundary_mode,
+                            uint16_t* out, int count, uint32_t* stamps, uint32_t gen) {
+    int toroidal = (boundary_mode == 1);
+    int z0 = (state >> 12) & 0xF;
+    int z1 = (state >> 8) & 0xF;
+    int z2 = (state >> 4) & 0xF;
+    int z3 = state & 0xF;
+
+    for (int s0 = 0; s0 < 16; ++s0) {
+        // Rows s1 that can yield z0 under some top row (s3 when toroidal, 0 otherwise).
+        int first = toroidal ? table->any_top[(s0 << 4) | z0] : table->bots[ROW_INDEX(0, s0, z0)];
+
+        for (int m1 = first; m1; m1 &= m1 - 1) {
+            int s1 = __builtin_ctz(m1);
+            for (int m2 = table->bots[ROW_INDEX(s0, s1, z1)]; m2; m2 &= m2 - 1) {
+                int s2 = __builtin_ctz(m2);
+                for (int m3 = table->bots[ROW_INDEX(s1, s2, z2)]; m3; m3 &= m3 - 1) {
+                    int s3 = __builtin_ctz(m3);
+                    if (table->rows[ROW_INDEX(toroidal ? s3 : 0, s0, s1)] != z0) continue;
+                    if (table->rows[ROW_INDEX(s2, s3, toroidal ? s0 : 0)] != z3) continue;
+
+                    uint16_t s = (uint16_t)((s0 << 12) | (s1 << 8) | (s2 << 4) | s3);
+                    if (stamps) {
+                        if (stamps[s] == gen) continue;
+                        stamps[s] = gen;
+                    }
+                    out[count++] = s;
+                }
+            }
+        }
+    }
+    return count;
+}
+
+int rule_preimages(uint16_t state, const PreimageTable* table, int boundary_mode, uint16_t* out) {
+    return append_preimages(state, table, boundary_mode, out, 0, NULL, 0);
+}
+
+int reverse_reach(
+    uint16_t y_target,
+    const PreimageTable* table,
+    int boundary_mode,
+    int max_steps,
+    SimScratch* scratch,
+    uint16_t* states_out,
+    int* depths_out
+) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    uint32_t gen = sim_scratch_begin(scratch);
+    scratch->stamps[y_target] = gen;
+    states_out[0] = y_target;
+    depths_out[0] = 0;
+
+    // The queue is the output: every state enters once, levels in order.
+    int head = 0, tail = 1;
+    while (head < tail) {
+        int depth = depths_out[head];
+        if (depth + 1 >= max_steps) break;
+
+        int end = append_preimages(states_out[head++], table, boundary_mode, states_out, tail, scratch->stamps, gen);
+        for (int k = tail; k < end; ++k) depths_out[k] = depth + 1;
+        tail = end;
+    }
+    return tail;
+}
+
+// -------------------- Column sweep --------------------
+
+typedef struct {
+    PreimageTable table;
+    SimScratch* scratch;
+    uint16_t* states;
+    int* depths;
+    int* counts;       // NUM_STATES
+    int* min_depths;   // NUM_STATES
+} ThreadState;
+
+typedef struct {
+    uint16_t y;
+    int boundary_mode;
+    int max_steps;
+    const Rule512* rules;  // current chunk
+    ThreadState* threads;
+} PreimageContext;
+
+static void reverse_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    PreimageContext* ctx = arg;
+    ThreadState* ts = &ctx->threads[thread_id];
+
+    for (int64_t r = begin; r < end; ++r) {
+        if ((r & 0xFF) == 0 && is_interrupted()) break;
+
+        preimage_table_build(&ts->table, &ctx->rules[r], ctx->boundary_mode);
+        int n = reverse_reach(ctx->y, &ts->table, ctx->boundary_mode, ctx->max_steps, ts->scratch, ts->states, ts->depths);
+
+        for (int k = 0; k < n; ++k) {
+            uint16_t x = ts->states[k];
+            ts->counts[x]++;
+            if (ts->min_depths[x] < 0 || ts->depths[k] < ts->min_depths[x]) ts->min_depths[x] = ts->depths[k];
+        }
+    }
+}
+
+int preimage_ctm(
+    uint32_t* y_flat,
+    unsigned int seed,
+    int num_rules,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    int* match_counts,
+    int* min_depths
+) {
+    init_interrupt_flag();
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    num_threads = resolve_num_threads(num_threads);
+
+    Rule512* rules = malloc(CHUNK_RULES * sizeof(Rule512));
+    ThreadState* threads = calloc(num_threads, sizeof(ThreadState));
+    if (!rules || !threads) {
+        fprintf(stderr, "Memory allocation failed for preimage sweep.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+        ThreadState* ts = &threads[t];
+        ts->scratch = sim_scratch_create();
+        ts->states = malloc(NUM_STATES * sizeof(uint16_t));
+        ts->depths = malloc(NUM_STATES * sizeof(int));
+        ts->counts = calloc(NUM_STATES, sizeof(int));
+        ts->min_depths = malloc(NUM_STATES * sizeof(int));
+        if (!ts->states || !ts->depths || !ts->counts || !ts->min_depths) {
+            fprintf(stderr, "Memory allocation failed for preimage sweep.\n");
+            exit(EXIT_FAILURE);
+        }
+        for (int x = 0; x < NUM_STATES; ++x) ts->min_depths[x] = -1;
+    }
+
+    Matrix m;
+    flat_to_matrix(m, y_flat);
+
+    PreimageContext ctx = {0};
+    ctx.y = (uint16_t)matrix_hash(m);
+    ctx.boundary_mode = boundary_mode;
+    ctx.max_steps = max_steps;
+    ctx.rules = rules;
+    ctx.threads = threads;
+
+    // Same rule sequence as simulate_rule_matches, generated in chunks.
+    prng_seed(seed);
+    int done = 0;
+    while (done < num_rules && !is_interrupted()) {
+        int n = (num_rules - done < CHUNK_RULES) ? num_rules - done : CHUNK_RULES;
+        for (int r = 0; r < n; ++r) random_rule(&rules[r]);
+
+        parallel_for(num_threads, n, reverse_range, &ctx);
+        done += n;
+    }
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+
+    for (int x = 0; x < NUM_STATES; ++x) {
+        match_counts[x] = 0;
+        min_depths[x] = -1;
+        for (int t = 0; t < num_threads; ++t) {
+            match_counts[x] += threads[t].counts[x];
+            int depth = threads[t].min_depths[x];
+            if (depth >= 0 && (min_depths[x] < 0 || depth < min_depths[x])) min_depths[x] = depth;
+        }
+    }
+
+    for (int t = 0; t < num_threads; ++t) {
+        sim_scratch_free(threads[t].scratch);
+        free(threads[t].states);
+        free(threads[t].depths);
+        free(threads[t].counts);
+        free(threads[t].min_depths);
+    }
+    free(threads);
+    free(rules);
+    return done;
+}
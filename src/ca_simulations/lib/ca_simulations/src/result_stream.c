@@ -0,0 +1,403 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "ca_session.h"
+#include "result_stream.h"
+
+#define MATCH_GROUP_RULES 16   // rules a worker takes at a time
+#define OUTPUT_GROUP_RULES 1   // trajectories can be long, so output workers take one rule at a time
+#define MAX_BLOCK_GROUPS 1024  // groups per sweep block
+
+// Records of one worker for the current block: its groups lane, lane + workers, ...
+typedef struct {
+    uint8_t* data;
+    size_t count;
+    size_t capacity;
+    size_t* group_ends;  // [k] record count after the worker's k-th group
+} RecordBuffer;
+
+struct ResultStream {
+    CASession* session;
+    size_t record_size;
+    int chunk_records;
+    int num_chunks;
+
+    // Ring: slots [head, head + filled) are published; the producer fills slot tail.
+    uint8_t* ring;
+    int* counts;
+    int head;
+    int tail;        // producer-owned
+    int filled;
+    int fill_count;  // producer-owned
+    int done;
+    int cancel;
+    int interrupted;
+    pthread_mutex_t lock;
+    pthread_cond_t not_empty;
+    pthread_cond_t not_full;
+    pthread_t thread;
+
+    // Sweep inputs
+    int outputs;          // 0: matches, 1: outputs
+    uint16_t* xs;
+    uint16_t* ys;
+    int num_pairs;
+    Rule512* rules;       // outputs: caller's rules
+    int num_rules;
+    int group_rules;
+    RecordBuffer* buffers;  // one per worker
+
+    // Current block: groups [0, block_limit) starting at rule block_start are kept.
+    // Workers lower block_limit once the block holds record_budget records.
+    pthread_mutex_t block_lock;
+    int block_start;
+    int block_limit;
+    size_t block_records;
+    size_t record_budget;   // the ring's capacity
+    size_t peak_records;    // most records buffered by one block
+};
+
+static void* buffer_push(RecordBuffer* buffer, size_t record_size) {
+    if (buffer->count == buffer->capacity) {
+        buffer->capacity = buffer->capacity ? 2 * buffer->capacity : 256;
+        buffer->data = realloc(buffer->data, buffer->capacity * record_size);
+        if (!buffer->data) {
+            fprintf(stderr, "Memory allocation failed for stream records.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+    return buffer->data + record_size * buffer->count++;
+}
+
+// -------------------- Ring buffer --------------------
+
+static int publish(ResultStream* stream) {
+    pthread_mutex_lock(&stream->lock);
+    stream->counts[stream->tail] = stream->fill_count;
+    stream->tail = (stream->tail + 1) % stream->num_chunks;
+    stream->filled++;
+    stream->fill_count = 0;
+    pthread_cond_signal(&stream->not_empty);
+
+    // Backpressure: the next slot must be free before the producer may write into it.
+    while (!stream->cancel && stream->filled == stream->num_chunks) {
+        pthread_cond_wait(&stream->not_full, &stream->lock);
+    }
+    int cancel = stream->cancel;
+    pthread_mutex_unlock(&stream->lock);
+    return cancel ? -1 : 0;
+}
+
+static int emit(ResultStream* stream, const uint8_t* records, size_t count) {
+    size_t chunk_bytes = (size_t)stream->chunk_records * stream->record_size;
+
+    while (count > 0) {
+        int slot = stream->tail;
+        size_t room = stream->chunk_records - stream->fill_count;
+        size_t n = count < room ? count : room;
+
+        memcpy(stream->ring + slot * chunk_bytes + stream->fill_count * stream->record_size,
+               records, n * stream->record_size);
+        stream->fill_count += (int)n;
+        records += n * stream->record_size;
+        count -= n;
+
+        if (stream->fill_count == stream->chunk_records && publish(stream) != 0) return -1;
+    }
+    return 0;
+}
+
+int result_stream_next(ResultStream* stream, void* buffer) {
+    pthread_mutex_lock(&stream->lock);
+    while (stream->filled == 0 && !stream->done) {
+        pthread_cond_wait(&stream->not_empty, &stream->lock);
+    }
+    if (stream->filled == 0) {
+        int interrupted = stream->interrupted;
+        pthread_mutex_unlock(&stream->lock);
+        return interrupted ? -1 : 0;
+    }
+    int slot = stream->head;
+    int count = stream->counts[slot];
+    pthread_mutex_unlock(&stream->lock);
+
+    // The slot stays published (and untouched by the producer) until released below.
+    size_t chunk_bytes = (size_t)stream->chunk_records * stream->record_size;
+    memcpy(buffer, stream->ring + slot * chunk_bytes, (size_t)count * stream->record_size);
+
+    pthread_mutex_lock(&stream->lock);
+    stream->head = (stream->head + 1) % stream->num_chunks;
+    stream->filled--;
+    pthread_cond_signal(&stream->not_full);
+    pthread_mutex_unlock(&stream->lock);
+    return count;
+}
+
+// -------------------- Producer --------------------
+
+static void match_rule(ResultStream* stream, int r, int thread_id, RecordBuffer* buffer) {
+    CASession* session = stream->session;
+    for (int i = 0; i < stream->num_pairs; ++i) {
+        int depth = simulate_packed_with_depth(stream->xs[i], stream->ys[i], &session->rules[r],
+                                               session->boundary_mode, session->max_steps, session->scratch[thread_id]);
+        if (depth < 0) continue;
+
+        StreamMatch* m = buffer_push(buffer, sizeof(StreamMatch));
+        m->rule_index = r;
+        m->pair = i;
+        m->depth = depth;
+    }
+}
+
+static void output_rule(ResultStream* stream, int r, int thread_id, RecordBuffer* buffer) {
+    CASession* session = stream->session;
+    uint16_t* trail = session->trails[thread_id];
+    int n = simulate_packed_trajectory(stream->xs[0], &stream->rules[r], session->boundary_mode,
+                                       session->max_steps, session->scratch[thread_id], trail);
+    for (int t = 0; t < n; ++t) {
+        StreamOutput* o = buffer_push(buffer, sizeof(StreamOutput));
+        o->rule_index = r;
+        o->depth = t;
+        o->state = trail[t];
+        o->reserved = 0;
+    }
+}
+
+// One lane per worker; lane l sweeps groups l, l + workers, ... of the block in order.
+static void sweep_lane(void* arg, int thread_id, int64_t lane, int64_t end) {
+    (void)end;
+    ResultStream* stream = arg;
+    RecordBuffer* buffer = &stream->buffers[thread_id];
+    int workers = worker_pool_size(stream->session->pool);
+    int total = stream->outputs ? stream->num_rules : stream->session->num_rules;
+
+    buffer->count = 0;
+    for (int k = 0;; ++k) {
+        int g = (int)lane + k * workers;
+        pthread_mutex_lock(&stream->block_lock);
+        int keep = g < stream->block_limit;
+        pthread_mutex_unlock(&stream->block_lock);
+        if (!keep) break;
+
+        if (is_interrupted()) {
+            pthread_mutex_lock(&stream->block_lock);
+            stream->block_limit = 0;
+            pthread_mutex_unlock(&stream->block_lock);
+            break;
+        }
+
+        size_t before = buffer->count;
+        int first = stream->block_start + g * stream->group_rules;
+        int last = first + stream->group_rules < total ? first + stream->group_rules : total;
+        for (int r = first; r < last; ++r) {
+            if (stream->outputs) output_rule(stream, r, thread_id, buffer);
+            else match_rule(stream, r, thread_id, buffer);
+        }
+        buffer->group_ends[k] = buffer->count;
+
+        // Groups up to g are complete or in progress; later ones can wait for the next block.
+        pthread_mutex_lock(&stream->block_lock);
+        stream->block_records += buffer->count - before;
+        if (stream->block_records >= stream->record_budget && g + 1 < stream->block_limit) stream->block_limit = g + 1;
+        pthread_mutex_unlock(&stream->block_lock);
+    }
+}
+
+static void* producer_main(void* arg) {
+    ResultStream* stream = arg;
+    CASession* session = stream->session;
+    int workers = worker_pool_size(session->pool);
+    int total = stream->outputs ? stream->num_rules : session->num_rules;
+
+    // Each block buffers about record_budget records (plus the groups in flight when it
+    // was reached) before they are copied into the ring, so memory stays tied to the ring.
+    for (int start = 0; start < total;) {
+        int groups = (total - start + stream->group_rules - 1) / stream->group_rules;
+        stream->block_start = start;
+        stream->block_limit = groups < MAX_BLOCK_GROUPS ? groups : MAX_BLOCK_GROUPS;
+        stream->block_records = 0;
+        worker_pool_run(session->pool, workers, sweep_lane, stream);
+
+        if (is_interrupted()) {
+            fprintf(stderr, "Interrupted by user (SIGINT).\n");
+            pthread_mutex_lock(&stream->lock);
+            stream->interrupted = 1;
+            pthread_mutex_unlock(&stream->lock);
+            break;
+        }
+
+        size_t buffered = 0;
+        for (int t = 0; t < workers; ++t) buffered += stream->buffers[t].count;
+        pthread_mutex_lock(&stream->lock);
+        if (buffered > stream->peak_records) stream->peak_records = buffered;
+        pthread_mutex_unlock(&stream->lock);
+
+        int cancelled = 0;
+        for (int g = 0; g < stream->block_limit && !cancelled; ++g) {
+            RecordBuffer* buffer = &stream->buffers[g % workers];
+            int k = g / workers;
+            size_t from = k > 0 ? buffer->group_ends[k - 1] : 0;
+            cancelled = emit(stream, buffer->data + from * stream->record_size, buffer->group_ends[k] - from) != 0;
+        }
+        if (cancelled) break;
+        start += stream->block_limit * stream->group_rules;
+    }
+
+    pthread_mutex_lock(&stream->lock);
+    if (stream->fill_count > 0 && !stream->cancel) {
+        stream->counts[stream->tail] = stream->fill_count;
+        stream->filled++;
+    }
+    stream->done = 1;
+    pthread_cond_broadcast(&stream->not_empty);
+    pthread_mutex_unlock(&stream->lock);
+    return NULL;
+}
+
+static ResultStream* stream_create(CASession* session, size_t record_size, int chunk_records, int num_chunks) {
+    if (chunk_records <= 0) chunk_records = 65536;
+    if (num_chunks <= 0) num_chunks = 4;
+
+    ResultStream* stream = calloc(1, sizeof(ResultStream));
+    if (!stream) {
+        fprintf(stderr, "Memory allocation failed for result stream.\n");
+        exit(EXIT_FAILURE);
+    }
+    stream->session = session;
+    stream->record_size = record_size;
+    stream->chunk_records = chunk_records;
+    stream->num_chunks = num_chunks;
+    stream->record_budget = (size_t)num_chunks * chunk_records;
+    stream->ring = malloc((size_t)num_chunks * chunk_records * record_size);
+    stream->counts = calloc(num_chunks, sizeof(int));
+    int workers = worker_pool_size(session->pool);
+    stream->buffers = calloc(workers, sizeof(RecordBuffer));
+    if (!stream->ring || !stream->counts || !stream->buffers) {
+        fprintf(stderr, "Memory allocation failed for result stream.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < workers; ++t) {
+        stream->buffers[t].group_ends = malloc((MAX_BLOCK_GROUPS / workers + 1) * sizeof(size_t));
+        if (!stream->buffers[t].group_ends) {
+            fprintf(stderr, "Memory allocation failed for result stream.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    pthread_mutex_init(&stream->lock, NULL);
+    pthread_mutex_init(&stream->block_lock, NULL);
+    pthread_cond_init(&stream->not_empty, NULL);
+    pthread_cond_init(&stream->not_full, NULL);
+    return stream;
+}
+
+static void stream_start(ResultStream* stream) {
+    reset_interrupt_flag();
+    if (pthread_create(&stream->thread, NULL, producer_main, stream) != 0) {
+        fprintf(stderr, "Failed to start stream producer thread.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+ResultStream* result_stream_matches(
+    CASession* session,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int chunk_records,
+    int num_chunks
+) {
+    ResultStream* stream = stream_create(session, sizeof(StreamMatch), chunk_records, num_chunks);
+
+    stream->group_rules = MATCH_GROUP_RULES;
+    stream->num_pairs = num_pairs;
+    stream->xs = malloc(2 * (size_t)(num_pairs > 0 ? num_pairs : 1) * sizeof(uint16_t));
+    if (!stream->xs) {
+        fprintf(stderr, "Memory allocation failed for result stream.\n");
+        exit(EXIT_FAILURE);
+    }
+    stream->ys = stream->xs + num_pairs;
+
+    Matrix m;
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        stream->xs[i] = (uint16_t)matrix_hash(m);
+        flat_to_matrix(m, &ys_flat[i * 16]);
+        stream->ys[i] = (uint16_t)matrix_hash(m);
+    }
+
+    stream_start(stream);
+    return stream;
+}
+
+ResultStream* result_stream_outputs(
+    CASession* session,
+    const uint32_t* x_flat,
+    const uint64_t* rules_flat,
+    int num_rules,
+    int chunk_records,
+    int num_chunks
+) {
+    ResultStream* stream = stream_create(session, sizeof(StreamOutput), chunk_records, num_chunks);
+
+    stream->outputs = 1;
+    stream->group_rules = OUTPUT_GROUP_RULES;
+    stream->num_rules = num_rules;
+    stream->xs = malloc(sizeof(uint16_t));
+    stream->rules = malloc((num_rules > 0 ? num_rules : 1) * sizeof(Rule512));
+    if (!stream->xs || !stream->rules) {
+        fprintf(stderr, "Memory allocation failed for result stream.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Matrix m;
+    flat_to_matrix(m, x_flat);
+    stream->xs[0] = (uint16_t)matrix_hash(m);
+    for (int r = 0; r < num_rules; ++r) {
+        rule_from_number(&stream->rules[r], &rules_flat[(size_t)r * 8]);
+    }
+
+    stream_start(stream);
+    return stream;
+}
+
+size_t result_stream_peak_records(ResultStream* stream) {
+    pthread_mutex_lock(&stream->lock);
+    size_t peak = stream->peak_records;
+    pthread_mutex_unlock(&stream->lock);
+    return peak;
+}
+
+void result_stream_close(ResultStream* stream) {
+    if (!stream) return;
+
+    pthread_mutex_lock(&stream->lock);
+    stream->cancel = 1;
+    pthread_cond_broadcast(&stream->not_full);
+    pthread_mutex_unlock(&stream->lock);
+    pthread_join(stream->thread, NULL);
+
+    int workers = worker_pool_size(stream->session->pool);
+    for (int t = 0; t < workers; ++t) {
+        free(stream->buffers[t].data);
+        free(stream->buffers[t].group_ends);
+    }
+    free(stream->buffers);
+
+    pthread_mutex_destroy(&stream->block_lock);
+    pthread_cond_destroy(&stream->not_full);
+    pthread_cond_destroy(&stream->not_empty);
+    pthread_mutex_destroy(&stream->lock);
+    free(stream->rules);
+    free(stream->xs);
+    free(stream->counts);
+    free(stream->ring);
+    free(stream);
+}
@@ -0,0 +1,304 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include <prng/prng.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "simulate_rule_outputs.h"
+#include "rule_bank.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+#define RULE_BANK_MAGIC "RBK1"
+#define RULE_BANK_HEADER_BYTES 64  // keeps every rule on its own cache line
+#define RULE_BANK_RULE_BYTES (RULE_UINT64_PARTS * sizeof(uint64_t))
+#define WRITE_CHUNK_RULES 4096
+
+int rule_bank_write(const char* path, unsigned int seed, int num_rules) {
+    if (num_rules < 0) return -1;
+
+    FILE* f = fopen(path, "wb");
+    if (!f) return -1;
+
+    unsigned char header[RULE_BANK_HEADER_BYTES] = {0};
+    uint32_t encoding = RULE_BANK_ENCODING_NUMBERS;
+    uint32_t seed32 = seed;
+    uint32_t byte_order = RULE_BANK_BYTE_ORDER;
+    uint64_t count = (uint64_t)num_rules;
+    memcpy(header, RULE_BANK_MAGIC, 4);
+    memcpy(header + 4, &encoding, sizeof(uint32_t));
+    memcpy(header + 8, &seed32, sizeof(uint32_t));
+    memcpy(header + 12, &byte_order, sizeof(uint32_t));
+    memcpy(header + 16, &count, sizeof(uint64_t));
+    int ok = fwrite(header, 1, RULE_BANK_HEADER_BYTES, f) == RULE_BANK_HEADER_BYTES;
+
+    uint64_t* numbers = malloc(WRITE_CHUNK_RULES * RULE_BANK_RULE_BYTES);
+    if (!numbers) {
+        fprintf(stderr, "Memory allocation failed for rule bank.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    // Same sequence as simulate_rule_matches.
+    prng_seed(seed);
+    for (int done = 0; ok && done < num_rules; ) {
+        int n = (num_rules - done < WRITE_CHUNK_RULES) ? num_rules - done : WRITE_CHUNK_RULES;
+        for (int r = 0; r < n; ++r) {
+            Rule512 rule;
+            random_rule(&rule);
+            compute_rule_number(&rule, &numbers[(size_t)r * RULE_UINT64_PARTS]);
+        }
+        ok = fwrite(numbers, RULE_BANK_RULE_BYTES, n, f) == (size_t)n;
+        done += n;
+    }
+
+    free(numbers);
+    return (fclose(f) == 0 && ok) ? 0 : -1;
+}
+
+RuleBank* rule_bank_open(const char* path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return NULL;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < RULE_BANK_HEADER_BYTES) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t size = (size_t)st.st_size;
+    void* mapping = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) return NULL;
+
+    const unsigned char* header = mapping;
+    uint32_t encoding, seed, byte_order;
+    uint64_t count;
+    memcpy(&encoding, header + 4, sizeof(uint32_t));
+    memcpy(&seed, header + 8, sizeof(uint32_t));
+    memcpy(&byte_order, header + 12, sizeof(uint32_t));
+    memcpy(&count, header + 16, sizeof(uint64_t));
+
+    // The rules are used in place, so only files in this host's byte order are accepted.
+    if (memcmp(header, RULE_BANK_MAGIC, 4) != 0
+        || byte_order != RULE_BANK_BYTE_ORDER
+        || encoding != RULE_BANK_ENCODING_NUMBERS
+        || count > INT32_MAX
+        || size != RULE_BANK_HEADER_BYTES + count * RULE_BANK_RULE_BYTES) {
+        munmap(mapping, size);
+        return NULL;
+    }
+
+    RuleBank* bank = malloc(sizeof(RuleBank));
+    if (!bank) {
+        fprintf(stderr, "Memory allocation failed for rule bank.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    bank->seed = seed;
+    bank->encoding = (int)encoding;
+    bank->num_rules = (int)count;
+    bank->rule_numbers = (const uint64_t*)(header + RULE_BANK_HEADER_BYTES);
+    bank->mapping = mapping;
+    bank->mapping_size = size;
+    return bank;
+}
+
+void rule_bank_close(RuleBank* bank) {
+    if (!bank) return;
+    munmap(bank->mapping, bank->mapping_size);
+    free(bank);
+}
+
+// -------------------- Queries --------------------
+
+static void clamp_range(const RuleBank* bank, int* begin, int* end) {
+    if (*begin < 0) *begin = 0;
+    if (*end > bank->num_rules) *end = bank->num_rules;
+    if (*end < *begin) *end = *begin;
+}
+
+static uint16_t* pack_pairs(const uint32_t* xs_flat, const uint32_t* ys_flat, int num_pairs) {
+    uint16_t* packed = malloc(2 * (size_t)(num_pairs > 0 ? num_pairs : 1) * sizeof(uint16_t));
+    if (!packed) {
+        fprintf(stderr, "Memory allocation failed for rule bank query.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Matrix m;
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        packed[i] = (uint16_t)matrix_hash(m);
+        flat_to_matrix(m, &ys_flat[i * 16]);
+        packed[num_pairs + i] = (uint16_t)matrix_hash(m);
+    }
+    return packed;
+}
+
+// Rule-major sweep shared by matches and ctm; indices/depths are NULL for counts only.
+static void sweep(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int boundary_mode,
+    int max_steps,
+    int** indices,
+    int** depths,
+    int* counts,
+    int* min_depths
+) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    clamp_range(bank, &begin, &end);
+
+    uint16_t* packed = pack_pairs(xs_flat, ys_flat, num_pairs);
+    int* capacity = calloc(num_pairs > 0 ? num_pairs : 1, sizeof(int));
+    SimScratch* scratch = sim_scratch_create();
+    if (!capacity) {
+        fprintf(stderr, "Memory allocation failed for rule bank query.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int i = 0; i < num_pairs; ++i) {
+        counts[i] = 0;
+        if (min_depths) min_depths[i] = -1;
+        if (indices) indices[i] = depths[i] = NULL;
+    }
+
+    for (int r = begin; r < end; ++r) {
+        Rule512 rule;
+        rule_from_number(&rule, &bank->rule_numbers[(size_t)r * RULE_UINT64_PARTS]);
+
+        for (int i = 0; i < num_pairs; ++i) {
+            int depth = simulate_packed_with_depth(packed[i], packed[num_pairs + i], &rule, boundary_mode, max_steps, scratch);
+            if (depth < 0) continue;
+
+            if (min_depths && (min_depths[i] < 0 || depth < min_depths[i])) min_depths[i] = depth;
+            if (indices) {
+                if (counts[i] == capacity[i]) {
+                    capacity[i] = capacity[i] ? 2 * capacity[i] : 16;
+                    indices[i] = realloc(indices[i], capacity[i] * sizeof(int));
+                    depths[i] = realloc(depths[i], capacity[i] * sizeof(int));
+                    if (!indices[i] || !depths[i]) {
+                        fprintf(stderr, "Memory allocation failed for rule bank matches.\n");
+                        exit(EXIT_FAILURE);
+                    }
+                }
+                indices[i][counts[i]] = r;
+                depths[i][counts[i]] = depth;
+            }
+            counts[i]++;
+        }
+    }
+
+    sim_scratch_free(scratch);
+    free(capacity);
+    free(packed);
+}
+
+void rule_bank_matches(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int boundary_mode,
+    int max_steps,
+    int** match_rule_indices,
+    int** match_rule_depths,
+    int* match_counts
+) {
+    sweep(bank, begin, end, xs_flat, ys_flat, num_pairs, boundary_mode, max_steps,
+          match_rule_indices, match_rule_depths, match_counts, NULL);
+}
+
+void rule_bank_free_matches(
+    int num_pairs,
+    int** match_rule_indices,
+    int** match_rule_depths
+) {
+    for (int i = 0; i < num_pairs; ++i) {
+        free(match_rule_indices[i]);
+        free(match_rule_depths[i]);
+    }
+}
+
+void rule_bank_ctm(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* xs_flat,
+    const uint32_t* ys_flat,
+    int num_pairs,
+    int boundary_mode,
+    int max_steps,
+    int* match_counts,
+    int* min_depths
+) {
+    sweep(bank, begin, end, xs_flat, ys_flat, num_pairs, boundary_mode, max_steps,
+          NULL, NULL, match_counts, min_depths);
+}
+
+void rule_bank_outputs(
+    const RuleBank* bank,
+    int begin,
+    int end,
+    const uint32_t* x_flat,
+    int boundary_mode,
+    int max_steps,
+    OutputMap** output_maps_out
+) {
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    clamp_range(bank, &begin, &end);
+
+    int count = end - begin;
+    OutputMap* output_maps = calloc(count > 0 ? count : 1, sizeof(OutputMap));
+    uint16_t* trail = malloc((size_t)max_steps * sizeof(uint16_t));
+    SimScratch* scratch = sim_scratch_create();
+    if (!output_maps || !trail) {
+        fprintf(stderr, "Memory allocation failed for output maps.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Matrix x;
+    flat_to_matrix(x, x_flat);
+    uint16_t x_packed = (uint16_t)matrix_hash(x);
+
+    for (int k = 0; k < count; ++k) {
+        const uint64_t* number = &bank->rule_numbers[(size_t)(begin + k) * RULE_UINT64_PARTS];
+        Rule512 rule;
+        rule_from_number(&rule, number);
+
+        int n = simulate_packed_trajectory(x_packed, &rule, boundary_mode, max_steps, scratch, trail);
+
+        OutputMap* map = &output_maps[k];
+        memcpy(map->rule_number, number, RULE_BANK_RULE_BYTES);
+        map->outputs = malloc((n > 0 ? n : 1) * sizeof(Matrix));
+        map->depths = malloc((n > 0 ? n : 1) * sizeof(int));
+        if (!map->outputs || !map->depths) {
+            fprintf(stderr, "Memory allocation failed for output tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int t = 0; t < n; ++t) {
+            hash_to_matrix(map->outputs[t], trail[t]);
+            map->depths[t] = t;
+        }
+        map->num_outputs = n;
+    }
+
+    sim_scratch_free(scratch);
+    free(trail);
+    *output_maps_out = output_maps;
+}
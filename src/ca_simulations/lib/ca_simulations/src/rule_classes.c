@@ -0,0 +1,129 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "rule_classes.h"
+
+#define KEY_WORDS 16  // used-code mask (8 words) followed by the rule bits under it (8 words)
+
+typedef struct {
+    const uint64_t* rules_flat;
+    const uint16_t* xs;
+    int num_xs;
+    int boundary_mode;
+    int max_steps;
+    uint64_t* keys;  // num_rules × KEY_WORDS
+} TraceContext;
+
+static void trace_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    (void)thread_id;
+    TraceContext* ctx = arg;
+    SimScratch* scratch = sim_scratch_create();
+    Rule512 rule;
+
+    for (int64_t r = begin; r < end; ++r) {
+        uint64_t* key = &ctx->keys[r * KEY_WORDS];
+        rule_from_number(&rule, &ctx->rules_flat[r * 8]);
+
+        for (int i = 0; i < ctx->num_xs; ++i) {
+            simulate_packed_trajectory_traced(ctx->xs[i], &rule, ctx->boundary_mode, ctx->max_steps, scratch, NULL, key);
+        }
+
+        // Table bits in the same layout as the mask: code nb is bit nb % 64 of word nb / 64.
+        for (int w = 0; w < 8; ++w) {
+            uint64_t bits = 0;
+            for (int b = 0; b < 8; ++b) bits |= (uint64_t)rule.table[w * 8 + b] << (8 * b);
+            key[8 + w] = bits & key[w];
+        }
+    }
+
+    sim_scratch_free(scratch);
+}
+
+static uint64_t hash_key(const uint64_t* key) {
+    uint64_t h = 0x9E3779B97F4A7C15ULL;
+    for (int w = 0; w < KEY_WORDS; ++w) {
+        h ^= key[w];
+        h *= 0xBF58476D1CE4E5B9ULL;
+        h ^= h >> 31;
+    }
+    return h;
+}
+
+int rule_equivalence_classes(
+    const uint64_t* rules_flat,
+    int num_rules,
+    const uint32_t* xs_flat,
+    int num_xs,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    int* class_of,
+    int* representatives,
+    int* multiplicities,
+    int* used_codes
+) {
+    if (num_rules <= 0) return 0;
+
+    uint16_t* xs = malloc((num_xs > 0 ? num_xs : 1) * sizeof(uint16_t));
+    uint64_t* keys = calloc((size_t)num_rules * KEY_WORDS, sizeof(uint64_t));
+    if (!xs || !keys) {
+        fprintf(stderr, "Memory allocation failed for rule classes.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    Matrix m;
+    for (int i = 0; i < num_xs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        xs[i] = (uint16_t)matrix_hash(m);
+    }
+
+    TraceContext ctx = {rules_flat, xs, num_xs, boundary_mode, max_steps, keys};
+    parallel_for(num_threads, num_rules, trace_range, &ctx);
+
+    // Open addressing over class representatives, at most half full.
+    size_t capacity = 2;
+    while (capacity < 2 * (size_t)num_rules) capacity *= 2;
+    int* slots = malloc(capacity * sizeof(int));
+    if (!slots) {
+        fprintf(stderr, "Memory allocation failed for rule classes.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t k = 0; k < capacity; ++k) slots[k] = -1;
+
+    int num_classes = 0;
+    for (int r = 0; r < num_rules; ++r) {
+        const uint64_t* key = &keys[(size_t)r * KEY_WORDS];
+        size_t k = hash_key(key) & (capacity - 1);
+
+        while (slots[k] >= 0) {
+            int c = slots[k];
+            if (memcmp(&keys[(size_t)representatives[c] * KEY_WORDS], key, KEY_WORDS * sizeof(uint64_t)) == 0) break;
+            k = (k + 1) & (capacity - 1);
+        }
+
+        if (slots[k] < 0) {
+            slots[k] = num_classes;
+            representatives[num_classes] = r;
+            multiplicities[num_classes] = 0;
+            if (used_codes) {
+                int codes = 0;
+                for (int w = 0; w < 8; ++w) codes += __builtin_popcountll(key[w]);
+                used_codes[num_classes] = codes;
+            }
+            num_classes++;
+        }
+
+        class_of[r] = slots[k];
+        multiplicities[slots[k]]++;
+    }
+
+    free(slots);
+    free(keys);
+    free(xs);
+    return num_classes;
+}
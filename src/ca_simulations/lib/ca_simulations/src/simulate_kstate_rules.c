@@ -0,0 +1,289 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include <prng/prng.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "parallel.h"
+#include "ca_kstate.h"
+#include "simulate_kstate_rules.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+static void flat_to_kstate(KState* out, const uint32_t* flat) {
+    Matrix m;
+    flat_to_matrix(m, flat);
+    *out = kstate_from_matrix(m);
+}
+
+static KStateScratch** create_scratches(int num_threads, int max_steps) {
+    KStateScratch** scratch = malloc(num_threads * sizeof(KStateScratch*));
+    if (!scratch) {
+        fprintf(stderr, "Memory allocation failed for state tracking.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < num_threads; ++t) scratch[t] = kstate_scratch_create(max_steps);
+    return scratch;
+}
+
+static void free_scratches(KStateScratch** scratch, int num_threads) {
+    for (int t = 0; t < num_threads; ++t) kstate_scratch_free(scratch[t]);
+    free(scratch);
+}
+
+// -------------------- Matches --------------------
+
+typedef struct {
+    const KRule* rules;
+    const KState* xs;
+    const KState* ys;
+    int num_pairs;
+    int boundary_mode;
+    int max_steps;
+    KStateScratch** scratch;  // one per thread
+    int* depths;              // num_rules × num_pairs, -1 where no match
+} MatchContext;
+
+static void match_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    MatchContext* ctx = arg;
+    KStateScratch* scratch = ctx->scratch[thread_id];
+
+    for (int64_t r = begin; r < end; ++r) {
+        if (is_interrupted()) break;
+        for (int i = 0; i < ctx->num_pairs; ++i) {
+            ctx->depths[r * ctx->num_pairs + i] = kstate_simulate_with_depth(
+                ctx->xs[i], ctx->ys[i], &ctx->rules[r], ctx->boundary_mode, ctx->max_steps, scratch);
+        }
+    }
+}
+
+void simulate_kstate_matches(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int num_rules,
+    unsigned int seed,
+    int num_colors,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    uint8_t*** match_rule_tables,
+    int** match_rule_depths,
+    int* match_counts
+) {
+    int table_size = kstate_table_size(family, num_colors);
+    if (table_size < 0) {
+        fprintf(stderr, "Unsupported k-state rule family %d with %d colors.\n", family, num_colors);
+        for (int i = 0; i < num_pairs; ++i) {
+            match_counts[i] = 0;
+            match_rule_depths[i] = NULL;
+            match_rule_tables[i] = NULL;
+        }
+        return;
+    }
+
+    init_interrupt_flag();
+
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    prng_seed(seed);
+
+    KRule* rules = calloc(num_rules, sizeof(KRule));
+    if (!rules) {
+        fprintf(stderr, "Memory allocation failed for rules.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int r = 0; r < num_rules; ++r) {
+        kstate_random_rule(&rules[r], family, num_colors);
+    }
+
+    // Keep pairs that are never reached (SIGINT) safe to pass to free_kstate_matches
+    for (int i = 0; i < num_pairs; ++i) {
+        match_counts[i] = 0;
+        match_rule_depths[i] = NULL;
+        match_rule_tables[i] = NULL;
+    }
+
+    KState* xs = malloc((num_pairs > 0 ? num_pairs : 1) * sizeof(KState));
+    KState* ys = malloc((num_pairs > 0 ? num_pairs : 1) * sizeof(KState));
+    int* depths = malloc(((size_t)num_rules * num_pairs > 0 ? (size_t)num_rules * num_pairs : 1) * sizeof(int));
+    if (!xs || !ys || !depths) {
+        fprintf(stderr, "Memory allocation failed for match tracking.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_kstate(&xs[i], &xs_flat[i * 16]);
+        flat_to_kstate(&ys[i], &ys_flat[i * 16]);
+    }
+    for (size_t k = 0; k < (size_t)num_rules * num_pairs; ++k) depths[k] = -1;
+
+    // Rule-major: each thread owns a contiguous rule range, so matches stay in rule order.
+    num_threads = resolve_num_threads(num_threads);
+    MatchContext ctx = {rules, xs, ys, num_pairs, boundary_mode, max_steps, create_scratches(num_threads, max_steps), depths};
+    parallel_for(num_threads, num_rules, match_range, &ctx);
+    free_scratches(ctx.scratch, num_threads);
+
+    for (int i = 0; i < num_pairs; ++i) {
+        int count = 0;
+        for (int r = 0; r < num_rules; ++r) count += depths[(size_t)r * num_pairs + i] >= 0;
+
+        match_rule_depths[i] = malloc((count > 0 ? count : 1) * sizeof(int));
+        match_rule_tables[i] = malloc((count > 0 ? count : 1) * sizeof(uint8_t*));
+        if (!match_rule_depths[i] || !match_rule_tables[i]) {
+            fprintf(stderr, "Memory allocation failed for match tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int r = 0; r < num_rules; ++r) {
+            int depth = depths[(size_t)r * num_pairs + i];
+            if (depth < 0) continue;
+
+            int idx = match_counts[i]++;
+            match_rule_depths[i][idx] = depth;
+            match_rule_tables[i][idx] = malloc(table_size);
+            if (!match_rule_tables[i][idx]) {
+                fprintf(stderr, "Memory allocation failed for rule table.\n");
+                exit(EXIT_FAILURE);
+            }
+            memcpy(match_rule_tables[i][idx], rules[r].table, table_size);
+        }
+    }
+
+    free(depths);
+    free(ys);
+    free(xs);
+    free(rules);
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+}
+
+void free_kstate_matches(
+    int num_pairs,
+    int* match_counts,
+    int** match_rule_depths,
+    uint8_t*** match_rule_tables
+) {
+    for (int i = 0; i < num_pairs; ++i) {
+        if (match_rule_tables[i]) {
+            for (int j = 0; j < match_counts[i]; ++j) {
+                free(match_rule_tables[i][j]);
+            }
+        }
+        free(match_rule_tables[i]);
+        free(match_rule_depths[i]);
+    }
+}
+
+// -------------------- Outputs --------------------
+
+typedef struct {
+    const uint8_t* tables_flat;
+    int table_size;
+    int num_colors;
+    int family;
+    int boundary_mode;
+    int max_steps;
+    KState x;
+    KStateScratch** scratch;  // one per thread
+    KOutputMap* output_maps;
+} OutputContext;
+
+static void output_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    OutputContext* ctx = arg;
+    KStateScratch* scratch = ctx->scratch[thread_id];
+
+    KState* trail = malloc(ctx->max_steps * sizeof(KState));
+    if (!trail) {
+        fprintf(stderr, "Memory allocation failed for output tracking.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    KRule rule;
+    rule.num_colors = ctx->num_colors;
+    rule.family = ctx->family;
+    memset(rule.table, 0, sizeof(rule.table));
+
+    for (int64_t r = begin; r < end; ++r) {
+        if (is_interrupted()) break;
+
+        KOutputMap* map = &ctx->output_maps[r];
+        memcpy(rule.table, &ctx->tables_flat[(size_t)r * ctx->table_size], ctx->table_size);
+        memcpy(map->table, rule.table, sizeof(map->table));
+
+        int n = kstate_simulate_trajectory(ctx->x, &rule, ctx->boundary_mode, ctx->max_steps, scratch, trail);
+
+        map->outputs = malloc((n > 0 ? n : 1) * sizeof(Matrix));
+        map->depths = malloc((n > 0 ? n : 1) * sizeof(int));
+        if (!map->outputs || !map->depths) {
+            fprintf(stderr, "Memory allocation failed for output tracking.\n");
+            exit(EXIT_FAILURE);
+        }
+
+        for (int t = 0; t < n; ++t) {
+            kstate_to_matrix(map->outputs[t], trail[t]);
+            map->depths[t] = t;
+        }
+        map->num_outputs = n;
+    }
+    free(trail);
+}
+
+void simulate_kstate_outputs(
+    uint32_t* x_flat,
+    uint8_t* tables_flat,
+    int num_rules,
+    int num_colors,
+    int family,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    KOutputMap** output_maps_out
+) {
+    int table_size = kstate_table_size(family, num_colors);
+    if (table_size < 0) {
+        fprintf(stderr, "Unsupported k-state rule family %d with %d colors.\n", family, num_colors);
+        *output_maps_out = NULL;
+        return;
+    }
+
+    init_interrupt_flag();
+
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+
+    KOutputMap* output_maps = calloc(num_rules > 0 ? num_rules : 1, sizeof(KOutputMap));
+    if (!output_maps) {
+        fprintf(stderr, "Memory allocation failed for output maps.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    num_threads = resolve_num_threads(num_threads);
+    OutputContext ctx = {tables_flat, table_size, num_colors, family, boundary_mode, max_steps, 0,
+                         create_scratches(num_threads, max_steps), output_maps};
+    flat_to_kstate(&ctx.x, x_flat);
+    parallel_for(num_threads, num_rules, output_range, &ctx);
+    free_scratches(ctx.scratch, num_threads);
+
+    *output_maps_out = output_maps;
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+}
+
+void free_kstate_output_maps(int num_rules, KOutputMap* output_maps) {
+    if (!output_maps) return;
+
+    for (int r = 0; r < num_rules; ++r) {
+        free(output_maps[r].outputs);
+        free(output_maps[r].depths);
+    }
+    free(output_maps);
+}
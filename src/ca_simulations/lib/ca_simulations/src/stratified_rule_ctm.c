@@ -0,0 +1,234 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+
+#include <prng/prng.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "stratified_rule_ctm.h"
+
+#ifndef DEFAULT_MAX_STEPS
+#define DEFAULT_MAX_STEPS 65536
+#endif
+
+#define RULE_BITS 512
+#define CHUNK_RULES 65536  // rules generated per batch before the parallel sweep
+#define CORE_HALF_WIDTH 48  // inner bands split [256 - 48, 256 + 48); the outer two run on to 0 and 512
+
+typedef struct {
+    const uint16_t* xs;
+    const uint16_t* ys;
+    int num_pairs;
+    int num_strata;
+    int boundary_mode;
+    int max_steps;
+    const Rule512* rules;     // current chunk
+    const int* strata;        // band of each rule in the chunk
+    SimScratch** scratch;     // one per thread
+    uint64_t* counts;         // [thread][pair][stratum]
+    int* min_depths;          // [thread][pair]
+} StratifiedContext;
+
+static int stratum_lower(int num_strata, int h) {
+    if (h <= 0) return 0;
+    if (h >= num_strata) return RULE_BITS + 1;
+    return RULE_BITS / 2 - CORE_HALF_WIDTH + (2 * CORE_HALF_WIDTH * h) / num_strata;
+}
+
+void stratum_density_range(int num_strata, int h, int* lo, int* hi) {
+    *lo = stratum_lower(num_strata, h);
+    *hi = stratum_lower(num_strata, h + 1) - 1;
+}
+
+// C(512, d) / C(512, 256): relative density masses, from about 1e-154 at the ends to 1.
+static void density_mass(double* mass) {
+    double peak = lgamma(RULE_BITS / 2 + 1.0);
+    for (int d = 0; d <= RULE_BITS; ++d) {
+        mass[d] = exp(2.0 * peak - lgamma(d + 1.0) - lgamma(RULE_BITS - d + 1.0));
+    }
+}
+
+// Density d in [lo, hi] with probability ∝ C(512, d); cdf holds the band's running sums.
+static int sample_density(const double* cdf, int lo, int hi) {
+    double u = (double)(prng_next() >> 11) * 0x1p-53 * cdf[hi];
+
+    int a = lo, b = hi;
+    while (a < b) {
+        int mid = (a + b) / 2;
+        if (cdf[mid] > u) b = mid;
+        else a = mid + 1;
+    }
+    return a;
+}
+
+static void simulate_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    StratifiedContext* ctx = arg;
+    SimScratch* scratch = ctx->scratch[thread_id];
+
+    uint64_t* counts = &ctx->counts[(size_t)thread_id * ctx->num_pairs * ctx->num_strata];
+    int* min_depths = &ctx->min_depths[(size_t)thread_id * ctx->num_pairs];
+
+    for (int64_t r = begin; r < end; ++r) {
+        if ((r & 0xFFF) == 0 && is_interrupted()) break;
+
+        int h = ctx->strata[r];
+        for (int i = 0; i < ctx->num_pairs; ++i) {
+            int depth = simulate_packed_with_depth(ctx->xs[i], ctx->ys[i], &ctx->rules[r], ctx->boundary_mode, ctx->max_steps, scratch);
+            if (depth < 0) continue;
+
+            counts[(size_t)i * ctx->num_strata + h]++;
+            if (min_depths[i] < 0 || depth < min_depths[i]) min_depths[i] = depth;
+        }
+    }
+}
+
+void stratified_estimate(
+    int num_strata,
+    const double* stratum_weights,
+    const int* samples_per_stratum,
+    const uint64_t* counts,
+    double* m_estimate,
+    double* variance
+) {
+    double m = 0.0, var = 0.0;
+    for (int h = 0; h < num_strata; ++h) {
+        int n = samples_per_stratum[h];
+        if (n <= 0) continue;
+
+        double p = (double)counts[h] / n;
+        double w = stratum_weights[h];
+        m += w * p;
+        var += w * w * p * (1.0 - p) / (n > 1 ? n - 1 : 1);
+    }
+    *m_estimate = m;
+    *variance = var;
+}
+
+uint64_t stratified_rule_ctm(
+    uint32_t* xs_flat,
+    uint32_t* ys_flat,
+    int num_pairs,
+    int num_strata,
+    const int* samples_per_stratum,
+    unsigned int seed,
+    int boundary_mode,
+    int max_steps,
+    int num_threads,
+    double* stratum_weights,
+    uint64_t* stratum_counts,
+    int* min_depths,
+    double* m_estimates,
+    double* variances
+) {
+    if (num_strata < 1 || num_strata > 2 * CORE_HALF_WIDTH) {
+        fprintf(stderr, "Number of density strata must be in [1, %d].\n", 2 * CORE_HALF_WIDTH);
+        return 0;
+    }
+
+    init_interrupt_flag();
+    if (max_steps <= 0) max_steps = DEFAULT_MAX_STEPS;
+    num_threads = resolve_num_threads(num_threads);
+
+    // Band weights are the exact Binomial(512, 1/2) masses; cdf restarts at every band.
+    double mass[RULE_BITS + 1], cdf[RULE_BITS + 1];
+    density_mass(mass);
+    double total_mass = 0.0;
+    for (int d = 0; d <= RULE_BITS; ++d) total_mass += mass[d];
+    for (int h = 0; h < num_strata; ++h) {
+        int lo, hi;
+        stratum_density_range(num_strata, h, &lo, &hi);
+        double sum = 0.0;
+        for (int d = lo; d <= hi; ++d) {
+            sum += mass[d];
+            cdf[d] = sum;
+        }
+        stratum_weights[h] = sum / total_mass;
+    }
+
+    uint16_t* packed = malloc(2 * (size_t)num_pairs * sizeof(uint16_t));
+    Rule512* rules = malloc(CHUNK_RULES * sizeof(Rule512));
+    int* strata = malloc(CHUNK_RULES * sizeof(int));
+    StratifiedContext ctx = {0};
+    ctx.counts = calloc((size_t)num_threads * num_pairs * num_strata, sizeof(uint64_t));
+    ctx.min_depths = malloc((size_t)num_threads * num_pairs * sizeof(int));
+    ctx.scratch = calloc(num_threads, sizeof(SimScratch*));
+    if (!packed || !rules || !strata || !ctx.counts || !ctx.min_depths || !ctx.scratch) {
+        fprintf(stderr, "Memory allocation failed for stratified sampling.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (size_t k = 0; k < (size_t)num_threads * num_pairs; ++k) ctx.min_depths[k] = -1;
+    for (int t = 0; t < num_threads; ++t) ctx.scratch[t] = sim_scratch_create();
+
+    Matrix m;
+    for (int i = 0; i < num_pairs; ++i) {
+        flat_to_matrix(m, &xs_flat[i * 16]);
+        packed[i] = (uint16_t)matrix_hash(m);
+        flat_to_matrix(m, &ys_flat[i * 16]);
+        packed[num_pairs + i] = (uint16_t)matrix_hash(m);
+    }
+
+    ctx.xs = packed;
+    ctx.ys = packed + num_pairs;
+    ctx.num_pairs = num_pairs;
+    ctx.num_strata = num_strata;
+    ctx.boundary_mode = boundary_mode;
+    ctx.max_steps = max_steps;
+    ctx.rules = rules;
+    ctx.strata = strata;
+
+    // Rules are drawn band by band from the shared PRNG, then simulated in parallel chunks.
+    prng_seed(seed);
+    uint64_t total = 0;
+    int filled = 0;
+    for (int h = 0; h < num_strata && !is_interrupted(); ++h) {
+        int lo, hi;
+        stratum_density_range(num_strata, h, &lo, &hi);
+        for (int n = 0; n < samples_per_stratum[h]; ++n) {
+            random_rule_with_density(&rules[filled], sample_density(cdf, lo, hi));
+            strata[filled++] = h;
+
+            if (filled == CHUNK_RULES) {
+                parallel_for(num_threads, filled, simulate_range, &ctx);
+                total += filled;
+                filled = 0;
+            }
+        }
+    }
+    if (filled > 0) {
+        parallel_for(num_threads, filled, simulate_range, &ctx);
+        total += filled;
+    }
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+
+    for (int i = 0; i < num_pairs; ++i) {
+        uint64_t* counts = &stratum_counts[(size_t)i * num_strata];
+        min_depths[i] = -1;
+        for (int h = 0; h < num_strata; ++h) counts[h] = 0;
+
+        for (int t = 0; t < num_threads; ++t) {
+            const uint64_t* local = &ctx.counts[((size_t)t * num_pairs + i) * num_strata];
+            for (int h = 0; h < num_strata; ++h) counts[h] += local[h];
+
+            int depth = ctx.min_depths[(size_t)t * num_pairs + i];
+            if (depth >= 0 && (min_depths[i] < 0 || depth < min_depths[i])) min_depths[i] = depth;
+        }
+
+        stratified_estimate(num_strata, stratum_weights, samples_per_stratum, counts, &m_estimates[i], &variances[i]);
+    }
+
+    for (int t = 0; t < num_threads; ++t) sim_scratch_free(ctx.scratch[t]);
+    free(ctx.scratch);
+    free(ctx.min_depths);
+    free(ctx.counts);
+    free(strata);
+    free(rules);
+    free(packed);
+    return total;
+}
@@ -0,0 +1,670 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "bdm_scoring.h"
+#include "ca_session.h"
+#include "task_runner.h"
+
+#define NUM_STATES 65536
+
+static const char* stage_names[RUNNER_NUM_STAGES] = {"parse", "abduction", "ranking", "induction", "selection"};
+
+static double now_seconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// -------------------- Task parsing --------------------
+
+typedef struct {
+    const char* p;
+    const char* end;
+} JsonCursor;
+
+static void skip_ws(JsonCursor* c) {
+    while (c->p < c->end && (*c->p == ' ' || *c->p == '\n' || *c->p == '\r' || *c->p == '\t')) c->p++;
+}
+
+static int peek(JsonCursor* c) {
+    skip_ws(c);
+    return c->p < c->end ? *c->p : -1;
+}
+
+static int expect(JsonCursor* c, char ch) {
+    if (peek(c) != ch) return -1;
+    c->p++;
+    return 0;
+}
+
+// Reads a string into out (truncated to cap - 1); escapes are kept as the escaped character.
+static int parse_string(JsonCursor* c, char* out, size_t cap) {
+    if (expect(c, '"') != 0) return -1;
+    size_t n = 0;
+    while (c->p < c->end && *c->p != '"') {
+        if (*c->p == '\\' && c->p + 1 < c->end) c->p++;
+        if (out && n + 1 < cap) out[n++] = *c->p;
+        c->p++;
+    }
+    if (out && cap > 0) out[n] = '\0';
+    return expect(c, '"');
+}
+
+static int skip_value(JsonCursor* c) {
+    int ch = peek(c);
+    if (ch == '"') return parse_string(c, NULL, 0);
+
+    if (ch == '[' || ch == '{') {
+        char close = (ch == '[') ? ']' : '}';
+        c->p++;
+        if (peek(c) == close) {
+            c->p++;
+            return 0;
+        }
+        for (;;) {
+            if (ch == '{' && (parse_string(c, NULL, 0) != 0 || expect(c, ':') != 0)) return -1;
+            if (skip_value(c) != 0) return -1;
+            if (peek(c) == ',') {
+                c->p++;
+                continue;
+            }
+            return expect(c, close);
+        }
+    }
+
+    // Numbers and literals.
+    const char* start = c->p;
+    while (c->p < c->end && !strchr(",]} \n\r\t", *c->p)) c->p++;
+    return c->p > start ? 0 : -1;
+}
+
+static int parse_grid(JsonCursor* c, uint16_t* key) {
+    Matrix m;
+    if (expect(c, '[') != 0) return -1;
+    for (int r = 0; r < MATRIX_SIZE; ++r) {
+        if (r > 0 && expect(c, ',') != 0) return -1;
+        if (expect(c, '[') != 0) return -1;
+        for (int col = 0; col < MATRIX_SIZE; ++col) {
+            if (col > 0 && expect(c, ',') != 0) return -1;
+            skip_ws(c);
+            char* next;
+            long v = strtol(c->p, &next, 10);
+            if (next == c->p || next > c->end || (v != 0 && v != 1)) return -1;
+            c->p = next;
+            m[r][col] = (uint8_t)v;
+        }
+        if (expect(c, ']') != 0) return -1;
+    }
+    if (expect(c, ']') != 0) return -1;
+    *key = (uint16_t)matrix_hash(m);
+    return 0;
+}
+
+static int push_key(uint16_t** keys, int count, uint16_t key) {
+    uint16_t* grown = realloc(*keys, (count + 1) * sizeof(uint16_t));
+    if (!grown) {
+        fprintf(stderr, "Memory allocation failed for task grids.\n");
+        exit(EXIT_FAILURE);
+    }
+    grown[count] = key;
+    *keys = grown;
+    return count + 1;
+}
+
+// [{"input": grid, "output": grid}, ...]; *all_outputs is cleared if any pair lacks an output.
+static int parse_pairs(JsonCursor* c, uint16_t** inputs, uint16_t** outputs, int* count, int* all_outputs) {
+    *all_outputs = 1;
+    if (expect(c, '[') != 0) return -1;
+    if (peek(c) == ']') {
+        c->p++;
+        return 0;
+    }
+
+    for (;;) {
+        int has_input = 0, has_output = 0;
+        uint16_t input = 0, output = 0;
+
+        if (expect(c, '{') != 0) return -1;
+        if (peek(c) != '}') {
+            for (;;) {
+                char key[32];
+                if (parse_string(c, key, sizeof(key)) != 0 || expect(c, ':') != 0) return -1;
+                if (strcmp(key, "input") == 0) {
+                    if (parse_grid(c, &input) != 0) return -1;
+                    has_input = 1;
+                } else if (strcmp(key, "output") == 0) {
+                    if (parse_grid(c, &output) != 0) return -1;
+                    has_output = 1;
+                } else if (skip_value(c) != 0) {
+                    return -1;
+                }
+                if (peek(c) != ',') break;
+                c->p++;
+            }
+        }
+        if (expect(c, '}') != 0 || !has_input) return -1;
+
+        push_key(inputs, *count, input);
+        push_key(outputs, *count, output);
+        (*count)++;
+        if (!has_output) *all_outputs = 0;
+
+        if (peek(c) != ',') break;
+        c->p++;
+    }
+    return expect(c, ']');
+}
+
+int runner_load_task(const char* path, RunnerTask* task) {
+    memset(task, 0, sizeof(RunnerTask));
+
+    FILE* f = fopen(path, "rb");
+    if (!f) return -1;
+    // fstat rather than fseek/ftell: a directory named *.json would report LONG_MAX.
+    struct stat st;
+    if (fstat(fileno(f), &st) != 0 || !S_ISREG(st.st_mode)) {
+        fclose(f);
+        return -1;
+    }
+    size_t size = (size_t)st.st_size;
+
+    // NUL-terminated so strtol in parse_grid stops at the end of the text.
+    char* text = malloc(size + 1);
+    if (!text) {
+        fprintf(stderr, "Memory allocation failed for task file.\n");
+        exit(EXIT_FAILURE);
+    }
+    size_t got = fread(text, 1, size, f);
+    fclose(f);
+    if (got != size) {
+        free(text);
+        return -1;
+    }
+    text[got] = '\0';
+
+    const char* base = strrchr(path, '/');
+    task->name = strdup(base ? base + 1 : path);
+
+    JsonCursor c = {text, text + got};
+    int status = expect(&c, '{');
+    int train_outputs = 0;
+    if (status == 0 && peek(&c) != '}') {
+        for (;;) {
+            char key[32];
+            if (parse_string(&c, key, sizeof(key)) != 0 || expect(&c, ':') != 0) {
+                status = -1;
+                break;
+            }
+            if (strcmp(key, "train") == 0) {
+                status = parse_pairs(&c, &task->train_inputs, &task->train_outputs, &task->num_train, &train_outputs);
+                if (status == 0 && !train_outputs) status = -1;
+            } else if (strcmp(key, "test") == 0) {
+                status = parse_pairs(&c, &task->test_inputs, &task->test_outputs, &task->num_test, &task->has_test_outputs);
+            } else {
+                status = skip_value(&c);
+            }
+            if (status != 0 || peek(&c) != ',') break;
+            c.p++;
+        }
+    }
+    if (status == 0) status = expect(&c, '}');
+
+    free(text);
+    if (status != 0) runner_free_task(task);
+    return status;
+}
+
+void runner_free_task(RunnerTask* task) {
+    free(task->name);
+    free(task->train_inputs);
+    free(task->train_outputs);
+    free(task->test_inputs);
+    free(task->test_outputs);
+    memset(task, 0, sizeof(RunnerTask));
+}
+
+// -------------------- Pipeline --------------------
+
+typedef struct {
+    SimScratch* scratch;
+    uint16_t* trail;       // max_steps states
+    int* rules;            // bank indices (abducted, then ranked)
+    double* scores;        // BDM scores of abducted rules
+    int* order;            // bdm_top_k output
+    int* counts;           // [state] rules reaching the state
+    int* t_min;            // [state] smallest depth
+    uint16_t* seen;        // states in discovery order
+} RunnerWorkspace;
+
+typedef struct {
+    const CASession* bank;
+    const RunnerTask* tasks;
+    const RunnerOptions* options;
+    const double* bdm_table;
+    TaskResult* results;
+    RunnerWorkspace* workspaces;  // one per thread
+    int within_task;              // tasks run one at a time, abduction on the bank's workers
+} RunnerContext;
+
+typedef struct {
+    const CASession* bank;
+    const RunnerTask* task;
+    int* rules;      // output; each worker compacts its hits to the start of its own chunk
+    int64_t* begins; // [worker] first bank index of its chunk
+    int* counts;     // [worker] hits in its chunk
+} AbductContext;
+
+// Bank rules in [begin, end) that map every train input to its output, written to out.
+static int abduct_chunk(const CASession* bank, const RunnerTask* task, int64_t begin, int64_t end,
+                        SimScratch* scratch, int* out) {
+    int n = 0;
+    for (int64_t r = begin; r < end; ++r) {
+        if ((r & 0xFFF) == 0 && is_interrupted()) break;
+
+        int i = 0;
+        while (i < task->num_train &&
+               simulate_packed_with_depth(task->train_inputs[i], task->train_outputs[i], &bank->rules[r],
+                                          bank->boundary_mode, bank->max_steps, scratch) >= 0) {
+            i++;
+        }
+        if (i == task->num_train) out[n++] = (int)r;
+    }
+    return n;
+}
+
+static void abduct_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    AbductContext* ctx = arg;
+    ctx->begins[thread_id] = begin;
+    ctx->counts[thread_id] = abduct_chunk(ctx->bank, ctx->task, begin, end, ctx->bank->scratch[thread_id], ctx->rules + begin);
+}
+
+static int abduct(const CASession* bank, const RunnerTask* task, int within_task, RunnerWorkspace* ws) {
+    if (task->num_train == 0) return 0;
+    if (!within_task) return abduct_chunk(bank, task, 0, bank->num_rules, ws->scratch, ws->rules);
+
+    // Split the bank over the session's workers; chunks are ordered, so
+    // concatenating them keeps bank order.
+    int workers = worker_pool_size(bank->pool);
+    int64_t* begins = calloc(workers, sizeof(int64_t));
+    int* counts = calloc(workers, sizeof(int));
+    if (!begins || !counts) {
+        fprintf(stderr, "Memory allocation failed for runner workspaces.\n");
+        exit(EXIT_FAILURE);
+    }
+    AbductContext ctx = {bank, task, ws->rules, begins, counts};
+    worker_pool_run(bank->pool, bank->num_rules, abduct_range, &ctx);
+
+    int n = 0;
+    for (int t = 0; t < workers; ++t) {
+        memmove(ws->rules + n, ws->rules + begins[t], counts[t] * sizeof(int));
+        n += counts[t];
+    }
+    free(counts);
+    free(begins);
+    return n;
+}
+
+static int rank(const CASession* bank, const double* bdm_table, int top_k, int n, RunnerWorkspace* ws) {
+    for (int j = 0; j < n; ++j) {
+        ws->scores[j] = bdm_score_rule(&bank->rule_numbers[(size_t)ws->rules[j] * 8], bdm_table);
+    }
+    int kept = bdm_top_k(ws->scores, n, top_k, ws->order);
+
+    // Replace positions by bank indices, best first, then make that the rule list.
+    for (int j = 0; j < kept; ++j) ws->order[j] = ws->rules[ws->order[j]];
+    memcpy(ws->rules, ws->order, kept * sizeof(int));
+    return kept;
+}
+
+static int induce(const CASession* bank, uint16_t x, int n, RunnerWorkspace* ws) {
+    int num_seen = 0;
+    for (int j = 0; j < n; ++j) {
+        int steps = simulate_packed_trajectory(x, &bank->rules[ws->rules[j]], bank->boundary_mode,
+                                               bank->max_steps, ws->scratch, ws->trail);
+        for (int t = 0; t < steps; ++t) {
+            uint16_t s = ws->trail[t];
+            if (ws->counts[s] == 0) {
+                ws->seen[num_seen++] = s;
+                ws->t_min[s] = t;
+            } else if (t < ws->t_min[s]) {
+                ws->t_min[s] = t;
+            }
+            ws->counts[s]++;
+        }
+    }
+    return num_seen;
+}
+
+// Lowest finite k_ctm over candidates with t_min > 0; clears the per-state tallies.
+static int select_hypothesis(int num_rules, int num_seen, RunnerWorkspace* ws, uint16_t* best, double* best_k) {
+    int found = 0;
+    for (int j = 0; j < num_seen; ++j) {
+        uint16_t s = ws->seen[j];
+        if (ws->t_min[s] > 0) {
+            double k = -log2((double)ws->counts[s] / num_rules) + log2((double)ws->t_min[s]);
+            if (isfinite(k) && (!found || k < *best_k)) {
+                *best = s;
+                *best_k = k;
+                found = 1;
+            }
+        }
+        ws->counts[s] = 0;
+    }
+    return found;
+}
+
+static void run_task(RunnerContext* ctx, int t, RunnerWorkspace* ws) {
+    const CASession* bank = ctx->bank;
+    const RunnerTask* task = &ctx->tasks[t];
+    const RunnerOptions* options = ctx->options;
+    TaskResult* result = &ctx->results[t];
+
+    int ns = task->num_test;
+    result->num_candidates = calloc(ns > 0 ? ns : 1, sizeof(int));
+    result->has_prediction = calloc(ns > 0 ? ns : 1, sizeof(int));
+    result->predictions = calloc(ns > 0 ? ns : 1, sizeof(uint16_t));
+    result->k_ctm = calloc(ns > 0 ? ns : 1, sizeof(double));
+    result->correct = calloc(ns > 0 ? ns : 1, sizeof(int));
+    if (!result->num_candidates || !result->has_prediction || !result->predictions || !result->k_ctm || !result->correct) {
+        fprintf(stderr, "Memory allocation failed for task results.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    double start = now_seconds();
+    int n = abduct(bank, task, ctx->within_task, ws);
+    result->num_abducted = n;
+    double mark = now_seconds();
+    result->seconds[RUNNER_STAGE_ABDUCTION] = mark - start;
+
+    if (options->top_k > 0 && ctx->bdm_table) n = rank(bank, ctx->bdm_table, options->top_k, n, ws);
+    result->num_ranked = n;
+    start = now_seconds();
+    result->seconds[RUNNER_STAGE_RANKING] = start - mark;
+
+    for (int i = 0; i < ns; ++i) {
+        mark = now_seconds();
+        int num_seen = induce(bank, task->test_inputs[i], n, ws);
+        double induced = now_seconds();
+
+        result->num_candidates[i] = num_seen;
+        result->has_prediction[i] = select_hypothesis(bank->num_rules, num_seen, ws, &result->predictions[i], &result->k_ctm[i]);
+        if (!result->has_prediction[i]) result->k_ctm[i] = INFINITY;
+        result->correct[i] = !task->has_test_outputs ? -1
+                           : (result->has_prediction[i] && result->predictions[i] == task->test_outputs[i]);
+
+        result->seconds[RUNNER_STAGE_INDUCTION] += induced - mark;
+        result->seconds[RUNNER_STAGE_SELECTION] += now_seconds() - induced;
+    }
+}
+
+static void run_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    RunnerContext* ctx = arg;
+    for (int64_t t = begin; t < end; ++t) {
+        if (is_interrupted()) break;
+        run_task(ctx, (int)t, &ctx->workspaces[thread_id]);
+    }
+}
+
+void runner_run_tasks(
+    const CASession* bank,
+    const RunnerTask* tasks,
+    int num_tasks,
+    const RunnerOptions* options,
+    const double* bdm_table,
+    TaskResult* results
+) {
+    init_interrupt_flag();
+    memset(results, 0, (size_t)num_tasks * sizeof(TaskResult));
+
+    // With fewer tasks than threads, parallelize within each task instead.
+    int num_threads = resolve_num_threads(options->num_threads);
+    int within_task = num_tasks < num_threads && worker_pool_size(bank->pool) > 1;
+    if (within_task) num_threads = 1;
+    else if (num_threads > num_tasks) num_threads = num_tasks > 0 ? num_tasks : 1;
+
+    RunnerWorkspace* workspaces = calloc(num_threads, sizeof(RunnerWorkspace));
+    if (!workspaces) {
+        fprintf(stderr, "Memory allocation failed for runner workspaces.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < num_threads; ++t) {
+        RunnerWorkspace* ws = &workspaces[t];
+        size_t rules = bank->num_rules > 0 ? bank->num_rules : 1;
+        ws->scratch = sim_scratch_create();
+        ws->trail = malloc((size_t)bank->max_steps * sizeof(uint16_t));
+        ws->rules = malloc(rules * sizeof(int));
+        ws->scores = malloc(rules * sizeof(double));
+        ws->order = malloc(rules * sizeof(int));
+        ws->counts = calloc(NUM_STATES, sizeof(int));
+        ws->t_min = malloc(NUM_STATES * sizeof(int));
+        ws->seen = malloc(NUM_STATES * sizeof(uint16_t));
+        if (!ws->trail || !ws->rules || !ws->scores || !ws->order || !ws->counts || !ws->t_min || !ws->seen) {
+            fprintf(stderr, "Memory allocation failed for runner workspaces.\n");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    RunnerContext ctx = {bank, tasks, options, bdm_table, results, workspaces, within_task};
+    parallel_for(num_threads, num_tasks, run_range, &ctx);
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+    }
+
+    for (int t = 0; t < num_threads; ++t) {
+        RunnerWorkspace* ws = &workspaces[t];
+        sim_scratch_free(ws->scratch);
+        free(ws->trail);
+        free(ws->rules);
+        free(ws->scores);
+        free(ws->order);
+        free(ws->counts);
+        free(ws->t_min);
+        free(ws->seen);
+    }
+    free(workspaces);
+}
+
+void runner_free_result(TaskResult* result) {
+    free(result->num_candidates);
+    free(result->has_prediction);
+    free(result->predictions);
+    free(result->k_ctm);
+    free(result->correct);
+    memset(result, 0, sizeof(TaskResult));
+}
+
+// -------------------- Directory runner --------------------
+
+static int compare_names(const void* a, const void* b) {
+    return strcmp(*(char* const*)a, *(char* const*)b);
+}
+
+static char** list_task_files(const char* task_dir, int* count) {
+    DIR* dir = opendir(task_dir);
+    if (!dir) return NULL;
+
+    char** names = NULL;
+    int n = 0;
+    struct dirent* entry;
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+        if (len < 5 || strcmp(entry->d_name + len - 5, ".json") != 0) continue;
+
+        char** grown = realloc(names, (n + 1) * sizeof(char*));
+        if (!grown) {
+            fprintf(stderr, "Memory allocation failed for task list.\n");
+            exit(EXIT_FAILURE);
+        }
+        names = grown;
+        names[n++] = strdup(entry->d_name);
+    }
+    closedir(dir);
+
+    if (n > 1) qsort(names, n, sizeof(char*), compare_names);
+    *count = n;
+    return names;
+}
+
+static void write_grid(FILE* f, uint16_t key) {
+    Matrix m;
+    hash_to_matrix(m, key);
+    fprintf(f, "[");
+    for (int r = 0; r < MATRIX_SIZE; ++r) {
+        fprintf(f, "%s[", r ? ", " : "");
+        for (int c = 0; c < MATRIX_SIZE; ++c) fprintf(f, "%s%d", c ? ", " : "", m[r][c]);
+        fprintf(f, "]");
+    }
+    fprintf(f, "]");
+}
+
+// JSON string literal; file names may contain quotes, backslashes or control characters.
+static void write_string(FILE* f, const char* str) {
+    fputc('"', f);
+    for (const unsigned char* p = (const unsigned char*)str; *p; ++p) {
+        if (*p == '"' || *p == '\\') fprintf(f, "\\%c", *p);
+        else if (*p < 0x20) fprintf(f, "\\u%04x", *p);
+        else fputc(*p, f);
+    }
+    fputc('"', f);
+}
+
+static void write_seconds(FILE* f, const double* seconds) {
+    fprintf(f, "{");
+    for (int s = 0; s < RUNNER_NUM_STAGES; ++s) {
+        fprintf(f, "%s\"%s\": %.6f", s ? ", " : "", stage_names[s], seconds[s]);
+    }
+    fprintf(f, "}");
+}
+
+static int write_results(const char* output_path, const RunnerOptions* options, double bank_seconds,
+                         const RunnerTask* tasks, const TaskResult* results, int num_tasks) {
+    FILE* f = fopen(output_path, "w");
+    if (!f) return -1;
+
+    double totals[RUNNER_NUM_STAGES] = {0};
+    int evaluated = 0, correct = 0;
+    for (int t = 0; t < num_tasks; ++t) {
+        for (int s = 0; s < RUNNER_NUM_STAGES; ++s) totals[s] += results[t].seconds[s];
+        for (int i = 0; i < tasks[t].num_test; ++i) {
+            if (results[t].correct[i] < 0) continue;
+            evaluated++;
+            correct += results[t].correct[i];
+        }
+    }
+
+    fprintf(f, "{\n");
+    fprintf(f, "  \"num_rules\": %d,\n  \"seed\": %u,\n  \"boundary_mode\": %d,\n  \"max_steps\": %d,\n  \"top_k\": %d,\n",
+            options->num_rules, options->seed, options->boundary_mode, options->max_steps, options->top_k > 0 ? options->top_k : 0);
+    fprintf(f, "  \"num_tasks\": %d,\n  \"evaluated\": %d,\n  \"correct\": %d,\n", num_tasks, evaluated, correct);
+    fprintf(f, "  \"bank_seconds\": %.6f,\n  \"seconds\": ", bank_seconds);
+    write_seconds(f, totals);
+    fprintf(f, ",\n  \"tasks\": [");
+
+    for (int t = 0; t < num_tasks; ++t) {
+        const TaskResult* r = &results[t];
+        fprintf(f, "%s\n    {\"task\": ", t ? "," : "");
+        write_string(f, tasks[t].name);
+        fprintf(f, ", \"num_abducted\": %d, \"num_ranked\": %d, \"seconds\": ", r->num_abducted, r->num_ranked);
+        write_seconds(f, r->seconds);
+        fprintf(f, ",\n     \"predictions\": [");
+        for (int i = 0; i < tasks[t].num_test; ++i) {
+            fprintf(f, "%s{\"output\": ", i ? ", " : "");
+            if (r->has_prediction[i]) {
+                write_grid(f, r->predictions[i]);
+                fprintf(f, ", \"k_ctm\": %.17g", r->k_ctm[i]);
+            } else {
+                fprintf(f, "null, \"k_ctm\": null");
+            }
+            fprintf(f, ", \"num_candidates\": %d, \"correct\": %s}", r->num_candidates[i],
+                    r->correct[i] < 0 ? "null" : (r->correct[i] ? "true" : "false"));
+        }
+        fprintf(f, "]}");
+    }
+    fprintf(f, "%s]\n}\n", num_tasks ? "\n  " : "");
+
+    return fclose(f) == 0 ? 0 : -1;
+}
+
+int runner_run_directory(const char* task_dir, const RunnerOptions* options, const char* output_path) {
+    double* bdm_table = NULL;
+    if (options->top_k > 0) {
+        bdm_table = malloc(BDM_TABLE_SIZE * sizeof(double));
+        if (!bdm_table) {
+            fprintf(stderr, "Memory allocation failed for BDM table.\n");
+            exit(EXIT_FAILURE);
+        }
+        if (!options->bdm_table_path || bdm_load_ctm_table(options->bdm_table_path, bdm_table) != 0) {
+            fprintf(stderr, "Cannot load BDM table %s.\n", options->bdm_table_path ? options->bdm_table_path : "(none)");
+            free(bdm_table);
+            return -1;
+        }
+    }
+
+    int num_tasks = 0;
+    char** names = list_task_files(task_dir, &num_tasks);
+    if (!names) {
+        fprintf(stderr, "Cannot read task directory %s.\n", task_dir);
+        free(bdm_table);
+        return -1;
+    }
+
+    RunnerTask* tasks = calloc(num_tasks > 0 ? num_tasks : 1, sizeof(RunnerTask));
+    TaskResult* results = calloc(num_tasks > 0 ? num_tasks : 1, sizeof(TaskResult));
+    double* parse_seconds = calloc(num_tasks > 0 ? num_tasks : 1, sizeof(double));
+    if (!tasks || !results || !parse_seconds) {
+        fprintf(stderr, "Memory allocation failed for tasks.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    int status = 0;
+    for (int t = 0; t < num_tasks && status == 0; ++t) {
+        char path[4096];
+        snprintf(path, sizeof(path), "%s/%s", task_dir, names[t]);
+
+        double start = now_seconds();
+        if (runner_load_task(path, &tasks[t]) != 0) {
+            fprintf(stderr, "Cannot parse task %s.\n", path);
+            status = -1;
+        }
+        parse_seconds[t] = now_seconds() - start;
+    }
+
+    if (status == 0) {
+        double start = now_seconds();
+        CASession* bank = ca_session_create(options->seed, options->num_rules, options->boundary_mode, options->max_steps, options->num_threads);
+        double bank_seconds = now_seconds() - start;
+
+        runner_run_tasks(bank, tasks, num_tasks, options, bdm_table, results);
+        for (int t = 0; t < num_tasks; ++t) results[t].seconds[RUNNER_STAGE_PARSE] = parse_seconds[t];
+
+        if (write_results(output_path, options, bank_seconds, tasks, results, num_tasks) != 0) {
+            fprintf(stderr, "Cannot write results to %s.\n", output_path);
+            status = -1;
+        }
+
+        for (int t = 0; t < num_tasks; ++t) runner_free_result(&results[t]);
+        ca_session_destroy(bank);
+    }
+
+    for (int t = 0; t < num_tasks; ++t) {
+        runner_free_task(&tasks[t]);
+        free(names[t]);
+    }
+    free(names);
+    free(parse_seconds);
+    free(results);
+    free(tasks);
+    free(bdm_table);
+    return status == 0 ? num_tasks : -1;
+}
@@ -0,0 +1,258 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "interrupt_flag.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "parallel.h"
+#include "ca_session.h"
+#include "trajectory_cycles.h"
+
+#define NUM_STATES (1 << 16)  // every orbit repeats within this many steps
+
+typedef struct {
+    uint16_t* data;
+    size_t count;
+    size_t capacity;
+} StateBuffer;
+
+static void* checked_malloc(size_t size) {
+    void* p = malloc(size > 0 ? size : 1);
+    if (!p) {
+        fprintf(stderr, "Memory allocation failed for trajectories.\n");
+        exit(EXIT_FAILURE);
+    }
+    return p;
+}
+
+static void buffer_append(StateBuffer* buffer, const uint16_t* states, size_t n) {
+    if (buffer->count + n > buffer->capacity) {
+        size_t capacity = buffer->capacity ? buffer->capacity : 4096;
+        while (capacity < buffer->count + n) capacity *= 2;
+        buffer->data = realloc(buffer->data, capacity * sizeof(uint16_t));
+        if (!buffer->data) {
+            fprintf(stderr, "Memory allocation failed for trajectories.\n");
+            exit(EXIT_FAILURE);
+        }
+        buffer->capacity = capacity;
+    }
+    memcpy(buffer->data + buffer->count, states, n * sizeof(uint16_t));
+    buffer->count += n;
+}
+
+static uint16_t flat_key(const uint32_t* flat) {
+    Matrix m;
+    flat_to_matrix(m, flat);
+    return (uint16_t)matrix_hash(m);
+}
+
+// -------------------- Building --------------------
+
+typedef struct {
+    CASession* session;
+    uint16_t x;
+    const int* rule_indices;  // bank indices, or NULL
+    const Rule512* rules;     // explicit rules when rule_indices is NULL
+    Trajectories* out;
+    uint16_t** orbits;        // one NUM_STATES buffer per worker
+    StateBuffer* buffers;     // one per worker; chunks are contiguous, so rule order is kept
+} BuildContext;
+
+static void build_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    BuildContext* ctx = arg;
+    CASession* session = ctx->session;
+    SimScratch* scratch = session->scratch[thread_id];
+    uint16_t* orbit = ctx->orbits[thread_id];
+
+    for (int64_t r = begin; r < end; ++r) {
+        if (is_interrupted()) break;
+
+        const Rule512* rule = ctx->rule_indices ? &session->rules[ctx->rule_indices[r]] : &ctx->rules[r];
+        int n = simulate_packed_trajectory(ctx->x, rule, session->boundary_mode, NUM_STATES, scratch, orbit);
+
+        // The successor of the last distinct state is where the cycle starts.
+        uint16_t entry = apply_rule_packed(orbit[n - 1], rule, session->boundary_mode);
+        int transient = 0;
+        while (orbit[transient] != entry) transient++;
+
+        ctx->out->transients[r] = transient;
+        ctx->out->periods[r] = n - transient;
+        buffer_append(&ctx->buffers[thread_id], orbit, (size_t)n);
+    }
+}
+
+static Trajectories* build(CASession* session, const uint32_t* x_flat, const int* rule_indices, const Rule512* rules, int count) {
+    reset_interrupt_flag();
+
+    Trajectories* out = calloc(1, sizeof(Trajectories));
+    if (!out) {
+        fprintf(stderr, "Memory allocation failed for trajectories.\n");
+        exit(EXIT_FAILURE);
+    }
+    out->num_rules = count;
+    out->pool = session->pool;
+    out->offsets = checked_malloc((size_t)(count + 1) * sizeof(uint64_t));
+    out->transients = checked_malloc((size_t)count * sizeof(int32_t));
+    out->periods = checked_malloc((size_t)count * sizeof(int32_t));
+
+    int workers = worker_pool_size(session->pool);
+    BuildContext ctx = {session, flat_key(x_flat), rule_indices, rules, out, NULL, NULL};
+    ctx.orbits = checked_malloc(workers * sizeof(uint16_t*));
+    ctx.buffers = calloc(workers, sizeof(StateBuffer));
+    if (!ctx.buffers) {
+        fprintf(stderr, "Memory allocation failed for trajectories.\n");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < workers; ++t) ctx.orbits[t] = checked_malloc(NUM_STATES * sizeof(uint16_t));
+
+    worker_pool_run(session->pool, count, build_range, &ctx);
+
+    size_t total = 0;
+    for (int t = 0; t < workers; ++t) total += ctx.buffers[t].count;
+    out->states = checked_malloc(total * sizeof(uint16_t));
+
+    size_t filled = 0;
+    for (int t = 0; t < workers; ++t) {
+        if (ctx.buffers[t].count) memcpy(out->states + filled, ctx.buffers[t].data, ctx.buffers[t].count * sizeof(uint16_t));
+        filled += ctx.buffers[t].count;
+        free(ctx.buffers[t].data);
+        free(ctx.orbits[t]);
+    }
+    free(ctx.buffers);
+    free(ctx.orbits);
+
+    if (is_interrupted()) {
+        fprintf(stderr, "Interrupted by user (SIGINT).\n");
+        trajectories_free(out);
+        return NULL;
+    }
+
+    out->offsets[0] = 0;
+    for (int r = 0; r < count; ++r) {
+        out->offsets[r + 1] = out->offsets[r] + (uint64_t)(out->transients[r] + out->periods[r]);
+    }
+    return out;
+}
+
+Trajectories* trajectories_build(CASession* session, const uint32_t* x_flat, const int* rule_indices, int num_indices) {
+    if (rule_indices) return build(session, x_flat, rule_indices, NULL, num_indices);
+
+    int* all = checked_malloc((size_t)session->num_rules * sizeof(int));
+    for (int r = 0; r < session->num_rules; ++r) all[r] = r;
+    Trajectories* out = build(session, x_flat, all, NULL, session->num_rules);
+    free(all);
+    return out;
+}
+
+Trajectories* trajectories_build_for_rules(CASession* session, const uint32_t* x_flat, const uint64_t* rules_flat, int num_rules) {
+    Rule512* rules = checked_malloc((size_t)num_rules * sizeof(Rule512));
+    for (int r = 0; r < num_rules; ++r) {
+        rule_from_number(&rules[r], &rules_flat[(size_t)r * 8]);
+    }
+    Trajectories* out = build(session, x_flat, NULL, rules, num_rules);
+    free(rules);
+    return out;
+}
+
+void trajectories_free(Trajectories* trajectories) {
+    if (!trajectories) return;
+    free(trajectories->offsets);
+    free(trajectories->transients);
+    free(trajectories->periods);
+    free(trajectories->states);
+    free(trajectories);
+}
+
+// -------------------- Queries --------------------
+
+typedef struct {
+    const Trajectories* trajectories;
+    const uint64_t* ts;
+    int num_ts;
+    uint16_t* states_out;
+} StateAtContext;
+
+static void state_at_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    (void)thread_id;
+    StateAtContext* ctx = arg;
+    const Trajectories* tr = ctx->trajectories;
+
+    for (int64_t r = begin; r < end; ++r) {
+        const uint16_t* states = tr->states + tr->offsets[r];
+        uint64_t transient = (uint64_t)tr->transients[r];
+        uint64_t period = (uint64_t)tr->periods[r];
+
+        for (int k = 0; k < ctx->num_ts; ++k) {
+            uint64_t t = ctx->ts[k];
+            uint64_t pos = t < transient ? t : transient + (t - transient) % period;
+            ctx->states_out[(size_t)r * ctx->num_ts + k] = states[pos];
+        }
+    }
+}
+
+void trajectories_state_at(const Trajectories* trajectories, const uint64_t* ts, int num_ts, uint16_t* states_out) {
+    StateAtContext ctx = {trajectories, ts, num_ts, states_out};
+    worker_pool_run(trajectories->pool, trajectories->num_rules, state_at_range, &ctx);
+}
+
+typedef struct {
+    const Trajectories* trajectories;
+    const int32_t* slot;   // [state] -> first target index equal to it, or -1
+    const int* first;      // [j] -> first target index equal to ys[j]
+    int num_ys;
+    int32_t* depths_out;
+    uint8_t* on_cycle_out;
+} FindContext;
+
+static void find_range(void* arg, int thread_id, int64_t begin, int64_t end) {
+    (void)thread_id;
+    FindContext* ctx = arg;
+    const Trajectories* tr = ctx->trajectories;
+    int num_ys = ctx->num_ys;
+
+    int32_t* depths = malloc((num_ys > 0 ? num_ys : 1) * sizeof(int32_t));
+    if (!depths) {
+        fprintf(stderr, "Memory allocation failed for trajectory queries.\n");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int64_t r = begin; r < end; ++r) {
+        for (int j = 0; j < num_ys; ++j) depths[j] = -1;
+
+        // Orbit states are distinct, so each target is hit at most once.
+        const uint16_t* states = tr->states + tr->offsets[r];
+        int n = (int)(tr->offsets[r + 1] - tr->offsets[r]);
+        for (int p = 0; p < n; ++p) {
+            int32_t j = ctx->slot[states[p]];
+            if (j >= 0) depths[j] = p;
+        }
+
+        for (int j = 0; j < num_ys; ++j) {
+            int32_t depth = depths[ctx->first[j]];
+            size_t k = (size_t)r * num_ys + j;
+            if (ctx->depths_out) ctx->depths_out[k] = depth;
+            if (ctx->on_cycle_out) ctx->on_cycle_out[k] = depth >= tr->transients[r];
+        }
+    }
+    free(depths);
+}
+
+void trajectories_find(const Trajectories* trajectories, const uint32_t* ys_flat, int num_ys, int32_t* depths_out, uint8_t* on_cycle_out) {
+    int32_t* slot = checked_malloc(NUM_STATES * sizeof(int32_t));
+    int* first = checked_malloc((size_t)num_ys * sizeof(int));
+    for (int s = 0; s < NUM_STATES; ++s) slot[s] = -1;
+
+    for (int j = 0; j < num_ys; ++j) {
+        uint16_t y = flat_key(&ys_flat[(size_t)j * 16]);
+        if (slot[y] < 0) slot[y] = j;
+        first[j] = slot[y];
+    }
+
+    FindContext ctx = {trajectories, slot, first, num_ys, depths_out, on_cycle_out};
+    worker_pool_run(trajectories->pool, trajectories->num_rules, find_range, &ctx);
+
+    free(first);
+    free(slot);
+}
@@ -0,0 +1,211 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "matrix_utils.h"
+#include "ca_session.h"
+#include "abduction_state.h"
+
+#define NUM_PAIRS 4
+#define NUM_RULES 20000
+#define SEED 42
+
+static uint32_t xs_flat[NUM_PAIRS][16] = {
+    {0,0,0,0,
+     0,1,1,0,
+     0,1,1,0,
+     0,0,0,0},
+
+    {0,0,0,1,
+     0,1,0,0,
+     0,0,1,0,
+     1,0,0,0},
+
+    {1,0,0,0,
+     0,0,0,0,
+     0,0,0,0,
+     0,0,0,1},
+
+    {0,1,0,0,
+     0,1,0,0,
+     0,1,0,0,
+     0,0,0,0}
+};
+
+static uint32_t ys_flat[NUM_PAIRS][16] = {
+    {0,0,0,0,
+     0,0,0,0,
+     0,0,0,0,
+     0,0,0,0},
+
+    {0,0,0,0,
+     0,0,0,0,
+     0,0,0,0,
+     0,0,0,0},
+
+    {0,0,0,0,
+     0,0,0,0,
+     0,0,0,0,
+     0,0,0,0},
+
+    {0,1,0,0,   // y == x: every rule matches at depth 0
+     0,1,0,0,
+     0,1,0,0,
+     0,0,0,0}
+};
+
+// The state agrees with intersecting full ca_session_matches results over `order`.
+static void check_state(CASession* session, const AbductionState* state, const int* order, int n) {
+    assert(abduction_state_num_pairs(state) == n);
+
+    int* indices[NUM_PAIRS];
+    int* depths[NUM_PAIRS];
+    int counts[NUM_PAIRS];
+    uint32_t pair_xs[NUM_PAIRS][16] = {{0}}, pair_ys[NUM_PAIRS][16] = {{0}};
+    for (int j = 0; j < n; ++j) {
+        memcpy(pair_xs[j], xs_flat[order[j]], sizeof(pair_xs[j]));
+        memcpy(pair_ys[j], ys_flat[order[j]], sizeof(pair_ys[j]));
+    }
+    ca_session_matches(session, (uint32_t*)pair_xs, (uint32_t*)pair_ys, n, indices, depths, counts);
+
+    // Per-rule depth on each pair, -1 where it does not match.
+    int* table = malloc((size_t)NUM_RULES * (n > 0 ? n : 1) * sizeof(int));
+    for (size_t k = 0; k < (size_t)NUM_RULES * n; ++k) table[k] = -1;
+    for (int j = 0; j < n; ++j) {
+        for (int k = 0; k < counts[j]; ++k) table[(size_t)indices[j][k] * n + j] = depths[j][k];
+    }
+
+    int expected = 0;
+    for (int r = 0; r < NUM_RULES; ++r) {
+        int all = 1;
+        for (int j = 0; j < n; ++j) all &= table[(size_t)r * n + j] >= 0;
+        expected += all;
+    }
+
+    int survivors = abduction_state_num_survivors(state);
+    assert(survivors == expected);
+
+    uint32_t* got = malloc((survivors > 0 ? survivors : 1) * sizeof(uint32_t));
+    int32_t* got_depths = malloc((size_t)(survivors > 0 ? survivors : 1) * (n > 0 ? n : 1) * sizeof(int32_t));
+    abduction_state_survivors(state, got, got_depths);
+
+    for (int k = 0; k < survivors; ++k) {
+        assert(k == 0 || got[k - 1] < got[k]);
+        for (int j = 0; j < n; ++j) {
+            assert(table[(size_t)got[k] * n + j] >= 0);
+            assert(got_depths[(size_t)k * n + j] == table[(size_t)got[k] * n + j]);
+        }
+    }
+
+    uint32_t stored_xs[NUM_PAIRS][16], stored_ys[NUM_PAIRS][16];
+    abduction_state_pairs(state, (uint32_t*)stored_xs, (uint32_t*)stored_ys);
+    assert(memcmp(stored_xs, pair_xs, (size_t)n * sizeof(pair_xs[0])) == 0);
+    assert(memcmp(stored_ys, pair_ys, (size_t)n * sizeof(pair_ys[0])) == 0);
+
+    free(got_depths);
+    free(got);
+    free(table);
+    ca_session_free_matches(n, indices, depths);
+}
+
+int main() {
+    CASession* session = ca_session_create(SEED, NUM_RULES, 1, 256, 3);
+    AbductionState* state = abduction_state_create(session);
+
+    int order[NUM_PAIRS] = {0};
+    check_state(session, state, order, 0);
+
+    for (int i = 0; i < NUM_PAIRS; ++i) {
+        int survivors = abduction_state_add_pair(state, xs_flat[i], ys_flat[i]);
+        order[i] = i;
+        check_state(session, state, order, i + 1);
+        printf("Added pair %d: %d survivors.\n", i, survivors);
+    }
+
+    // Remove from the middle, then the front (the reloaded state below removes from the back).
+    int remaining[] = {0, 2, 3};
+    assert(abduction_state_remove_pair(state, 1) >= 0);
+    check_state(session, state, remaining, 3);
+
+    int front_removed[] = {2, 3};
+    assert(abduction_state_remove_pair(state, 0) >= 0);
+    check_state(session, state, front_removed, 2);
+
+    assert(abduction_state_remove_pair(state, 5) == -1);
+    abduction_state_add_pair(state, xs_flat[1], ys_flat[1]);
+    int readded[] = {2, 3, 1};
+    check_state(session, state, readded, 3);
+    printf("Removals and re-adds agree with full re-simulation (%d survivors).\n", abduction_state_num_survivors(state));
+
+    // Round trip through disk; a session with other parameters is refused.
+    char path[] = "/tmp/test_abduction_state_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+    assert(abduction_state_save(state, path) == 0);
+
+    unsigned int seed;
+    int num_rules, boundary_mode, max_steps, family;
+    assert(abduction_state_peek(path, &seed, &num_rules, &boundary_mode, &max_steps, &family) == 0);
+    assert(seed == SEED && num_rules == NUM_RULES && boundary_mode == 1 && max_steps == 256);
+    assert(family == RULE_FAMILY_FULL);
+
+    AbductionState* loaded = abduction_state_load(session, path);
+    assert(loaded);
+    check_state(session, loaded, readded, 3);
+    assert(abduction_state_remove_pair(loaded, 2) >= 0);
+    check_state(session, loaded, front_removed, 2);
+
+    CASession* other = ca_session_create(SEED + 1, NUM_RULES, 1, 256, 1);
+    assert(abduction_state_load(other, path) == NULL);
+    ca_session_destroy(other);
+    other = ca_session_create_in_family(SEED, NUM_RULES, RULE_FAMILY_SYMMETRIC, 1, 256, 1);
+    assert(abduction_state_load(other, path) == NULL);
+    ca_session_destroy(other);
+    printf("Saved state reloads and keeps refining.\n");
+
+    // Hand-written chains: later sets must be subsets of earlier ones.
+    char header[28];  // magic, seed, 5 parameters
+    FILE* f = fopen(path, "rb");
+    assert(f && fread(header, 1, sizeof(header), f) == sizeof(header));
+    fclose(f);
+
+    uint32_t nested[2][2] = {{1, 5}, {5, 0}};
+    uint32_t crossing[2][2] = {{1, 5}, {2, 5}};  // ascending and within range, but 2 was never a survivor
+    uint32_t (*chains[2])[2] = {nested, crossing};
+    uint32_t second_counts[2] = {1, 2};
+    for (int c = 0; c < 2; ++c) {
+        int32_t num_pairs = 2;
+        memcpy(header + 24, &num_pairs, sizeof(num_pairs));
+        f = fopen(path, "wb");
+        assert(f);
+        fwrite(header, 1, sizeof(header), f);
+        for (int j = 0; j < 2; ++j) {
+            uint16_t keys[2] = {0x0660, (uint16_t)j};
+            uint32_t count = j == 0 ? 2 : second_counts[c];
+            int32_t depths[2] = {1, 1};
+            fwrite(keys, sizeof(uint16_t), 2, f);
+            fwrite(&count, sizeof(count), 1, f);
+            fwrite(chains[c][j], sizeof(uint32_t), count, f);
+            fwrite(depths, sizeof(int32_t), count, f);
+        }
+        fclose(f);
+
+        AbductionState* crafted = abduction_state_load(session, path);
+        assert((crafted != NULL) == (c == 0));
+        if (crafted) {
+            assert(abduction_state_num_survivors(crafted) == 1);
+            abduction_state_destroy(crafted);
+        }
+    }
+    unlink(path);
+    printf("Saved chains that are not nested are rejected.\n");
+
+    abduction_state_destroy(loaded);
+    abduction_state_destroy(state);
+    ca_session_destroy(session);
+    return 0;
+}
@@ -0,0 +1,176 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "prng/prng.h"
+#include "matrix_utils.h"
+#include "ca_kstate.h"
+#include "simulate_kstate_rules.h"
+
+#define NUM_RULES 2000
+
+// Straightforward per-cell reference for the bit-plane kernel.
+static void reference_apply(Matrix out, const Matrix in, const KRule* rule, int boundary_mode) {
+    int k = rule->num_colors;
+    int outer = (rule->family == KSTATE_OUTER_TOTALISTIC);
+
+    for (int i = 0; i < MATRIX_SIZE; ++i) {
+        for (int j = 0; j < MATRIX_SIZE; ++j) {
+            int s = 0;
+            for (int dr = -1; dr <= 1; ++dr) {
+                for (int dc = -1; dc <= 1; ++dc) {
+                    if (outer && dr == 0 && dc == 0) continue;
+                    int r = i + dr, c = j + dc;
+                    if (boundary_mode == 1) {
+                        r = (r + MATRIX_SIZE) % MATRIX_SIZE;
+                        c = (c + MATRIX_SIZE) % MATRIX_SIZE;
+                    } else if (r < 0 || r >= MATRIX_SIZE || c < 0 || c >= MATRIX_SIZE) {
+                        continue;
+                    }
+                    s += in[r][c];
+                }
+            }
+            int idx = outer ? in[i][j] * (8 * (k - 1) + 1) + s : s;
+            out[i][j] = rule->table[idx];
+        }
+    }
+}
+
+// Linear-scan reference for the hashed visited set.
+static int reference_depth(KState x, KState y, const KRule* rule, int boundary_mode, int max_steps) {
+    KState* seen = malloc(max_steps * sizeof(KState));
+    int seen_count = 0, depth = -1;
+    KState current = x;
+    for (int t = 0; t < max_steps; ++t) {
+        if (current == y) { depth = t; break; }
+        int repeat = 0;
+        for (int i = 0; i < seen_count && !repeat; ++i) repeat = seen[i] == current;
+        if (repeat) break;
+        seen[seen_count++] = current;
+        current = kstate_apply_rule(current, rule, boundary_mode);
+    }
+    free(seen);
+    return depth;
+}
+
+int main() {
+    prng_seed(7);
+
+    for (int family = KSTATE_TOTALISTIC; family <= KSTATE_OUTER_TOTALISTIC; ++family) {
+        for (int k = 2; k <= KSTATE_MAX_COLORS; ++k) {
+            for (int boundary_mode = 0; boundary_mode <= 1; ++boundary_mode) {
+                for (int n = 0; n < 50; ++n) {
+                    KRule rule;
+                    kstate_random_rule(&rule, family, k);
+
+                    Matrix in, expected, actual;
+                    for (int i = 0; i < MATRIX_SIZE; ++i)
+                        for (int j = 0; j < MATRIX_SIZE; ++j)
+                            in[i][j] = prng_next() % k;
+
+                    KState s = kstate_from_matrix(in);
+                    kstate_to_matrix(actual, s);
+                    assert(matrix_equals(actual, in) && "Bit-plane round trip failed");
+
+                    reference_apply(expected, in, &rule, boundary_mode);
+                    kstate_to_matrix(actual, kstate_apply_rule(s, &rule, boundary_mode));
+                    assert(matrix_equals(actual, expected) && "Bit-plane kernel disagrees with reference");
+                }
+            }
+        }
+    }
+    printf("Bit-plane kernel matches the per-cell reference for k = 2..%d.\n", KSTATE_MAX_COLORS);
+
+    // Visited-set depths agree with a linear scan, for targets on and off the trajectory.
+    KStateScratch* scratch = kstate_scratch_create(256);
+    KState* trail = malloc(256 * sizeof(KState));
+    for (int n = 0; n < 300; ++n) {
+        int k = 2 + n % (KSTATE_MAX_COLORS - 1);
+        KRule rule;
+        kstate_random_rule(&rule, n % 2, k);
+
+        Matrix in;
+        for (int i = 0; i < MATRIX_SIZE; ++i)
+            for (int j = 0; j < MATRIX_SIZE; ++j)
+                in[i][j] = prng_next() % k;
+        KState x = kstate_from_matrix(in);
+
+        int len = kstate_simulate_trajectory(x, &rule, 1, 256, scratch, trail);
+        KState targets[3] = {trail[len - 1], trail[len / 2], ~(KState)0};
+        for (int j = 0; j < 3; ++j) {
+            int depth = kstate_simulate_with_depth(x, targets[j], &rule, 1, 256, scratch);
+            assert(depth == reference_depth(x, targets[j], &rule, 1, 256));
+        }
+    }
+    free(trail);
+    kstate_scratch_free(scratch);
+    printf("Visited-set depths match the linear-scan reference.\n");
+
+    // Matches and outputs must agree: every match depth is an output depth of the same rule.
+    uint32_t xs_flat[16] = {
+        0, 0, 0, 0,
+        0, 3, 3, 0,
+        0, 3, 3, 0,
+        0, 0, 0, 0
+    };
+    uint32_t ys_flat[16] = {
+        0, 0, 0, 0,
+        0, 0, 0, 0,
+        0, 0, 0, 0,
+        0, 0, 0, 0
+    };
+
+    int k = 4, family = KSTATE_OUTER_TOTALISTIC;
+    int table_size = kstate_table_size(family, k);
+
+    int* match_rule_depths[1];
+    uint8_t** match_rule_tables[1];
+    int match_counts[1];
+
+    simulate_kstate_matches(xs_flat, ys_flat, 1, NUM_RULES, 42, k, family, 1, 256, 3,
+                            match_rule_tables, match_rule_depths, match_counts);
+    printf("Pair 0: matches = %d / %d\n", match_counts[0], NUM_RULES);
+    assert(match_counts[0] > 0);
+
+    // A single thread finds the same matches in the same order.
+    int* serial_depths[1];
+    uint8_t** serial_tables[1];
+    int serial_counts[1];
+    simulate_kstate_matches(xs_flat, ys_flat, 1, NUM_RULES, 42, k, family, 1, 256, 1,
+                            serial_tables, serial_depths, serial_counts);
+    assert(serial_counts[0] == match_counts[0]);
+    for (int j = 0; j < match_counts[0]; ++j) {
+        assert(serial_depths[0][j] == match_rule_depths[0][j]);
+        assert(memcmp(serial_tables[0][j], match_rule_tables[0][j], table_size) == 0);
+    }
+    free_kstate_matches(1, serial_counts, serial_depths, serial_tables);
+
+    uint8_t* tables = malloc((size_t)match_counts[0] * table_size);
+    for (int j = 0; j < match_counts[0]; ++j)
+        for (int i = 0; i < table_size; ++i)
+            tables[j * table_size + i] = match_rule_tables[0][j][i];
+
+    KOutputMap* output_maps = NULL;
+    simulate_kstate_outputs(xs_flat, tables, match_counts[0], k, family, 1, 256, 3, &output_maps);
+
+    Matrix y;
+    flat_to_matrix(y, ys_flat);
+    for (int j = 0; j < match_counts[0]; ++j) {
+        int found = -1;
+        for (int i = 0; i < output_maps[j].num_outputs; ++i) {
+            if (matrix_equals(output_maps[j].outputs[i], y)) {
+                found = output_maps[j].depths[i];
+                break;
+            }
+        }
+        assert(found == match_rule_depths[0][j] && "Output depth disagrees with match depth");
+    }
+    printf("Outputs agree with matches for all %d matching rules.\n", match_counts[0]);
+
+    free_kstate_output_maps(match_counts[0], output_maps);
+    free(tables);
+    free_kstate_matches(1, match_counts, match_rule_depths, match_rule_tables);
+    return 0;
+}
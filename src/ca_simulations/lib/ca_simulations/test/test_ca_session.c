@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "simulate_rule_matches.h"
+#include "simulate_rule_outputs.h"
+#include "ca_dynamics.h"
+#include "ca_session.h"
+
+#define NUM_PAIRS 2
+#define NUM_RULES 3000
+#define SEED 42
+
+int main() {
+    uint32_t xs_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,1,1,0,
+         0,1,1,0,
+         0,0,0,0},
+
+        {0,0,0,1,
+         0,1,0,0,
+         0,0,1,0,
+         1,0,0,0}
+    };
+
+    uint32_t ys_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0},
+
+        {1,1,1,1,
+         1,1,1,1,
+         1,1,1,1,
+         1,1,1,1}
+    };
+
+    CASession* session = ca_session_create(SEED, NUM_RULES, 1, 256, 3);
+
+    // Matches: same rules, same order, same depths as the one-shot entry point.
+    int* ref_depths[NUM_PAIRS];
+    uint64_t** ref_numbers[NUM_PAIRS];
+    int ref_counts[NUM_PAIRS];
+    simulate_rule_matches((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, NUM_RULES, SEED, 1, 256,
+                          ref_numbers, ref_depths, ref_counts);
+
+    int* indices[NUM_PAIRS];
+    int* depths[NUM_PAIRS];
+    int counts[NUM_PAIRS];
+    int ctm_counts[NUM_PAIRS];
+    int min_depths[NUM_PAIRS];
+
+    // Run twice to check that queries leave no state behind.
+    for (int round = 0; round < 2; ++round) {
+        ca_session_matches(session, (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, indices, depths, counts);
+        ca_session_ctm(session, (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, ctm_counts, min_depths);
+
+        for (int i = 0; i < NUM_PAIRS; ++i) {
+            assert(counts[i] == ref_counts[i]);
+            assert(ctm_counts[i] == ref_counts[i]);
+
+            int best = -1;
+            for (int j = 0; j < counts[i]; ++j) {
+                const uint64_t* number = &session->rule_numbers[(size_t)indices[i][j] * 8];
+                assert(memcmp(number, ref_numbers[i][j], 8 * sizeof(uint64_t)) == 0);
+                assert(depths[i][j] == ref_depths[i][j]);
+                if (best < 0 || depths[i][j] < best) best = depths[i][j];
+            }
+            assert(min_depths[i] == best);
+        }
+        ca_session_free_matches(NUM_PAIRS, indices, depths);
+    }
+    printf("Session matches: %d and %d rules, identical to simulate_rule_matches.\n", ref_counts[0], ref_counts[1]);
+    free_matches(NUM_PAIRS, ref_counts, ref_depths, ref_numbers);
+
+    // Outputs: bank indices and explicit rules both agree with simulate_rule_outputs.
+    int num_check = 200;
+    int* bank_indices = malloc(num_check * sizeof(int));
+    for (int k = 0; k < num_check; ++k) bank_indices[k] = (k * 37) % NUM_RULES;
+
+    uint64_t* rules_flat = malloc((size_t)num_check * 8 * sizeof(uint64_t));
+    for (int k = 0; k < num_check; ++k) {
+        memcpy(&rules_flat[(size_t)k * 8], &session->rule_numbers[(size_t)bank_indices[k] * 8], 8 * sizeof(uint64_t));
+    }
+
+    OutputMap* reference = NULL;
+    OutputMap* by_index = NULL;
+    OutputMap* by_rule = NULL;
+    simulate_rule_outputs(xs_flat[1], rules_flat, num_check, 1, 256, &reference);
+    ca_session_outputs(session, xs_flat[1], bank_indices, num_check, &by_index);
+    ca_session_outputs_for_rules(session, xs_flat[1], rules_flat, num_check, &by_rule);
+
+    for (int k = 0; k < num_check; ++k) {
+        const OutputMap* maps[2] = {&by_index[k], &by_rule[k]};
+        for (int m = 0; m < 2; ++m) {
+            assert(memcmp(maps[m]->rule_number, reference[k].rule_number, sizeof(reference[k].rule_number)) == 0);
+            assert(maps[m]->num_outputs == reference[k].num_outputs);
+            for (int t = 0; t < reference[k].num_outputs; ++t) {
+                assert(matrix_equals(maps[m]->outputs[t], reference[k].outputs[t]));
+                assert(maps[m]->depths[t] == reference[k].depths[t]);
+            }
+        }
+    }
+    printf("Session outputs identical to simulate_rule_outputs for %d rules.\n", num_check);
+
+    free_output_maps(num_check, reference);
+    free_output_maps(num_check, by_index);
+    free_output_maps(num_check, by_rule);
+    free(rules_flat);
+    free(bank_indices);
+
+    // A symmetric-family bank: rotating the input rotates the output (toroidal grid).
+    CASession* full = ca_session_create_in_family(SEED, 200, RULE_FAMILY_FULL, 1, 256, 1);
+    assert(memcmp(full->rule_numbers, session->rule_numbers, 200 * 8 * sizeof(uint64_t)) == 0);
+    ca_session_destroy(full);
+
+    CASession* symmetric = ca_session_create_in_family(SEED, 200, RULE_FAMILY_SYMMETRIC, 1, 256, 1);
+    assert(symmetric && symmetric->family == RULE_FAMILY_SYMMETRIC);
+    Matrix in, rotated, out, out_rotated, expected;
+    flat_to_matrix(in, xs_flat[1]);
+    in[0][1] = 1;  // break the input's own symmetry
+    for (int i = 0; i < MATRIX_SIZE; ++i)
+        for (int j = 0; j < MATRIX_SIZE; ++j)
+            rotated[j][MATRIX_SIZE - 1 - i] = in[i][j];
+    for (int r = 0; r < symmetric->num_rules; ++r) {
+        apply_rule(out, in, &symmetric->rules[r], 1);
+        apply_rule(out_rotated, rotated, &symmetric->rules[r], 1);
+        for (int i = 0; i < MATRIX_SIZE; ++i)
+            for (int j = 0; j < MATRIX_SIZE; ++j)
+                expected[j][MATRIX_SIZE - 1 - i] = out[i][j];
+        assert(matrix_equals(out_rotated, expected));
+    }
+    ca_session_destroy(symmetric);
+    assert(ca_session_create_in_family(SEED, 10, 99, 1, 256, 1) == NULL);
+    printf("Family-restricted banks: full matches the default bank, symmetric rules commute with rotation.\n");
+
+    ca_session_destroy(session);
+    return 0;
+}
@@ -0,0 +1,153 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "ca_session.h"
+#include "ctm_server.h"
+
+#define NUM_CLIENTS 8
+#define PAIRS_PER_QUERY 3
+#define NUM_RULES 20000
+#define SEED 42
+
+typedef struct {
+    CTMServer* server;          // in-process client when set
+    const char* socket_path;    // socket client otherwise
+    uint32_t xs[PAIRS_PER_QUERY * 16];
+    uint32_t ys[PAIRS_PER_QUERY * 16];
+    int counts[PAIRS_PER_QUERY];
+    int depths[PAIRS_PER_QUERY];
+    int status;
+} Client;
+
+static void* client_main(void* arg) {
+    Client* c = arg;
+    c->status = c->server
+        ? ctm_server_submit(c->server, c->xs, c->ys, PAIRS_PER_QUERY, c->counts, c->depths)
+        : ctm_client_query(c->socket_path, c->xs, c->ys, PAIRS_PER_QUERY, c->counts, c->depths);
+    return NULL;
+}
+
+static void fill_grid(uint32_t* flat, uint16_t key) {
+    Matrix m;
+    hash_to_matrix(m, key);
+    for (int k = 0; k < 16; ++k) flat[k] = m[k / 4][k % 4];
+}
+
+// Sends a one-pair query and hangs up without reading the reply.
+static void hang_up_client(const char* socket_path, const uint32_t* x, const uint32_t* y) {
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strcpy(addr.sun_path, socket_path);
+
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    assert(fd >= 0 && connect(fd, (struct sockaddr*)&addr, sizeof(addr)) == 0);
+
+    uint8_t request[4 + sizeof(uint32_t) + 32];
+    uint32_t num_pairs = 1;
+    memcpy(request, "CTMQ", 4);
+    memcpy(request + 4, &num_pairs, sizeof(num_pairs));
+    for (int k = 0; k < 16; ++k) {
+        request[8 + k] = (uint8_t)x[k];
+        request[24 + k] = (uint8_t)y[k];
+    }
+    assert(write(fd, request, sizeof(request)) == (ssize_t)sizeof(request));
+    close(fd);
+}
+
+static void run_clients(Client* clients, CASession* reference) {
+    pthread_t threads[NUM_CLIENTS];
+    for (int c = 0; c < NUM_CLIENTS; ++c) pthread_create(&threads[c], NULL, client_main, &clients[c]);
+    for (int c = 0; c < NUM_CLIENTS; ++c) pthread_join(threads[c], NULL);
+
+    for (int c = 0; c < NUM_CLIENTS; ++c) {
+        int counts[PAIRS_PER_QUERY], depths[PAIRS_PER_QUERY];
+        ca_session_ctm(reference, clients[c].xs, clients[c].ys, PAIRS_PER_QUERY, counts, depths);
+
+        assert(clients[c].status == 0);
+        for (int i = 0; i < PAIRS_PER_QUERY; ++i) {
+            assert(clients[c].counts[i] == counts[i]);
+            assert(clients[c].depths[i] == depths[i]);
+        }
+    }
+}
+
+int main() {
+    // Each client asks about different pairs; answers must match a direct sweep.
+    Client clients[NUM_CLIENTS];
+    memset(clients, 0, sizeof(clients));
+    for (int c = 0; c < NUM_CLIENTS; ++c) {
+        for (int i = 0; i < PAIRS_PER_QUERY; ++i) {
+            fill_grid(&clients[c].xs[i * 16], (uint16_t)(0x0660 + 97 * (c * PAIRS_PER_QUERY + i)));
+            fill_grid(&clients[c].ys[i * 16], (uint16_t)((c + i) % 2 ? 0x0000 : 0xFFFF));
+        }
+    }
+
+    CASession* reference = ca_session_create(SEED, NUM_RULES, 1, 256, 1);
+    CTMServer* server = ctm_server_create(SEED, NUM_RULES, 1, 256, 0, 20000, 0);
+
+    for (int c = 0; c < NUM_CLIENTS; ++c) clients[c].server = server;
+    run_clients(clients, reference);
+
+    CTMServerMetrics metrics;
+    ctm_server_metrics(server, &metrics);
+    assert(metrics.queries == NUM_CLIENTS);
+    assert(metrics.pairs == NUM_CLIENTS * PAIRS_PER_QUERY);
+    assert(metrics.queue_depth == 0);
+    assert(metrics.batches < NUM_CLIENTS && "Concurrent queries were not coalesced");
+    printf("In-process: %d queries answered in %llu sweeps (max batch %d queries, max queue depth %d).\n",
+           NUM_CLIENTS, (unsigned long long)metrics.batches, metrics.max_batch_queries, metrics.max_queue_depth);
+
+    // Same queries over the Unix socket.
+    char socket_path[64];
+    snprintf(socket_path, sizeof(socket_path), "/tmp/test_ctm_server_%d.sock", (int)getpid());
+    assert(ctm_server_listen(server, socket_path) == 0);
+
+    for (int c = 0; c < NUM_CLIENTS; ++c) {
+        clients[c].server = NULL;
+        clients[c].socket_path = socket_path;
+        memset(clients[c].counts, 0, sizeof(clients[c].counts));
+    }
+    run_clients(clients, reference);
+
+    ctm_server_metrics(server, &metrics);
+    assert(metrics.queries == 2 * NUM_CLIENTS);
+    printf("Socket: %llu queries answered in %llu sweeps, mean batch %.1f pairs.\n",
+           (unsigned long long)metrics.queries, (unsigned long long)metrics.batches, metrics.mean_batch_pairs);
+
+    // A client that hangs up before its reply must not take the server down
+    // (the reply write would raise SIGPIPE); later clients are still served.
+    hang_up_client(socket_path, clients[0].xs, clients[0].ys);
+    for (int tries = 0; tries < 500 && metrics.queries < 2 * NUM_CLIENTS + 1; ++tries) {
+        usleep(10000);
+        ctm_server_metrics(server, &metrics);
+    }
+    assert(metrics.queries == 2 * NUM_CLIENTS + 1);
+    usleep(50000);  // let the connection thread attempt the reply
+    run_clients(clients, reference);
+    printf("Server survived a client that hung up before its reply.\n");
+
+    // A batch-size cap splits the queue into several sweeps.
+    CTMServer* capped = ctm_server_create(SEED, NUM_RULES, 1, 256, 0, 20000, PAIRS_PER_QUERY);
+    for (int c = 0; c < NUM_CLIENTS; ++c) clients[c].server = capped;
+    run_clients(clients, reference);
+    ctm_server_metrics(capped, &metrics);
+    assert(metrics.max_batch_pairs <= PAIRS_PER_QUERY && metrics.batches == NUM_CLIENTS);
+    ctm_server_destroy(capped);
+
+    ctm_server_destroy(server);
+    assert(access(socket_path, F_OK) != 0);
+    assert(ctm_client_query(socket_path, clients[0].xs, clients[0].ys, PAIRS_PER_QUERY,
+                            clients[0].counts, clients[0].depths) == -1);
+
+    ca_session_destroy(reference);
+    return 0;
+}
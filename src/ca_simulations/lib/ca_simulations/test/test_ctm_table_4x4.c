@@ -0,0 +1,69 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "ctm_table_4x4.h"
+
+#define NUM_GRIDS 5
+
+int main() {
+    // Synthetic table: complexity grows with the number of ones; one entry is missing.
+    static double values[CTM4X4_ENTRIES];
+    for (int key = 0; key < CTM4X4_ENTRIES; ++key) {
+        values[key] = 20.0 + __builtin_popcount(key);
+    }
+
+    uint32_t xs_flat[NUM_GRIDS][16] = {
+        {0,0,0,0, 0,0,0,0, 0,0,1,1, 0,0,1,1},  // 4 ones
+        {0,1,1,0, 0,1,1,0, 0,0,0,0, 0,0,0,0},  // 4 ones
+        {1,1,1,1, 1,1,1,1, 0,0,0,0, 0,0,0,0},  // 8 ones
+        {0,0,0,0, 0,0,0,0, 0,0,0,0, 0,0,0,1},  // 1 one, missing entry
+        {0,0,0,0, 0,0,0,0, 0,0,0,0, 0,1,1,0}   // 2 ones
+    };
+    uint32_t x_test_flat[16] = {0,0,0,0, 1,1,0,0, 1,1,0,0, 0,0,0,0};  // 4 ones
+
+    Matrix m;
+    flat_to_matrix(m, xs_flat[3]);
+    values[matrix_hash(m)] = NAN;
+
+    const char* path = "/tmp/test_ctm_table_4x4.bin";
+    assert(ctm4x4_write(path, values) == 0);
+
+    CTMTable4x4* table = ctm4x4_open(path);
+    assert(table);
+
+    double c[NUM_GRIDS];
+    ctm4x4_lookup_batch(table, (uint32_t*)xs_flat, NUM_GRIDS, c);
+    assert(c[0] == 24.0 && c[2] == 28.0 && isnan(c[3]) && c[4] == 22.0);
+
+    uint8_t keep[NUM_GRIDS];
+    int kept = ctm4x4_filter(table, (uint32_t*)xs_flat, NUM_GRIDS, x_test_flat, CTM4X4_MODE_ABSOLUTE, 2.0, keep);
+    assert(kept == 3 && keep[0] && keep[1] && !keep[2] && !keep[3] && keep[4]);
+
+    kept = ctm4x4_filter(table, (uint32_t*)xs_flat, NUM_GRIDS, x_test_flat, CTM4X4_MODE_PERCENT, 0.2, keep);
+    assert(kept == 4 && keep[2] && !keep[3]);
+    printf("Lookup and filtering agree with the expected selections.\n");
+
+    // A test input without an entry is an error, as in the Python filter.
+    assert(ctm4x4_filter(table, (uint32_t*)xs_flat, NUM_GRIDS, xs_flat[3], CTM4X4_MODE_ABSOLUTE, 2.0, keep) == -1);
+
+    ctm4x4_close(table);
+
+    // A file from a host of the other byte order reads its marker swapped.
+    FILE* f = fopen(path, "r+b");
+    assert(f);
+    uint32_t marker;
+    assert(fseek(f, 8, SEEK_SET) == 0 && fread(&marker, sizeof(marker), 1, f) == 1);
+    assert(marker == CTM4X4_BYTE_ORDER);
+    marker = __builtin_bswap32(marker);
+    assert(fseek(f, 8, SEEK_SET) == 0 && fwrite(&marker, sizeof(marker), 1, f) == 1);
+    fclose(f);
+    assert(ctm4x4_open(path) == NULL);
+
+    remove(path);
+    assert(ctm4x4_open(path) == NULL);
+    return 0;
+}
@@ -0,0 +1,167 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <inttypes.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "dataset_generator.h"
+#include "task_runner.h"
+
+#define NUM_TASKS 1000
+#define NUM_TRAIN 4
+#define NUM_TEST 1
+#define DEPTH 3
+
+static int files_equal(const char* a, const char* b) {
+    FILE* fa = fopen(a, "rb");
+    FILE* fb = fopen(b, "rb");
+    int equal = fa && fb;
+    while (equal) {
+        int ca = fgetc(fa), cb = fgetc(fb);
+        if (ca != cb) equal = 0;
+        if (ca == EOF || cb == EOF) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return equal;
+}
+
+// json.dump(grid, indent=2) nested `indent` spaces deep, appended at *end.
+static void append_grid(char** end, uint16_t key, int indent) {
+    Matrix m;
+    hash_to_matrix(m, key);
+    *end += sprintf(*end, "[\n");
+    for (int i = 0; i < 4; ++i) {
+        *end += sprintf(*end, "%*s[\n", indent + 2, "");
+        for (int j = 0; j < 4; ++j) *end += sprintf(*end, "%*s%d%s\n", indent + 4, "", m[i][j], j < 3 ? "," : "");
+        *end += sprintf(*end, "%*s]%s\n", indent + 2, "", i < 3 ? "," : "");
+    }
+    *end += sprintf(*end, "%*s]", indent, "");
+}
+
+static void append_pairs(char** end, const char* name, const uint16_t* inputs, const uint16_t* outputs, int n) {
+    *end += sprintf(*end, "  \"%s\": [\n", name);
+    for (int i = 0; i < n; ++i) {
+        *end += sprintf(*end, "    {\n      \"input\": ");
+        append_grid(end, inputs[i], 6);
+        *end += sprintf(*end, ",\n      \"output\": ");
+        append_grid(end, outputs[i], 6);
+        *end += sprintf(*end, "\n    }%s\n", i < n - 1 ? "," : "");
+    }
+    *end += sprintf(*end, "  ],\n");
+}
+
+static char* read_file(const char* path) {
+    FILE* f = fopen(path, "rb");
+    assert(f);
+    static char text[1 << 16];
+    size_t n = fread(text, 1, sizeof(text) - 1, f);
+    fclose(f);
+    text[n] = '\0';
+    return text;
+}
+
+int main() {
+    const char* path = "/tmp/test_dataset_ca.bin";
+    const char* path_serial = "/tmp/test_dataset_ca_serial.bin";
+
+    assert(generate_dataset(path, NUM_TASKS, NUM_TRAIN, NUM_TEST, GEN_TRANSFORM_CA_RULE, DEPTH, 42, 1, 0) == 0);
+    assert(generate_dataset(path_serial, NUM_TASKS, NUM_TRAIN, NUM_TEST, GEN_TRANSFORM_CA_RULE, DEPTH, 42, 1, 1) == 0);
+    assert(files_equal(path, path_serial) && "Dataset depends on the thread count");
+
+    Dataset* dataset = dataset_open(path);
+    assert(dataset && dataset->header->num_tasks == NUM_TASKS);
+
+    // Outputs must be DEPTH applications of the stored rule, and inputs distinct.
+    for (int t = 0; t < NUM_TASKS; ++t) {
+        Rule512 rule;
+        rule_from_number(&rule, dataset_task_rule(dataset, t));
+        const uint16_t* grids = dataset_task_grids(dataset, t);
+
+        for (int i = 0; i < NUM_TRAIN + NUM_TEST; ++i) {
+            int in = i < NUM_TRAIN ? i : NUM_TRAIN + i;
+            int out = i < NUM_TRAIN ? NUM_TRAIN + i : NUM_TRAIN + NUM_TEST + i;
+
+            Matrix x, y, next;
+            hash_to_matrix(x, grids[in]);
+            for (int s = 0; s < DEPTH; ++s) {
+                apply_rule(next, x, &rule, 1);
+                copy_matrix(x, next);
+            }
+            hash_to_matrix(y, grids[out]);
+            assert(matrix_equals(x, y) && "Output is not the CA image of the input");
+
+            for (int j = 0; j < i; ++j) {
+                assert(grids[in] != grids[j < NUM_TRAIN ? j : NUM_TRAIN + j]);
+            }
+        }
+    }
+    printf("Generated %d CA tasks; outputs verified against apply_rule.\n", NUM_TASKS);
+
+    char dir[] = "/tmp/test_dataset_generator_XXXXXX";
+    assert(mkdtemp(dir));
+    char json_path[512];
+
+    // Exported tasks parse back to the stored grids and carry their rule.
+    assert(dataset_export_json(dataset, dir, 0, 2) == 2);
+    for (int t = 0; t < 2; ++t) {
+        snprintf(json_path, sizeof(json_path), "%s/task_%04d_ca_rule_42.json", dir, t + 1);
+        RunnerTask task;
+        assert(runner_load_task(json_path, &task) == 0);
+        const uint16_t* grids = dataset_task_grids(dataset, t);
+        assert(task.num_train == NUM_TRAIN && task.num_test == NUM_TEST && task.has_test_outputs);
+        for (int i = 0; i < NUM_TRAIN; ++i) {
+            assert(task.train_inputs[i] == grids[i] && task.train_outputs[i] == grids[NUM_TRAIN + i]);
+        }
+        assert(task.test_inputs[0] == grids[2 * NUM_TRAIN] && task.test_outputs[0] == grids[2 * NUM_TRAIN + 1]);
+        runner_free_task(&task);
+
+        const uint64_t* rule_number = dataset_task_rule(dataset, t);
+        char rule[160], *end = rule;
+        end += sprintf(end, "\"rule\": \"0x");
+        for (int k = 7; k >= 0; --k) end += sprintf(end, "%016" PRIx64, rule_number[k]);
+        sprintf(end, "\"\n");
+        assert(strstr(read_file(json_path), rule));
+        remove(json_path);
+    }
+    dataset_close(dataset);
+
+    // Bit inversion tasks export in the builder's JSON layout.
+    assert(generate_dataset(path, 3, NUM_TRAIN, NUM_TEST, GEN_TRANSFORM_BIT_INVERSION, 0, 42, 1, 0) == 0);
+    dataset = dataset_open(path);
+    assert(dataset);
+    const uint16_t* grids = dataset_task_grids(dataset, 0);
+    uint16_t inverted = (uint16_t)~grids[0];
+    assert(inverted == grids[NUM_TRAIN]);
+    assert(dataset_export_json(dataset, dir, 0, -1) == 3);
+
+    static char expected[1 << 16];
+    char* end = expected;
+    end += sprintf(end, "{\n");
+    append_pairs(&end, "train", grids, grids + NUM_TRAIN, NUM_TRAIN);
+    append_pairs(&end, "test", grids + 2 * NUM_TRAIN, grids + 2 * NUM_TRAIN + NUM_TEST, NUM_TEST);
+    sprintf(end, "  \"metadata\": {\n    \"transformation\": \"bit_inversion\",\n    \"seed\": 42,\n"
+                 "    \"boundary_mode\": 1\n  }\n}");
+    snprintf(json_path, sizeof(json_path), "%s/task_0001_bit_inversion_42.json", dir);
+    assert(strcmp(read_file(json_path), expected) == 0 && "Export differs from the indent=2 layout");
+    printf("Exported tasks read back; bit inversion matches the builder's JSON layout.\n");
+    dataset_close(dataset);
+
+    for (int t = 0; t < 3; ++t) {
+        snprintf(json_path, sizeof(json_path), "%s/task_%04d_bit_inversion_42.json", dir, t + 1);
+        assert(remove(json_path) == 0);
+    }
+    assert(rmdir(dir) == 0);
+
+    // Invalid arguments are rejected.
+    assert(generate_dataset(path, 10, 0, 1, GEN_TRANSFORM_BIT_INVERSION, 0, 1, 1, 0) == -1);
+    assert(generate_dataset(path, 10, 2, 1, GEN_TRANSFORM_CA_RULE, 0, 1, 1, 0) == -1);
+
+    remove(path);
+    remove(path_serial);
+    return 0;
+}
@@ -0,0 +1,122 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <assert.h>
+
+#include "prng/prng.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "simulate_rule_matches.h"
+#include "enumerate_rule_matches.h"
+
+#define NUM_PAIRS 2
+
+int main() {
+    // The packed kernel must agree with the reference Matrix kernel.
+    prng_seed(3);
+    SimScratch* scratch = sim_scratch_create();
+    for (int n = 0; n < 2000; ++n) {
+        Rule512 rule;
+        random_rule_in_family(&rule, n % 4);
+        int boundary_mode = n % 2;
+
+        Matrix x, y, next;
+        hash_to_matrix(x, prng_next() & 0xFFFF);
+        hash_to_matrix(y, prng_next() & 0xFFFF);
+
+        apply_rule(next, x, &rule, boundary_mode);
+        assert(apply_rule_packed(matrix_hash(x), &rule, boundary_mode) == matrix_hash(next));
+
+        // Steer half of the targets onto the trajectory so both outcomes are exercised.
+        if (n % 2) {
+            copy_matrix(y, next);
+            for (int t = 0; t < n % 7; ++t) {
+                apply_rule(next, y, &rule, boundary_mode);
+                copy_matrix(y, next);
+            }
+        }
+        int expected = simulate_with_depth(x, y, &rule, boundary_mode, 64);
+        int actual = simulate_packed_with_depth(matrix_hash(x), matrix_hash(y), &rule, boundary_mode, 64, scratch);
+        assert(expected == actual && "Packed kernel disagrees with simulate_with_depth");
+    }
+    sim_scratch_free(scratch);
+    printf("Packed kernel agrees with simulate_with_depth.\n");
+
+    uint32_t xs_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,1,1,0,
+         0,1,1,0,
+         0,0,0,0},
+
+        {0,0,0,1,
+         0,1,0,0,
+         0,0,1,0,
+         1,0,0,0}
+    };
+
+    uint32_t ys_flat[NUM_PAIRS][16] = {
+        {0,1,1,0,
+         1,0,0,1,
+         1,0,0,1,
+         0,1,1,0},
+
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0}
+    };
+
+    // Exact counts over the totalistic family, checked against a serial reference sweep.
+    int* match_rule_depths[NUM_PAIRS];
+    uint64_t** match_rule_numbers[NUM_PAIRS];
+    int match_counts[NUM_PAIRS];
+
+    uint64_t family_size = enumerate_rule_matches(
+        (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS,
+        RULE_FAMILY_TOTALISTIC, 1, 256, 4,
+        match_rule_numbers, match_rule_depths, match_counts
+    );
+    assert(family_size == 1024);
+
+    for (int i = 0; i < NUM_PAIRS; ++i) {
+        Matrix x, y;
+        flat_to_matrix(x, xs_flat[i]);
+        flat_to_matrix(y, ys_flat[i]);
+
+        int expected = 0;
+        for (uint64_t index = 0; index < family_size; ++index) {
+            Rule512 rule;
+            uint64_t number[8];
+            rule_family_expand(RULE_FAMILY_TOTALISTIC, &index, &rule);
+            int depth = simulate_with_depth(x, y, &rule, 1, 256);
+            if (depth < 0) continue;
+
+            compute_rule_number(&rule, number);
+            for (int k = 0; k < 8; ++k) assert(number[k] == match_rule_numbers[i][expected][k]);
+            assert(depth == match_rule_depths[i][expected]);
+            expected++;
+        }
+        assert(expected == match_counts[i]);
+        printf("Pair %d: m(y|x) = %d / %llu (exact)\n", i, match_counts[i], (unsigned long long)family_size);
+    }
+
+    // Thread count must not change the result.
+    uint64_t counts_1[NUM_PAIRS], counts_n[NUM_PAIRS];
+    int depths_1[NUM_PAIRS], depths_n[NUM_PAIRS];
+    enumerate_rule_ctm((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, RULE_FAMILY_OUTER_TOTALISTIC,
+                       1, 256, 1, counts_1, depths_1);
+    enumerate_rule_ctm((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, RULE_FAMILY_OUTER_TOTALISTIC,
+                       1, 256, 0, counts_n, depths_n);
+    for (int i = 0; i < NUM_PAIRS; ++i) {
+        assert(counts_1[i] == counts_n[i] && depths_1[i] == depths_n[i]);
+        printf("Pair %d: outer-totalistic m(y|x) = %llu / %d, min depth = %d\n",
+               i, (unsigned long long)counts_n[i], 1 << 18, depths_n[i]);
+    }
+
+    // Non-enumerable families are rejected.
+    assert(enumerate_rule_ctm((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, RULE_FAMILY_SYMMETRIC,
+                              1, 256, 0, counts_n, depths_n) == 0);
+
+    free_matches(NUM_PAIRS, match_counts, match_rule_depths, match_rule_numbers);
+    return 0;
+}
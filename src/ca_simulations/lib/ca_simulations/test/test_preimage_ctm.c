@@ -0,0 +1,111 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "prng/prng.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "ca_session.h"
+#include "preimage_ctm.h"
+
+#define NUM_STATES (1 << 16)
+#define NUM_RULES 300
+#define SEED 42
+
+static void hash_to_flat(uint32_t* flat, uint16_t state) {
+    for (int k = 0; k < 16; ++k) flat[k] = (state >> (15 - k)) & 1;
+}
+
+// Predecessor sets match a brute-force scan, for sparse and dense rules alike.
+static void check_preimages(int boundary_mode) {
+    uint16_t* found = malloc(NUM_STATES * sizeof(uint16_t));
+    uint16_t* expected = malloc(NUM_STATES * sizeof(uint16_t));
+    uint16_t* image = malloc(NUM_STATES * sizeof(uint16_t));
+    PreimageTable* table = malloc(sizeof(PreimageTable));
+
+    prng_seed(7);
+    for (int k = 0; k < 6; ++k) {
+        Rule512 rule;
+        if (k < 3) random_rule(&rule);
+        else random_rule_with_density(&rule, 40 + 200 * (k - 3));
+        preimage_table_build(table, &rule, boundary_mode);
+
+        for (int s = 0; s < NUM_STATES; ++s) image[s] = apply_rule_packed((uint16_t)s, &rule, boundary_mode);
+
+        for (int probe = 0; probe < 8; ++probe) {
+            uint16_t target = image[(probe * 9973) % NUM_STATES];
+            int n = 0;
+            for (int s = 0; s < NUM_STATES; ++s) {
+                if (image[s] == target) expected[n++] = (uint16_t)s;
+            }
+            assert(rule_preimages(target, table, boundary_mode, found) == n);
+            assert(memcmp(found, expected, n * sizeof(uint16_t)) == 0);
+        }
+    }
+
+    free(table);
+    free(image);
+    free(expected);
+    free(found);
+}
+
+// The column agrees with forward simulation of every (x, y) pair over the same rules.
+static void check_column(uint16_t y, int boundary_mode, int max_steps) {
+    int* counts = malloc(NUM_STATES * sizeof(int));
+    int* depths = malloc(NUM_STATES * sizeof(int));
+    uint32_t y_flat[16];
+    hash_to_flat(y_flat, y);
+
+    assert(preimage_ctm(y_flat, SEED, NUM_RULES, boundary_mode, max_steps, 3, counts, depths) == NUM_RULES);
+
+    // Forward-check a spread of reached and unreached inputs.
+    int* probe = malloc(NUM_STATES * sizeof(int));
+    int num_probes = 0;
+    for (int x = 0; x < NUM_STATES; ++x) {
+        if ((counts[x] > 0 && x % 13 == 0) || x % 61 == 0) probe[num_probes++] = x;
+    }
+
+    uint32_t* xs_flat = malloc((size_t)num_probes * 16 * sizeof(uint32_t));
+    uint32_t* ys_flat = malloc((size_t)num_probes * 16 * sizeof(uint32_t));
+    for (int i = 0; i < num_probes; ++i) {
+        hash_to_flat(&xs_flat[(size_t)i * 16], (uint16_t)probe[i]);
+        memcpy(&ys_flat[(size_t)i * 16], y_flat, sizeof(y_flat));
+    }
+
+    int* ref_counts = malloc(num_probes * sizeof(int));
+    int* ref_depths = malloc(num_probes * sizeof(int));
+    CASession* session = ca_session_create(SEED, NUM_RULES, boundary_mode, max_steps, 3);
+    ca_session_ctm(session, xs_flat, ys_flat, num_probes, ref_counts, ref_depths);
+    ca_session_destroy(session);
+
+    for (int i = 0; i < num_probes; ++i) {
+        assert(counts[probe[i]] == ref_counts[i]);
+        assert(depths[probe[i]] == ref_depths[i]);
+    }
+    int reached = 0;
+    for (int x = 0; x < NUM_STATES; ++x) reached += counts[x] > 0;
+    assert(counts[y] == NUM_RULES && depths[y] == 0);
+    printf("y=%04x boundary=%d max_steps=%d: %d inputs reach y, identical to forward simulation.\n",
+           y, boundary_mode, max_steps, reached);
+
+    free(ref_depths);
+    free(ref_counts);
+    free(ys_flat);
+    free(xs_flat);
+    free(probe);
+    free(depths);
+    free(counts);
+}
+
+int main() {
+    check_preimages(1);
+    check_preimages(0);
+    printf("Preimages match brute force.\n");
+
+    check_column(0x8421, 1, 256);
+    check_column(0x0660, 0, 256);
+    check_column(0x0660, 1, 3);  // depth cut-off
+    return 0;
+}
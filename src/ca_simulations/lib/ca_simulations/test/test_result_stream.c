@@ -0,0 +1,137 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <signal.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "simulate_rule_outputs.h"
+#include "ca_session.h"
+#include "result_stream.h"
+
+#define NUM_PAIRS 2
+#define NUM_RULES 10000
+#define SEED 42
+#define CHUNK 7   // tiny ring so the producer keeps hitting backpressure
+#define WORKERS 3
+#define MAX_STEPS 256
+
+int main() {
+    uint32_t xs_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,1,1,0,
+         0,1,1,0,
+         0,0,0,0},
+
+        {0,0,0,1,
+         0,1,0,0,
+         0,0,1,0,
+         1,0,0,0}
+    };
+
+    uint32_t ys_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0},
+
+        {1,1,1,1,
+         1,1,1,1,
+         1,1,1,1,
+         1,1,1,1}
+    };
+
+    CASession* session = ca_session_create(SEED, NUM_RULES, 1, MAX_STEPS, WORKERS);
+
+    // Matches: per pair, the streamed records are exactly the blocking result, in order.
+    int* indices[NUM_PAIRS];
+    int* depths[NUM_PAIRS];
+    int counts[NUM_PAIRS];
+    ca_session_matches(session, (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, indices, depths, counts);
+
+    StreamMatch matches[CHUNK];
+    int seen[NUM_PAIRS] = {0, 0};
+    int chunks = 0;
+    ResultStream* stream = result_stream_matches(session, (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, CHUNK, 2);
+    int n;
+    while ((n = result_stream_next(stream, matches)) > 0) {
+        assert(n <= CHUNK);
+        chunks++;
+        for (int k = 0; k < n; ++k) {
+            int i = matches[k].pair;
+            assert(i >= 0 && i < NUM_PAIRS && seen[i] < counts[i]);
+            assert(matches[k].rule_index == indices[i][seen[i]]);
+            assert(matches[k].depth == depths[i][seen[i]]);
+            seen[i]++;
+        }
+    }
+    for (int i = 0; i < NUM_PAIRS; ++i) assert(seen[i] == counts[i]);
+    assert(result_stream_next(stream, matches) == 0);
+
+    // Buffered records stay near the ring's capacity: the budget plus a group per worker.
+    assert(result_stream_peak_records(stream) <= 2 * CHUNK + WORKERS * 16 * NUM_PAIRS);
+    result_stream_close(stream);
+    printf("Streamed %d + %d matches in %d chunks, identical to ca_session_matches.\n", counts[0], counts[1], chunks);
+    ca_session_free_matches(NUM_PAIRS, indices, depths);
+
+    // Outputs: rule by rule, the same trajectories as ca_session_outputs_for_rules.
+    int num_check = 500;
+    uint64_t* rules_flat = malloc((size_t)num_check * 8 * sizeof(uint64_t));
+    for (int k = 0; k < num_check; ++k) {
+        memcpy(&rules_flat[(size_t)k * 8], &session->rule_numbers[(size_t)((k * 13) % NUM_RULES) * 8], 8 * sizeof(uint64_t));
+    }
+    OutputMap* reference = NULL;
+    ca_session_outputs_for_rules(session, xs_flat[1], rules_flat, num_check, &reference);
+
+    StreamOutput outputs[CHUNK];
+    int rule = 0;
+    int step = 0;
+    stream = result_stream_outputs(session, xs_flat[1], rules_flat, num_check, CHUNK, 3);
+    while ((n = result_stream_next(stream, outputs)) > 0) {
+        for (int k = 0; k < n; ++k) {
+            while (rule < num_check && step == reference[rule].num_outputs) {
+                rule++;
+                step = 0;
+            }
+            assert(rule < num_check && outputs[k].rule_index == rule && outputs[k].depth == step);
+            assert(memcmp(&rules_flat[(size_t)rule * 8], reference[rule].rule_number, sizeof(reference[rule].rule_number)) == 0);
+
+            Matrix m;
+            hash_to_matrix(m, outputs[k].state);
+            assert(matrix_equals(m, reference[rule].outputs[step]));
+            step++;
+        }
+    }
+    // At most one trajectory per worker beyond the ring, however long the trajectories.
+    size_t peak = result_stream_peak_records(stream);
+    assert(peak <= 3 * CHUNK + WORKERS * MAX_STEPS);
+    result_stream_close(stream);
+    printf("Streamed outputs identical to ca_session_outputs_for_rules for %d rules (peak %zu buffered records).\n",
+           num_check, peak);
+
+    // Closing mid-sweep stops a producer blocked on a full ring.
+    stream = result_stream_outputs(session, xs_flat[1], rules_flat, num_check, CHUNK, 1);
+    assert(result_stream_next(stream, outputs) == CHUNK);
+    result_stream_close(stream);
+    printf("Early close released the producer.\n");
+
+    // SIGINT stops the sweep; the stream ends with -1 after the records already produced.
+    stream = result_stream_outputs(session, xs_flat[1], rules_flat, num_check, CHUNK, 1);
+    assert(result_stream_next(stream, outputs) == CHUNK);
+    raise(SIGINT);
+    int streamed = CHUNK;
+    while ((n = result_stream_next(stream, outputs)) > 0) streamed += n;
+    assert(n == -1);
+    result_stream_close(stream);
+
+    int all_outputs = 0;
+    for (int r = 0; r < num_check; ++r) all_outputs += reference[r].num_outputs;
+    assert(streamed < all_outputs);
+    printf("SIGINT ended the stream after %d of %d records.\n", streamed, all_outputs);
+
+    free_output_maps(num_check, reference);
+    free(rules_flat);
+    ca_session_destroy(session);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+#include <unistd.h>
+
+#include "matrix_utils.h"
+#include "simulate_rule_matches.h"
+#include "simulate_rule_outputs.h"
+#include "rule_bank.h"
+
+#define NUM_PAIRS 2
+#define NUM_RULES 3000
+#define SPLIT 1234
+#define SEED 42
+
+int main() {
+    uint32_t xs_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,1,1,0,
+         0,1,1,0,
+         0,0,0,0},
+
+        {0,0,0,1,
+         0,1,0,0,
+         0,0,1,0,
+         1,0,0,0}
+    };
+
+    uint32_t ys_flat[NUM_PAIRS][16] = {
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0},
+
+        {1,1,1,1,
+         1,1,1,1,
+         1,1,1,1,
+         1,1,1,1}
+    };
+
+    char path[] = "/tmp/test_rule_bank_XXXXXX";
+    int fd = mkstemp(path);
+    assert(fd >= 0);
+    close(fd);
+
+    assert(rule_bank_write(path, SEED, NUM_RULES) == 0);
+    RuleBank* bank = rule_bank_open(path);
+    assert(bank && bank->seed == SEED && bank->num_rules == NUM_RULES);
+    assert(bank->encoding == RULE_BANK_ENCODING_NUMBERS);
+
+    // Matches over two disjoint ranges together equal simulate_rule_matches.
+    int* ref_depths[NUM_PAIRS];
+    uint64_t** ref_numbers[NUM_PAIRS];
+    int ref_counts[NUM_PAIRS];
+    simulate_rule_matches((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, NUM_RULES, SEED, 1, 256,
+                          ref_numbers, ref_depths, ref_counts);
+
+    int* indices[2][NUM_PAIRS];
+    int* depths[2][NUM_PAIRS];
+    int counts[2][NUM_PAIRS];
+    int ctm_counts[2][NUM_PAIRS];
+    int min_depths[2][NUM_PAIRS];
+    int ranges[3] = {0, SPLIT, NUM_RULES + 100};  // ends past the bank are clamped
+
+    for (int h = 0; h < 2; ++h) {
+        rule_bank_matches(bank, ranges[h], ranges[h + 1], (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, 1, 256,
+                          indices[h], depths[h], counts[h]);
+        rule_bank_ctm(bank, ranges[h], ranges[h + 1], (uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, 1, 256,
+                      ctm_counts[h], min_depths[h]);
+    }
+
+    for (int i = 0; i < NUM_PAIRS; ++i) {
+        assert(counts[0][i] + counts[1][i] == ref_counts[i]);
+
+        int j = 0;
+        for (int h = 0; h < 2; ++h) {
+            assert(ctm_counts[h][i] == counts[h][i]);
+
+            int best = -1;
+            for (int k = 0; k < counts[h][i]; ++k, ++j) {
+                int r = indices[h][i][k];
+                assert(r >= ranges[h] && r < ranges[h + 1]);
+                assert(memcmp(&bank->rule_numbers[(size_t)r * 8], ref_numbers[i][j], 8 * sizeof(uint64_t)) == 0);
+                assert(depths[h][i][k] == ref_depths[i][j]);
+                if (best < 0 || depths[h][i][k] < best) best = depths[h][i][k];
+            }
+            assert(min_depths[h][i] == best);
+        }
+    }
+    rule_bank_free_matches(NUM_PAIRS, indices[0], depths[0]);
+    rule_bank_free_matches(NUM_PAIRS, indices[1], depths[1]);
+    printf("Bank matches over [0, %d) + [%d, %d): %d and %d rules, identical to simulate_rule_matches.\n",
+           SPLIT, SPLIT, NUM_RULES, ref_counts[0], ref_counts[1]);
+    free_matches(NUM_PAIRS, ref_counts, ref_depths, ref_numbers);
+
+    // Outputs read straight from the mapping agree with simulate_rule_outputs on a copy.
+    int begin = 500, end = 700;
+    uint64_t* rules_flat = malloc((size_t)(end - begin) * 8 * sizeof(uint64_t));
+    memcpy(rules_flat, &bank->rule_numbers[(size_t)begin * 8], (size_t)(end - begin) * 8 * sizeof(uint64_t));
+
+    OutputMap* reference = NULL;
+    OutputMap* mapped = NULL;
+    simulate_rule_outputs(xs_flat[1], rules_flat, end - begin, 1, 256, &reference);
+    rule_bank_outputs(bank, begin, end, xs_flat[1], 1, 256, &mapped);
+
+    for (int k = 0; k < end - begin; ++k) {
+        assert(memcmp(mapped[k].rule_number, reference[k].rule_number, sizeof(reference[k].rule_number)) == 0);
+        assert(mapped[k].num_outputs == reference[k].num_outputs);
+        for (int t = 0; t < reference[k].num_outputs; ++t) {
+            assert(matrix_equals(mapped[k].outputs[t], reference[k].outputs[t]));
+            assert(mapped[k].depths[t] == reference[k].depths[t]);
+        }
+    }
+    printf("Bank outputs identical to simulate_rule_outputs for rules [%d, %d).\n", begin, end);
+
+    free_output_maps(end - begin, reference);
+    free_output_maps(end - begin, mapped);
+    free(rules_flat);
+    rule_bank_close(bank);
+
+    // A file from a host of the other byte order reads its marker swapped.
+    FILE* f = fopen(path, "r+b");
+    assert(f);
+    uint32_t marker;
+    assert(fseek(f, 12, SEEK_SET) == 0 && fread(&marker, sizeof(marker), 1, f) == 1);
+    assert(marker == RULE_BANK_BYTE_ORDER);
+    marker = __builtin_bswap32(marker);
+    assert(fseek(f, 12, SEEK_SET) == 0 && fwrite(&marker, sizeof(marker), 1, f) == 1);
+    fclose(f);
+    assert(rule_bank_open(path) == NULL);
+    assert(rule_bank_write(path, SEED, NUM_RULES) == 0);
+
+    // Truncated files are rejected.
+    assert(truncate(path, 64 + 8 * sizeof(uint64_t) * 10 + 3) == 0);
+    assert(rule_bank_open(path) == NULL);
+    unlink(path);
+    assert(rule_bank_open(path) == NULL);
+    printf("Foreign byte order, malformed and missing bank files rejected.\n");
+
+    return 0;
+}
@@ -0,0 +1,101 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "prng/prng.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "simulate_rule_outputs.h"
+#include "rule_classes.h"
+
+#define NUM_RULES 3000
+#define NUM_XS 2
+
+static int outputs_equal(const OutputMap* a, const OutputMap* b) {
+    if (a->num_outputs != b->num_outputs) return 0;
+    for (int t = 0; t < a->num_outputs; ++t) {
+        if (!matrix_equals(a->outputs[t], b->outputs[t]) || a->depths[t] != b->depths[t]) return 0;
+    }
+    return 1;
+}
+
+int main() {
+    uint32_t xs_flat[NUM_XS][16] = {
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0},
+
+        {0,0,0,0,
+         0,1,0,0,
+         0,0,0,0,
+         0,0,0,0}
+    };
+
+    // Sparse rules read few codes from these starts, so many of them collapse.
+    prng_seed(11);
+    uint64_t* rules_flat = malloc((size_t)NUM_RULES * 8 * sizeof(uint64_t));
+    for (int r = 0; r < NUM_RULES; ++r) {
+        Rule512 rule;
+        random_rule_with_density(&rule, 4 + r % 60);
+        compute_rule_number(&rule, &rules_flat[(size_t)r * 8]);
+    }
+
+    // The traced kernel visits the same states as the plain one.
+    SimScratch* scratch = sim_scratch_create();
+    uint16_t plain[256], traced[256];
+    for (int r = 0; r < 200; ++r) {
+        Rule512 rule;
+        uint64_t used[8] = {0};
+        rule_from_number(&rule, &rules_flat[(size_t)r * 8]);
+        int n = simulate_packed_trajectory(0x0400, &rule, 1, 256, scratch, plain);
+        assert(simulate_packed_trajectory_traced(0x0400, &rule, 1, 256, scratch, traced, used) == n);
+        assert(memcmp(plain, traced, n * sizeof(uint16_t)) == 0);
+        assert(used[0] & 1);  // the all-zero window is read from 0x0400
+    }
+    sim_scratch_free(scratch);
+
+    int* class_of = malloc(NUM_RULES * sizeof(int));
+    int* representatives = malloc(NUM_RULES * sizeof(int));
+    int* multiplicities = malloc(NUM_RULES * sizeof(int));
+    int* used_codes = malloc(NUM_RULES * sizeof(int));
+
+    int num_classes = rule_equivalence_classes(rules_flat, NUM_RULES, (uint32_t*)xs_flat, NUM_XS, 1, 256, 0,
+                                               class_of, representatives, multiplicities, used_codes);
+    assert(num_classes > 0 && num_classes < NUM_RULES);
+
+    int total = 0;
+    for (int c = 0; c < num_classes; ++c) {
+        total += multiplicities[c];
+        assert(class_of[representatives[c]] == c);
+        assert(c == 0 || representatives[c] > representatives[c - 1]);
+    }
+    assert(total == NUM_RULES);
+
+    // Every rule behaves exactly like its representative from every start.
+    for (int i = 0; i < NUM_XS; ++i) {
+        OutputMap* maps = NULL;
+        simulate_rule_outputs(xs_flat[i], rules_flat, NUM_RULES, 1, 256, &maps);
+        for (int r = 0; r < NUM_RULES; ++r) {
+            assert(outputs_equal(&maps[r], &maps[representatives[class_of[r]]]));
+        }
+        free_output_maps(NUM_RULES, maps);
+    }
+    printf("%d rules collapse into %d classes (the first reads %d codes).\n", NUM_RULES, num_classes, used_codes[0]);
+
+    // Thread count does not change the classes.
+    int* class_of_1 = malloc(NUM_RULES * sizeof(int));
+    assert(rule_equivalence_classes(rules_flat, NUM_RULES, (uint32_t*)xs_flat, NUM_XS, 1, 256, 1,
+                                    class_of_1, representatives, multiplicities, NULL) == num_classes);
+    assert(memcmp(class_of, class_of_1, NUM_RULES * sizeof(int)) == 0);
+
+    free(class_of_1);
+    free(used_codes);
+    free(multiplicities);
+    free(representatives);
+    free(class_of);
+    free(rules_flat);
+    return 0;
+}
@@ -0,0 +1,168 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <math.h>
+#include <assert.h>
+
+#include "prng/prng.h"
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "simulate_rule_matches.h"
+#include "stratified_rule_ctm.h"
+
+#define NUM_PAIRS 3
+#define NUM_STRATA 16
+#define PILOT_PER_STRATUM 20000
+#define MIN_PER_STRATUM 200
+#define NUM_RULES 400000
+#define UNIFORM_RULES 400000
+
+static int popcount_rule(const Rule512* rule) {
+    int ones = 0;
+    for (int i = 0; i < RULE_BYTES; ++i) ones += __builtin_popcount(rule->table[i]);
+    return ones;
+}
+
+int main() {
+    // Density-conditioned sampling hits the requested density exactly.
+    prng_seed(1);
+    for (int ones = 0; ones <= 512; ones += 37) {
+        Rule512 rule;
+        random_rule_with_density(&rule, ones);
+        assert(popcount_rule(&rule) == ones);
+    }
+
+    uint32_t xs_flat[NUM_PAIRS][16] = {
+        // Reached mostly by sparse rules: ~1e-3 at density 256, ~1e-2 four sd below.
+        {0,1,1,0,
+         1,1,1,0,
+         1,1,1,0,
+         0,1,1,0},
+
+        // Reached mostly by dense rules.
+        {1,0,1,1,
+         0,0,0,0,
+         1,1,1,1,
+         1,1,1,1},
+
+        // Reached iff the rule's top bit is 0, so m = 1/2 exactly.
+        {1,1,1,1,
+         1,1,1,1,
+         1,1,1,1,
+         1,1,1,1}
+    };
+
+    uint32_t ys_flat[NUM_PAIRS][16] = {
+        {0,1,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0},
+
+        {1,1,1,0,
+         1,1,1,1,
+         1,1,1,1,
+         1,1,1,1},
+
+        {0,0,0,0,
+         0,0,0,0,
+         0,0,0,0,
+         0,0,0,0}
+    };
+
+    // Fixed bands tile 0..512 in order; their weights are the Binomial(512, 1/2) masses.
+    int next_lo = 0;
+    for (int h = 0; h < NUM_STRATA; ++h) {
+        int lo, hi;
+        stratum_density_range(NUM_STRATA, h, &lo, &hi);
+        assert(lo == next_lo && lo <= hi);
+        next_lo = hi + 1;
+    }
+    assert(next_lo == 513);
+
+    // Pilot: the same number of rules in every band, so the outer bands (W_h ~ 1e-4)
+    // are simulated hundreds of times more often than uniform sampling would.
+    int pilot[NUM_STRATA];
+    for (int h = 0; h < NUM_STRATA; ++h) pilot[h] = PILOT_PER_STRATUM;
+
+    double weights[NUM_STRATA];
+    uint64_t pilot_counts[NUM_PAIRS * NUM_STRATA];
+    int min_depths[NUM_PAIRS];
+    double m[NUM_PAIRS], var[NUM_PAIRS];
+
+    uint64_t total = stratified_rule_ctm((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, NUM_STRATA, pilot,
+                                         7, 1, 256, 0, weights, pilot_counts, min_depths, m, var);
+    assert(total == (uint64_t)NUM_STRATA * PILOT_PER_STRATUM);
+
+    double weight_sum = 0.0;
+    for (int h = 0; h < NUM_STRATA; ++h) {
+        int lo, hi;
+        stratum_density_range(NUM_STRATA, h, &lo, &hi);
+        double mass = 0.0;
+        for (int d = lo; d <= hi; ++d) {
+            mass += exp(lgamma(513.0) - lgamma(d + 1.0) - lgamma(513.0 - d) - 512 * log(2.0));
+        }
+        assert(fabs(weights[h] - mass) < 1e-9);
+        weight_sum += weights[h];
+    }
+    assert(fabs(weight_sum - 1.0) < 1e-12);
+    assert(weights[0] > 0.0 && weights[0] < 1e-3 && weights[NUM_STRATA - 1] < 1e-3);
+
+    // The tail bands are where the first two pairs are found.
+    assert(pilot_counts[0 * NUM_STRATA] > 10 * pilot_counts[0 * NUM_STRATA + NUM_STRATA - 1]);
+    assert(pilot_counts[1 * NUM_STRATA + NUM_STRATA - 1] > 10 * pilot_counts[1 * NUM_STRATA]);
+    assert(pilot_counts[2 * NUM_STRATA] > pilot_counts[2 * NUM_STRATA + NUM_STRATA - 1]);
+
+    // Neyman allocation for pair 0 from the (smoothed) pilot rates: n_h ∝ W_h · s_h,
+    // with a floor so no band goes unsampled.
+    int samples[NUM_STRATA];
+    double score[NUM_STRATA], score_sum = 0.0;
+    for (int h = 0; h < NUM_STRATA; ++h) {
+        double p = (pilot_counts[h] + 0.5) / (PILOT_PER_STRATUM + 1.0);
+        score[h] = weights[h] * sqrt(p * (1.0 - p));
+        score_sum += score[h];
+    }
+    int budget = 0;
+    for (int h = 0; h < NUM_STRATA; ++h) {
+        samples[h] = MIN_PER_STRATUM + (int)((NUM_RULES - NUM_STRATA * MIN_PER_STRATUM) * score[h] / score_sum);
+        budget += samples[h];
+    }
+
+    uint64_t counts[NUM_PAIRS * NUM_STRATA];
+    total = stratified_rule_ctm((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, NUM_STRATA, samples,
+                                8, 1, 256, 0, weights, counts, min_depths, m, var);
+    assert(total == (uint64_t)budget);
+
+    // The reweighted estimate must agree with plain uniform sampling.
+    int* match_rule_depths[NUM_PAIRS];
+    uint64_t** match_rule_numbers[NUM_PAIRS];
+    int match_counts[NUM_PAIRS];
+    simulate_rule_matches((uint32_t*)xs_flat, (uint32_t*)ys_flat, NUM_PAIRS, UNIFORM_RULES, 9, 1, 256,
+                          match_rule_numbers, match_rule_depths, match_counts);
+
+    for (int i = 0; i < NUM_PAIRS; ++i) {
+        double p = (double)match_counts[i] / UNIFORM_RULES;
+        double uniform_var = p * (1.0 - p) / UNIFORM_RULES;
+        double z = (m[i] - p) / sqrt(var[i] + uniform_var);
+        printf("Pair %d: stratified m = %.6f ± %.6f (%d rules), uniform m = %.6f ± %.6f (%d rules), min depth = %d\n",
+               i, m[i], sqrt(var[i]), budget, p, sqrt(uniform_var), UNIFORM_RULES, min_depths[i]);
+        assert(fabs(z) < 4.0 && "Stratified estimate disagrees with uniform sampling");
+        assert(min_depths[i] >= 1);
+    }
+    assert(fabs(m[2] - 0.5) < 4.0 * sqrt(var[2]));
+
+    // Precision of this allocation on pair 0, from the band rates of both runs pooled,
+    // against uniform sampling at the same budget.
+    double m0 = 0.0, stratified_var = 0.0;
+    for (int h = 0; h < NUM_STRATA; ++h) {
+        double p = (double)(pilot_counts[h] + counts[h]) / (PILOT_PER_STRATUM + samples[h]);
+        m0 += weights[h] * p;
+        stratified_var += weights[h] * weights[h] * p * (1.0 - p) / samples[h];
+    }
+    double ratio = stratified_var / (m0 * (1.0 - m0) / budget);
+    printf("Pair 0: variance %.3f of uniform sampling's at %d rules (estimated %.3f)\n",
+           ratio, budget, var[0] / (m[0] * (1.0 - m[0]) / budget));
+    assert(ratio < 0.95);
+
+    free_matches(NUM_PAIRS, match_counts, match_rule_depths, match_rule_numbers);
+    return 0;
+}
@@ -0,0 +1,293 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "ca_session.h"
+#include "simulate_rule_outputs.h"
+#include "bdm_scoring.h"
+#include "task_runner.h"
+
+#define NUM_TASKS 6
+#define NUM_TRAIN 3
+#define NUM_RULES 4000
+#define SEED 42
+#define TOP_K 3
+
+static void write_grid(FILE* f, uint16_t key) {
+    Matrix m;
+    hash_to_matrix(m, key);
+    fprintf(f, "[");
+    for (int r = 0; r < 4; ++r) {
+        fprintf(f, "%s[%d,%d,%d,%d]", r ? "," : "", m[r][0], m[r][1], m[r][2], m[r][3]);
+    }
+    fprintf(f, "]");
+}
+
+// Tasks generated by a bank rule, so abduction always finds at least that rule.
+static void write_task(const char* path, const CASession* bank, int rule_index, uint16_t* xs, uint16_t x_test) {
+    FILE* f = fopen(path, "w");
+    assert(f);
+    fprintf(f, "{\"metadata\": {\"transformation\": \"ca_rule\", \"note\": \"a \\\"quoted\\\" [value]\"},\n \"train\": [");
+    for (int i = 0; i < NUM_TRAIN; ++i) {
+        fprintf(f, "%s{\"input\": ", i ? ", " : "");
+        write_grid(f, xs[i]);
+        fprintf(f, ", \"output\": ");
+        write_grid(f, apply_rule_packed(xs[i], &bank->rules[rule_index], bank->boundary_mode));
+        fprintf(f, "}");
+    }
+    fprintf(f, "],\n \"test\": [{\"input\": ");
+    write_grid(f, x_test);
+    fprintf(f, ", \"output\": ");
+    write_grid(f, apply_rule_packed(x_test, &bank->rules[rule_index], bank->boundary_mode));
+    fprintf(f, "}]}\n");
+    fclose(f);
+}
+
+// Reference induction over rules[0..n) and selection as in Python.
+static int reference_prediction(CASession* bank, uint16_t x, const int* rules, int n,
+                                int* num_candidates, uint16_t* best, double* best_k) {
+    uint32_t x_test[16];
+    Matrix m;
+    hash_to_matrix(m, x);
+    for (int k = 0; k < 16; ++k) x_test[k] = m[k / 4][k % 4];
+
+    OutputMap* maps = NULL;
+    ca_session_outputs(bank, x_test, rules, n, &maps);
+
+    int* tally = calloc(65536, sizeof(int));
+    int* t_min = malloc(65536 * sizeof(int));
+    uint16_t* order = malloc(65536 * sizeof(uint16_t));
+    int num_seen = 0;
+    for (int j = 0; j < n; ++j) {
+        for (int o = 0; o < maps[j].num_outputs; ++o) {
+            uint16_t s = (uint16_t)matrix_hash(maps[j].outputs[o]);
+            if (tally[s]++ == 0) {
+                order[num_seen++] = s;
+                t_min[s] = maps[j].depths[o];
+            } else if (maps[j].depths[o] < t_min[s]) {
+                t_min[s] = maps[j].depths[o];
+            }
+        }
+    }
+    free_output_maps(n, maps);
+
+    int found = 0;
+    *best_k = INFINITY;
+    for (int j = 0; j < num_seen; ++j) {
+        uint16_t s = order[j];
+        if (t_min[s] <= 0) continue;
+        double k = -log2((double)tally[s] / NUM_RULES) + log2((double)t_min[s]);
+        if (!found || k < *best_k) {
+            *best = s;
+            *best_k = k;
+            found = 1;
+        }
+    }
+    free(order);
+    free(tally);
+    free(t_min);
+    *num_candidates = num_seen;
+    return found;
+}
+
+int main() {
+    char dir[] = "/tmp/test_task_runner_XXXXXX";
+    assert(mkdtemp(dir));
+
+    CASession* bank = ca_session_create(SEED, NUM_RULES, 1, 256, 1);
+
+    for (int t = 0; t < NUM_TASKS; ++t) {
+        uint16_t xs[NUM_TRAIN] = {0x0000, 0xFFFF, (uint16_t)((t % 2) ? (0x1234 ^ (t << 8)) : 0x8000)};
+        char path[512];
+        snprintf(path, sizeof(path), "%s/task_%04d.json", dir, t + 1);
+        write_task(path, bank, t * 101, xs, (uint16_t)(0xF00F ^ t));
+    }
+
+    // Parsing round-trips the grids.
+    RunnerTask tasks[NUM_TASKS];
+    for (int t = 0; t < NUM_TASKS; ++t) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/task_%04d.json", dir, t + 1);
+        assert(runner_load_task(path, &tasks[t]) == 0);
+        assert(tasks[t].num_train == NUM_TRAIN && tasks[t].num_test == 1 && tasks[t].has_test_outputs);
+        assert(tasks[t].train_inputs[1] == 0xFFFF);
+        assert(tasks[t].test_inputs[0] == (uint16_t)(0xF00F ^ t));
+    }
+
+    RunnerOptions options = {SEED, NUM_RULES, 1, 256, 0, NULL, 0};
+    TaskResult serial[NUM_TASKS], parallel[NUM_TASKS];
+    options.num_threads = 1;
+    runner_run_tasks(bank, tasks, NUM_TASKS, &options, NULL, serial);
+    options.num_threads = 3;
+    runner_run_tasks(bank, tasks, NUM_TASKS, &options, NULL, parallel);
+
+    // Fewer tasks than threads: tasks run in turn, abduction split over the bank's workers.
+    CASession* wide_bank = ca_session_create(SEED, NUM_RULES, 1, 256, 3);
+    TaskResult within[2];
+    runner_run_tasks(wide_bank, tasks, 2, &options, NULL, within);
+    for (int t = 0; t < 2; ++t) {
+        assert(within[t].num_abducted == serial[t].num_abducted);
+        assert(within[t].has_prediction[0] == serial[t].has_prediction[0]);
+        assert(!within[t].has_prediction[0] || (within[t].predictions[0] == serial[t].predictions[0] &&
+                                                 within[t].k_ctm[0] == serial[t].k_ctm[0]));
+        runner_free_result(&within[t]);
+    }
+    ca_session_destroy(wide_bank);
+    printf("Within-task abduction agrees with the task-parallel run.\n");
+
+    // Ranking against a table file: keep the TOP_K lowest-BDM abducted rules.
+    static double bdm_table[BDM_TABLE_SIZE], loaded_table[BDM_TABLE_SIZE];
+    for (int v = 0; v < BDM_TABLE_SIZE; ++v) bdm_table[v] = 1.0 + __builtin_popcount(v) + (v % 7) * 0.25;
+    char table_path[512];
+    snprintf(table_path, sizeof(table_path), "%s/bdm_table.bin", dir);
+    assert(bdm_save_ctm_table(table_path, bdm_table) == 0);
+    assert(bdm_load_ctm_table(table_path, loaded_table) == 0);
+
+    TaskResult ranked[NUM_TASKS];
+    options.top_k = TOP_K;
+    runner_run_tasks(bank, tasks, NUM_TASKS, &options, loaded_table, ranked);
+    options.top_k = 0;
+    int pruned = 0;
+
+    for (int t = 0; t < NUM_TASKS; ++t) {
+        const RunnerTask* task = &tasks[t];
+        TaskResult* r = &serial[t];
+
+        // Thread count does not change the result.
+        assert(r->num_abducted == parallel[t].num_abducted);
+        assert(r->has_prediction[0] == parallel[t].has_prediction[0]);
+        assert(!r->has_prediction[0] || (r->predictions[0] == parallel[t].predictions[0] && r->k_ctm[0] == parallel[t].k_ctm[0]));
+
+        // Reference pipeline: full sweeps through the session, then selection as in Python.
+        uint32_t xs_flat[NUM_TRAIN * 16], ys_flat[NUM_TRAIN * 16];
+        for (int i = 0; i < NUM_TRAIN; ++i) {
+            Matrix m;
+            hash_to_matrix(m, task->train_inputs[i]);
+            for (int k = 0; k < 16; ++k) xs_flat[i * 16 + k] = m[k / 4][k % 4];
+            hash_to_matrix(m, task->train_outputs[i]);
+            for (int k = 0; k < 16; ++k) ys_flat[i * 16 + k] = m[k / 4][k % 4];
+        }
+        int* indices[NUM_TRAIN];
+        int* depths[NUM_TRAIN];
+        int counts[NUM_TRAIN];
+        ca_session_matches(bank, xs_flat, ys_flat, NUM_TRAIN, indices, depths, counts);
+
+        int common[NUM_RULES];
+        int num_common = 0;
+        for (int j = 0; j < counts[0]; ++j) {
+            int in_all = 1;
+            for (int i = 1; i < NUM_TRAIN && in_all; ++i) {
+                in_all = 0;
+                for (int k = 0; k < counts[i]; ++k) in_all |= (indices[i][k] == indices[0][j]);
+            }
+            if (in_all) common[num_common++] = indices[0][j];
+        }
+        ca_session_free_matches(NUM_TRAIN, indices, depths);
+        assert(num_common == r->num_abducted && num_common >= 1);
+
+        // Reference ranking: score the abducted rules, keep the best TOP_K in score order.
+        uint64_t* rules_flat = malloc((size_t)num_common * 8 * sizeof(uint64_t));
+        double* scores = malloc(num_common * sizeof(double));
+        int* order = malloc(num_common * sizeof(int));
+        for (int j = 0; j < num_common; ++j) {
+            memcpy(&rules_flat[j * 8], &bank->rule_numbers[(size_t)common[j] * 8], 8 * sizeof(uint64_t));
+        }
+        bdm_score_rules(rules_flat, num_common, bdm_table, 1, scores);
+        int kept = bdm_top_k(scores, num_common, TOP_K, order);
+        int best_rules[TOP_K];
+        for (int j = 0; j < kept; ++j) best_rules[j] = common[order[j]];
+        free(order);
+        free(scores);
+        free(rules_flat);
+
+        int ranked_seen;
+        uint16_t ranked_best = 0;
+        double ranked_k;
+        int ranked_found = reference_prediction(bank, task->test_inputs[0], best_rules, kept,
+                                                &ranked_seen, &ranked_best, &ranked_k);
+        assert(ranked[t].num_abducted == num_common && ranked[t].num_ranked == kept);
+        assert(ranked[t].num_candidates[0] == ranked_seen && ranked[t].has_prediction[0] == ranked_found);
+        assert(!ranked_found || (ranked[t].predictions[0] == ranked_best && fabs(ranked[t].k_ctm[0] - ranked_k) < 1e-12));
+        pruned += kept < num_common;
+        runner_free_result(&ranked[t]);
+
+        int num_seen;
+        uint16_t best = 0;
+        double best_k;
+        int found = reference_prediction(bank, task->test_inputs[0], common, num_common, &num_seen, &best, &best_k);
+
+        assert(r->num_candidates[0] == num_seen);
+        assert(r->has_prediction[0] == found);
+        assert(!found || (r->predictions[0] == best && fabs(r->k_ctm[0] - best_k) < 1e-12));
+        printf("Task %d: %d abducted rules, %d candidates, k_ctm = %.3f, correct = %d\n",
+               t + 1, r->num_abducted, r->num_candidates[0], r->k_ctm[0], r->correct[0]);
+
+        runner_free_result(&serial[t]);
+        runner_free_result(&parallel[t]);
+        runner_free_task(&tasks[t]);
+    }
+    assert(pruned > 0);
+    printf("Ranking with top_k = %d matches bdm_score_rules + bdm_top_k (%d tasks pruned).\n", TOP_K, pruned);
+
+    // Truncated text, a directory and a missing file are rejected without reading past the end.
+    char bad[512];
+    snprintf(bad, sizeof(bad), "%s/truncated.txt", dir);
+    FILE* g = fopen(bad, "w");
+    assert(g);
+    fprintf(g, "{\"train\": [{\"input\": [[0,0,0,1");
+    fclose(g);
+    RunnerTask rejected;
+    assert(runner_load_task(bad, &rejected) == -1);
+    assert(runner_load_task(dir, &rejected) == -1);
+    remove(bad);
+    snprintf(bad, sizeof(bad), "%s/missing.json", dir);
+    assert(runner_load_task(bad, &rejected) == -1);
+
+    // Task names are file names, which JSON output must escape.
+    char quoted[512];
+    snprintf(quoted, sizeof(quoted), "%s/task_\"q\\.json", dir);
+    uint16_t quoted_xs[NUM_TRAIN] = {0x0000, 0xFFFF, 0x8000};
+    write_task(quoted, bank, 7, quoted_xs, 0x0F0F);
+    ca_session_destroy(bank);
+
+    // Directory runner writes one entry per task.
+    char output[512];
+    snprintf(output, sizeof(output), "%s/predictions.out", dir);
+    options.num_threads = 0;
+    assert(runner_run_directory(dir, &options, output) == NUM_TASKS + 1);
+
+    FILE* f = fopen(output, "r");
+    assert(f);
+    char line[4096];
+    int entries = 0, escaped = 0;
+    while (fgets(line, sizeof(line), f)) {
+        entries += strstr(line, "\"task\": ") != NULL;
+        escaped += strstr(line, "\"task\": \"task_\\\"q\\\\.json\"") != NULL;
+    }
+    fclose(f);
+    assert(entries == NUM_TASKS + 1 && escaped == 1);
+    printf("Directory run wrote %d task entries.\n", entries);
+
+    // Ranking needs its table.
+    options.top_k = TOP_K;
+    assert(runner_run_directory(dir, &options, output) == -1);
+    options.bdm_table_path = table_path;
+    assert(runner_run_directory(dir, &options, output) == NUM_TASKS + 1);
+
+    for (int t = 0; t < NUM_TASKS; ++t) {
+        char path[512];
+        snprintf(path, sizeof(path), "%s/task_%04d.json", dir, t + 1);
+        remove(path);
+    }
+    remove(quoted);
+    remove(output);
+    remove(table_path);
+    rmdir(dir);
+    return 0;
+}
@@ -0,0 +1,143 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <assert.h>
+
+#include "matrix_utils.h"
+#include "ca_dynamics.h"
+#include "ca_session.h"
+#include "trajectory_cycles.h"
+
+#define NUM_RULES 2000
+#define NUM_TS 7
+#define NUM_YS 6
+#define SEED 42
+#define NUM_STATES (1 << 16)
+
+static void hash_to_flat(uint16_t state, uint32_t* flat) {
+    for (int k = 0; k < 16; ++k) flat[k] = (state >> (15 - k)) & 1;
+}
+
+int main() {
+    uint32_t x_flat[16] = {
+        0,0,0,1,
+        0,1,0,0,
+        0,0,1,0,
+        1,0,0,0
+    };
+    Matrix x;
+    flat_to_matrix(x, x_flat);
+    uint16_t x_key = (uint16_t)matrix_hash(x);
+
+    // A small max_steps must not truncate the compressed orbits.
+    CASession* session = ca_session_create(SEED, NUM_RULES, 1, 8, 2);
+    SimScratch* scratch = sim_scratch_create();
+
+    Trajectories* tr = trajectories_build(session, x_flat, NULL, 0);
+    assert(tr && tr->num_rules == NUM_RULES);
+
+    uint16_t* orbit = malloc(NUM_STATES * sizeof(uint16_t));
+    int max_transient = 0, max_period = 0;
+    for (int r = 0; r < NUM_RULES; ++r) {
+        const Rule512* rule = &session->rules[r];
+        int n = simulate_packed_trajectory(x_key, rule, 1, NUM_STATES, scratch, orbit);
+        assert((uint64_t)n == tr->offsets[r + 1] - tr->offsets[r]);
+        assert(tr->transients[r] + tr->periods[r] == n && tr->periods[r] >= 1);
+        assert(memcmp(orbit, tr->states + tr->offsets[r], n * sizeof(uint16_t)) == 0);
+
+        // One period after the last stored state the orbit is back at the cycle entry.
+        assert(apply_rule_packed(orbit[n - 1], rule, 1) == orbit[tr->transients[r]]);
+
+        if (tr->transients[r] > max_transient) max_transient = tr->transients[r];
+        if (tr->periods[r] > max_period) max_period = tr->periods[r];
+    }
+    printf("Orbits: longest transient %d, longest period %d.\n", max_transient, max_period);
+
+    // State at step t against direct iteration, and far beyond via the period.
+    uint64_t ts[NUM_TS] = {0, 1, 2, 7, 100, 1000, 1ULL << 40};
+    uint16_t* states = malloc((size_t)NUM_RULES * NUM_TS * sizeof(uint16_t));
+    trajectories_state_at(tr, ts, NUM_TS, states);
+
+    uint64_t far[1] = {(1ULL << 40) + 12345};
+    uint16_t* far_states = malloc(NUM_RULES * sizeof(uint16_t));
+    trajectories_state_at(tr, far, 1, far_states);
+
+    for (int r = 0; r < NUM_RULES; ++r) {
+        const Rule512* rule = &session->rules[r];
+        uint16_t state = x_key;
+        for (uint64_t t = 0, k = 0; k < NUM_TS - 1; ++t) {
+            if (t == ts[k]) assert(states[(size_t)r * NUM_TS + k++] == state);
+            state = apply_rule_packed(state, rule, 1);
+        }
+
+        // 12345 steps after step 2^40 (which is on the cycle) is the same as iterating from there.
+        state = states[(size_t)r * NUM_TS + NUM_TS - 1];
+        for (int t = 0; t < 12345 % tr->periods[r]; ++t) state = apply_rule_packed(state, rule, 1);
+        assert(far_states[r] == state);
+    }
+    printf("State-at queries agree with step-by-step simulation.\n");
+
+    // First hits and cycle membership: the start, states from a few orbits,
+    // an arbitrary state and a duplicate target.
+    uint16_t targets[NUM_YS] = {
+        x_key,
+        tr->states[tr->offsets[0] + tr->transients[0]],
+        tr->states[tr->offsets[1] - 1],
+        tr->states[tr->offsets[7] + (tr->offsets[8] - tr->offsets[7]) / 2],
+        0x8421,
+        x_key
+    };
+    uint32_t ys_flat[NUM_YS][16];
+    for (int j = 0; j < NUM_YS; ++j) hash_to_flat(targets[j], ys_flat[j]);
+
+    int32_t* depths = malloc((size_t)NUM_RULES * NUM_YS * sizeof(int32_t));
+    uint8_t* on_cycle = malloc((size_t)NUM_RULES * NUM_YS);
+    trajectories_find(tr, (uint32_t*)ys_flat, NUM_YS, depths, on_cycle);
+
+    int hits = 0, cyclic = 0;
+    for (int r = 0; r < NUM_RULES; ++r) {
+        const Rule512* rule = &session->rules[r];
+        for (int j = 0; j < NUM_YS; ++j) {
+            size_t k = (size_t)r * NUM_YS + j;
+            assert(depths[k] == simulate_packed_with_depth(x_key, targets[j], rule, 1, NUM_STATES, scratch));
+
+            // y is on the cycle iff it is reached and returns to itself.
+            uint16_t next = apply_rule_packed(targets[j], rule, 1);
+            int returns = simulate_packed_with_depth(next, targets[j], rule, 1, NUM_STATES, scratch) >= 0;
+            assert(on_cycle[k] == (depths[k] >= 0 && returns));
+
+            hits += depths[k] >= 0;
+            cyclic += on_cycle[k];
+        }
+    }
+    assert(depths[0] == 0 && on_cycle[1]);
+    printf("First hits and cycle membership agree with simulation (%d hits, %d on cycles).\n", hits, cyclic);
+
+    // Explicit rules give the same orbits as their bank indices.
+    int picks[3] = {5, 0, 1999};
+    Trajectories* picked = trajectories_build(session, x_flat, picks, 3);
+    Trajectories* by_number = trajectories_build_for_rules(session, x_flat, &session->rule_numbers[5 * 8], 1);
+    assert(picked->num_rules == 3 && by_number->num_rules == 1);
+    for (int i = 0; i < 3; ++i) {
+        int r = picks[i];
+        assert(picked->transients[i] == tr->transients[r] && picked->periods[i] == tr->periods[r]);
+        assert(memcmp(picked->states + picked->offsets[i], tr->states + tr->offsets[r],
+                      (tr->offsets[r + 1] - tr->offsets[r]) * sizeof(uint16_t)) == 0);
+    }
+    assert(by_number->offsets[1] == tr->offsets[6] - tr->offsets[5]);
+    assert(memcmp(by_number->states, tr->states + tr->offsets[5], by_number->offsets[1] * sizeof(uint16_t)) == 0);
+    printf("Bank indices and explicit rules build the same orbits.\n");
+
+    trajectories_free(by_number);
+    trajectories_free(picked);
+    free(on_cycle);
+    free(depths);
+    free(far_states);
+    free(states);
+    free(orbit);
+    trajectories_free(tr);
+    sim_scratch_free(scratch);
+    ca_session_destroy(session);
+    return 0;
+}
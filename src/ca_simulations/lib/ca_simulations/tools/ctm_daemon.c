@@ -0,0 +1,107 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <signal.h>
+#include <unistd.h>
+#include <getopt.h>
+
+#include "ctm_server.h"
+
+static volatile sig_atomic_t stop_requested = 0;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop_requested = 1;
+}
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s --socket PATH [options]\n"
+            "\n"
+            "Serve conditional-CTM queries (ctm_client_query) from a warm rule bank,\n"
+            "coalescing queries that arrive close together into shared rule sweeps.\n"
+            "\n"
+            "  --num-rules N        rules in the bank (default 1000000)\n"
+            "  --seed S             rule bank seed (default 42)\n"
+            "  --boundary-mode B    1 = toroidal, 0 = zero-padded (default 1)\n"
+            "  --max-steps M        maximum simulation steps (default 65536)\n"
+            "  --threads T          sweep threads (default: all online cores)\n"
+            "  --window-us U        batching latency budget in microseconds (default 2000)\n"
+            "  --max-batch-pairs P  start a sweep early at P queued pairs (default: no limit)\n"
+            "  --metrics-every S    print metrics every S seconds (default 10, 0 = never)\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    const char* socket_path = NULL;
+    unsigned int seed = 42;
+    int num_rules = 1000000, boundary_mode = 1, max_steps = 65536, num_threads = 0;
+    int window_us = 2000, max_batch_pairs = 0, metrics_every = 10;
+
+    static const struct option long_options[] = {
+        {"socket", required_argument, NULL, 'S'},
+        {"num-rules", required_argument, NULL, 'n'},
+        {"seed", required_argument, NULL, 's'},
+        {"boundary-mode", required_argument, NULL, 'b'},
+        {"max-steps", required_argument, NULL, 'm'},
+        {"threads", required_argument, NULL, 'j'},
+        {"window-us", required_argument, NULL, 'w'},
+        {"max-batch-pairs", required_argument, NULL, 'p'},
+        {"metrics-every", required_argument, NULL, 'e'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "S:n:s:b:m:j:w:p:e:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'S': socket_path = optarg; break;
+            case 'n': num_rules = atoi(optarg); break;
+            case 's': seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'b': boundary_mode = atoi(optarg); break;
+            case 'm': max_steps = atoi(optarg); break;
+            case 'j': num_threads = atoi(optarg); break;
+            case 'w': window_us = atoi(optarg); break;
+            case 'p': max_batch_pairs = atoi(optarg); break;
+            case 'e': metrics_every = atoi(optarg); break;
+            case 'h': usage(argv[0]); return EXIT_SUCCESS;
+            default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (!socket_path || num_rules <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    CTMServer* server = ctm_server_create(seed, num_rules, boundary_mode, max_steps, num_threads, window_us, max_batch_pairs);
+
+    // Replaces the session's SIGINT handler: here SIGINT means shut down, not abort the sweep.
+    signal(SIGINT, on_signal);
+    signal(SIGTERM, on_signal);
+    // Writes to clients that hung up fail with EPIPE and drop the connection.
+    signal(SIGPIPE, SIG_IGN);
+
+    if (ctm_server_listen(server, socket_path) != 0) {
+        fprintf(stderr, "Cannot listen on %s.\n", socket_path);
+        ctm_server_destroy(server);
+        return EXIT_FAILURE;
+    }
+    fprintf(stderr, "Serving %d rules (seed %u) on %s\n", num_rules, seed, socket_path);
+
+    int seconds = 0;
+    while (!stop_requested) {
+        sleep(1);
+        if (metrics_every > 0 && ++seconds % metrics_every == 0) {
+            CTMServerMetrics m;
+            ctm_server_metrics(server, &m);
+            fprintf(stderr, "queries=%llu pairs=%llu batches=%llu queue_depth=%d max_queue_depth=%d "
+                            "mean_batch_pairs=%.1f max_batch_pairs=%d max_batch_queries=%d sweep_seconds=%.3f\n",
+                    (unsigned long long)m.queries, (unsigned long long)m.pairs, (unsigned long long)m.batches,
+                    m.queue_depth, m.max_queue_depth, m.mean_batch_pairs, m.max_batch_pairs,
+                    m.max_batch_queries, m.sweep_seconds);
+        }
+    }
+
+    ctm_server_destroy(server);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,70 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <getopt.h>
+
+#include "task_runner.h"
+
+static void usage(const char* prog) {
+    fprintf(stderr,
+            "Usage: %s --tasks DIR --output FILE [options]\n"
+            "\n"
+            "Run abduction, optional BDM ranking, induction and k_ctm selection over every\n"
+            "*.json task in DIR and write predictions and per-stage timings to FILE.\n"
+            "\n"
+            "  --num-rules N       rules in the shared bank (default 1000000)\n"
+            "  --seed S            rule bank seed (default 42)\n"
+            "  --boundary-mode B   1 = toroidal, 0 = zero-padded (default 1)\n"
+            "  --max-steps M       maximum simulation steps (default 65536)\n"
+            "  --top-k K           keep the K lowest-BDM rules for induction (default: all)\n"
+            "  --bdm-table FILE    CTM table for ranking (build/bdm_ctm_d12.bin)\n"
+            "  --threads T         worker threads (default: all online cores)\n",
+            prog);
+}
+
+int main(int argc, char** argv) {
+    const char* task_dir = NULL;
+    const char* output_path = NULL;
+    RunnerOptions options = {42, 1000000, 1, 65536, 0, NULL, 0};
+
+    static const struct option long_options[] = {
+        {"tasks", required_argument, NULL, 'd'},
+        {"output", required_argument, NULL, 'o'},
+        {"num-rules", required_argument, NULL, 'n'},
+        {"seed", required_argument, NULL, 's'},
+        {"boundary-mode", required_argument, NULL, 'b'},
+        {"max-steps", required_argument, NULL, 'm'},
+        {"top-k", required_argument, NULL, 'k'},
+        {"bdm-table", required_argument, NULL, 't'},
+        {"threads", required_argument, NULL, 'j'},
+        {"help", no_argument, NULL, 'h'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int opt;
+    while ((opt = getopt_long(argc, argv, "d:o:n:s:b:m:k:t:j:h", long_options, NULL)) != -1) {
+        switch (opt) {
+            case 'd': task_dir = optarg; break;
+            case 'o': output_path = optarg; break;
+            case 'n': options.num_rules = atoi(optarg); break;
+            case 's': options.seed = (unsigned int)strtoul(optarg, NULL, 10); break;
+            case 'b': options.boundary_mode = atoi(optarg); break;
+            case 'm': options.max_steps = atoi(optarg); break;
+            case 'k': options.top_k = atoi(optarg); break;
+            case 't': options.bdm_table_path = optarg; break;
+            case 'j': options.num_threads = atoi(optarg); break;
+            case 'h': usage(argv[0]); return EXIT_SUCCESS;
+            default: usage(argv[0]); return EXIT_FAILURE;
+        }
+    }
+
+    if (!task_dir || !output_path || options.num_rules <= 0) {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    int num_tasks = runner_run_directory(task_dir, &options, output_path);
+    if (num_tasks < 0) return EXIT_FAILURE;
+
+    printf("Ran %d tasks; results written to %s\n", num_tasks, output_path);
+    return EXIT_SUCCESS;
+}
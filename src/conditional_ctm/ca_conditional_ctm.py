@@ -1,12 +1,46 @@
 import math
-from ca_simulations import simulate_rule_matches
+from ca_simulations import CASession
+from ca_simulations import simulate_kstate_matches
+from ca_simulations import enumerate_rule_matches
+from ca_simulations import stratified_rule_ctm
+from ca_simulations import preimage_ctm
 
 class CAConditionalCTM:
-    def __init__(self, num_rules=1_000_000, seed=42, boundary_mode=1, max_steps=65536):
+    def __init__(self, num_rules=1_000_000, seed=42, boundary_mode=1, max_steps=65536,
+                 num_colors=2, family='outer_totalistic', exhaustive=False, stratified=False,
+                 num_strata=16):
+        """
+        Parameters:
+            num_colors (int): 2 uses the full 512-bit binary rule space; 3..10 samples
+                              k-state rules from `family` ('totalistic' or 'outer_totalistic')
+            exhaustive (bool): for binary tasks, enumerate every rule of `family` instead of
+                               sampling num_rules from the full space (exact, noise-free m)
+            stratified (bool): for binary tasks, spread num_rules over num_strata fixed rule-density
+                               bands (Neyman allocation) and reweight; adds 'variance' to each
+                               result and reports no individual matches
+        """
         self.num_rules = num_rules
         self.seed = seed
         self.boundary_mode = boundary_mode
         self.max_steps = max_steps
+        self.num_colors = num_colors
+        self.family = family
+        self.exhaustive = exhaustive
+        self.stratified = stratified
+        self.num_strata = num_strata
+        self._session = None
+
+    @property
+    def session(self):
+        # Binary sampling reuses one warm rule bank across compute() calls.
+        if self._session is None:
+            self._session = CASession(
+                num_rules=self.num_rules,
+                seed=self.seed,
+                boundary_mode=self.boundary_mode,
+                max_steps=self.max_steps
+            )
+        return self._session
 
     def compute(self, xs, ys):
         """
@@ -17,19 +51,37 @@ class CAConditionalCTM:
         Returns:
             List[Dict]: Each dict contains 'match_count', 'm', 'ctm', 'min_depth'
         """
-        match_data = simulate_rule_matches(
-            xs=xs,
-            ys=ys,
-            num_rules=self.num_rules,
-            seed=self.seed,
-            boundary_mode=self.boundary_mode,
-            max_steps=self.max_steps
-        )
+        total_rules = self.num_rules
+
+        if self.num_colors == 2 and self.stratified and not self.exhaustive:
+            return self._compute_stratified(xs, ys)
+
+        if self.num_colors > 2:
+            match_data = simulate_kstate_matches(
+                xs=xs,
+                ys=ys,
+                num_colors=self.num_colors,
+                family=self.family,
+                num_rules=self.num_rules,
+                seed=self.seed,
+                boundary_mode=self.boundary_mode,
+                max_steps=self.max_steps
+            )
+        elif self.exhaustive:
+            match_data, total_rules = enumerate_rule_matches(
+                xs=xs,
+                ys=ys,
+                family=self.family,
+                boundary_mode=self.boundary_mode,
+                max_steps=self.max_steps
+            )
+        else:
+            match_data = self.session.matches(xs, ys)
 
         results = []
         for matches in match_data:
             count = len(matches)
-            m = count / self.num_rules
+            m = count / total_rules
             ctm = -math.log2(m) if m > 0 else float("inf")
             min_depth = min((depth for _, depth in matches), default=None)
 
@@ -42,3 +94,57 @@ class CAConditionalCTM:
             })
 
         return results
+
+    def compute_column(self, y):
+        """
+        Conditional CTM of a fixed target y given every possible binary input x, from
+        one backward pass per rule instead of 65536 forward queries (binary rules only).
+
+        Returns:
+            dict of length-65536 arrays 'match_count', 'm', 'ctm', 'min_depth' (-1 if
+            never reached), indexed by the input's matrix hash; decode with
+            states_to_matrices.
+        """
+        assert self.num_colors == 2 and not self.exhaustive and not self.stratified, \
+            "compute_column samples the full binary rule space"
+
+        column = preimage_ctm(
+            y=y,
+            num_rules=self.num_rules,
+            seed=self.seed,
+            boundary_mode=self.boundary_mode,
+            max_steps=self.max_steps
+        )
+        return {
+            "match_count": column['match_counts'],
+            "m": column['m'],
+            "ctm": column['ctm'],
+            "min_depth": column['min_depths']
+        }
+
+    def _compute_stratified(self, xs, ys):
+        estimate = stratified_rule_ctm(
+            xs=xs,
+            ys=ys,
+            num_rules=self.num_rules,
+            num_strata=self.num_strata,
+            seed=self.seed,
+            boundary_mode=self.boundary_mode,
+            max_steps=self.max_steps
+        )
+
+        results = []
+        for i in range(len(xs)):
+            m = float(estimate['m'][i])
+            min_depth = int(estimate['min_depths'][i])
+
+            results.append({
+                "match_count": int(estimate['stratum_counts'][i].sum()),
+                "m": m,
+                "ctm": -math.log2(m) if m > 0 else float("inf"),
+                "variance": float(estimate['variance'][i]),
+                "min_depth": min_depth if min_depth >= 0 else None,
+                "matches": None
+            })
+
+        return results